@@ -0,0 +1,320 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+/// @class atomic_spsc_byte_queue
+/// @brief A single-producer, single-consumer (SPSC) bounded queue of variable-length byte records.
+///
+/// @details
+/// Byte ring using the same atomic head_/tail_ scheme as atomic_spsc_queue, but
+/// head_ and tail_ count bytes instead of slots, so each record only takes as much
+/// space as its payload needs.
+///
+/// - Every record starts with an 8-byte header holding the payload length, followed by
+///   the payload padded up to a multiple of 8 bytes, so every header is 8-byte aligned.
+/// - A record never wraps around the end of the ring. If it does not fit into the bytes
+///   left before the end, the producer writes a skip header there and places the record
+///   at the start of the ring. The consumer jumps over skip headers.
+/// - The ring size is rounded up to a power of two, so offsets are computed with a mask.
+/// - Records with payloads up to max_record_size() (half the ring minus the header) always
+///   fit once the queue drains; larger records are rejected with std::invalid_argument.
+///
+/// - Producer API: reserve(n) returns a writable span for an n-byte payload, commit(k)
+///   publishes it with its final length k <= n. try_push()/push() copy a whole record.
+/// - Consumer API: readable() returns the payload of the oldest record, release() frees it.
+///   try_consume()/consume() invoke a callback on the payload in place.
+///
+/// Like atomic_spsc_queue, each side keeps a cached copy of the other side's index and
+/// reloads it only when the cached copy says full/empty.
+///
+/// - Memory ordering:
+///   * Relaxed for loading indices in the thread that modifies them.
+///   * Release-acquire for all other cases:
+///     - closed_ is released by close() and acquired in reserve()/done().
+///     - tail_ is released by commit() and acquired in readable().
+///     - head_ is released by release() and acquired in reserve().
+///
+/// close()/done() have the same semantics as in atomic_spsc_queue: close() stops the producer,
+/// done() reports closed and drained. Blocking operations spin with periodic yield().
+///
+/// @note The queue is non-copyable and non-movable. The queue must outlive
+/// all threads accessing it. Users are responsible for stopping and joining
+/// producer and consumer threads before destroying the queue.
+///
+/// @warning This queue is NOT thread-safe for multiple producers or consumers.
+
+class atomic_spsc_byte_queue
+{
+public:
+    atomic_spsc_byte_queue(std::size_t capacity)
+    {
+        if (capacity == 0 || capacity > (std::numeric_limits<std::size_t>::max() / 2 + 1))
+        {
+            throw std::invalid_argument("Invalid capacity: " + std::to_string(capacity));
+        }
+        capacity_ = std::bit_ceil(std::max(capacity, min_capacity_));
+        mask_ = capacity_ - 1;
+        // Not value-initialized, so creating the queue does not touch the ring pages.
+        words_ = std::make_unique_for_overwrite<std::uint64_t[]>(capacity_ / header_size_);
+    }
+
+    // Producer-side zero-copy write. Returns a span for an n-byte payload, or an empty span
+    // if the record does not fit right now or queue is closed. Write into the span, then
+    // publish with commit(). Throws std::invalid_argument if n exceeds max_record_size().
+    std::span<std::byte> reserve(std::size_t n)
+    {
+        if (n > max_record_size())
+        {
+            throw std::invalid_argument("Record too large: " + std::to_string(n));
+        }
+        if (closed_.load(std::memory_order_acquire))
+        {
+            return {};
+        }
+        const std::uint64_t t = tail_.load(std::memory_order_relaxed);
+        const std::size_t offset = static_cast<std::size_t>(t) & mask_;
+        const std::size_t to_end = capacity_ - offset;
+        const std::size_t need = record_size(n);
+
+        // If the record does not fit before the end of the ring, the rest of the ring is skipped.
+        const std::size_t skip = need > to_end ? to_end : 0;
+
+        // Refresh the cached head only when it says there is not enough space.
+        if (capacity_ - static_cast<std::size_t>(t - head_cache_) < skip + need)
+        {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (capacity_ - static_cast<std::size_t>(t - head_cache_) < skip + need)
+            {
+                return {};
+            }
+        }
+
+        if (skip != 0)
+        {
+            header(t) = skip_marker_;
+        }
+        reserved_ = t + skip;
+        return {payload(reserved_), n};
+    }
+
+    // Publishes the record returned by the last successful reserve() with a payload of k bytes.
+    // k must not exceed the size of the reserved span.
+    void commit(std::size_t k)
+    {
+        header(reserved_) = k;
+        tail_.store(reserved_ + record_size(k), std::memory_order_release);
+    }
+
+    // Non-blocking push of a copy of record. Returns false if it does not fit right now or queue is closed.
+    bool try_push(std::span<const std::byte> record)
+    {
+        std::span<std::byte> out = reserve(record.size());
+        if (out.data() == nullptr)
+        {
+            return false;
+        }
+
+        std::memcpy(out.data(), record.data(), record.size());
+        commit(record.size());
+        return true;
+    }
+
+    // Blocking push. Returns false if queue gets closed while waiting.
+    bool push(std::span<const std::byte> record)
+    {
+        std::size_t spin = 0;
+
+        while (!closed())
+        {
+            if (try_push(record))
+            {
+                return true;
+            }
+
+            if (++spin >= yield_after_)
+            {
+                std::this_thread::yield();
+                spin = 0;
+            }
+        }
+
+        return false;
+    }
+
+    // Consumer-side zero-copy read. Returns the payload of the oldest record, or an empty span
+    // with a null data() if queue is empty. The span stays valid until release().
+    std::span<const std::byte> readable()
+    {
+        std::uint64_t h = head_.load(std::memory_order_relaxed);
+
+        // Empty if head catches tail. Refresh the cached tail only when it says empty.
+        if (h == tail_cache_)
+        {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (h == tail_cache_)
+            {
+                return {};
+            }
+        }
+
+        // A skip header is always published together with the record after it.
+        if (header(h) == skip_marker_)
+        {
+            h += capacity_ - (static_cast<std::size_t>(h) & mask_);
+        }
+
+        const std::size_t n = static_cast<std::size_t>(header(h));
+        next_head_ = h + record_size(n);
+        return {payload(h), n};
+    }
+
+    // Frees the record returned by the last readable() that returned a non-null span.
+    void release()
+    {
+        head_.store(next_head_, std::memory_order_release);
+    }
+
+    // Non-blocking in-place consume. Invokes f on the payload of the oldest record, then frees it.
+    // Returns false (without invoking f) if queue is empty. If f throws, the record stays in the queue.
+    template <typename F>
+        requires std::invocable<F, std::span<const std::byte>>
+    bool try_consume(F &&f)
+    {
+        std::span<const std::byte> record = readable();
+        if (record.data() == nullptr)
+        {
+            return false;
+        }
+
+        std::invoke(std::forward<F>(f), record);
+        release();
+        return true;
+    }
+
+    // Blocking in-place consume. Returns false if queue is closed and empty.
+    template <typename F>
+        requires std::invocable<F, std::span<const std::byte>>
+    bool consume(F &&f)
+    {
+        for (std::size_t spin = 0;;)
+        {
+            if (try_consume(f))
+            {
+                return true;
+            }
+
+            if (done())
+            {
+                return false;
+            }
+
+            if (++spin >= yield_after_)
+            {
+                std::this_thread::yield();
+                spin = 0;
+            }
+        }
+    }
+
+    // Ring size in bytes, headers and padding included.
+    std::size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    // Largest payload that is guaranteed to fit once the queue drains.
+    std::size_t max_record_size() const
+    {
+        return capacity_ / 2 - header_size_;
+    }
+
+    bool closed() const
+    {
+        return closed_.load(std::memory_order_acquire);
+    }
+
+    // True only when producer has called close() and all queued records are drained.
+    bool done() const
+    {
+        if (!closed_.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        const std::uint64_t h = head_.load(std::memory_order_relaxed);
+        return h == tail_.load(std::memory_order_acquire);
+    }
+
+    void close()
+    {
+        // Blocked operations poll this flag and exit.
+        closed_.store(true, std::memory_order_release);
+    }
+
+    // Destructor calling close() is only a best-effort wakeup.
+    // The queue must outlive all threads that may access it.
+    // Users must stop/join producer & consumer before destroying the queue.
+    ~atomic_spsc_byte_queue()
+    {
+        close();
+    }
+
+    // Let's not allow copying or moving the queue
+    atomic_spsc_byte_queue(const atomic_spsc_byte_queue &) = delete;
+    atomic_spsc_byte_queue &operator=(const atomic_spsc_byte_queue &) = delete;
+    atomic_spsc_byte_queue(atomic_spsc_byte_queue &&) = delete;
+    atomic_spsc_byte_queue &operator=(atomic_spsc_byte_queue &&) = delete;
+
+private:
+    static constexpr std::size_t header_size_ = sizeof(std::uint64_t);
+    static constexpr std::size_t min_capacity_ = 4 * header_size_;
+    static constexpr std::uint64_t skip_marker_ = std::numeric_limits<std::uint64_t>::max();
+
+    // Header plus payload rounded up to the header alignment.
+    static constexpr std::size_t record_size(std::size_t n)
+    {
+        return header_size_ + ((n + header_size_ - 1) & ~(header_size_ - 1));
+    }
+
+    std::uint64_t &header(std::uint64_t position)
+    {
+        return words_[(static_cast<std::size_t>(position) & mask_) / header_size_];
+    }
+
+    std::byte *payload(std::uint64_t position)
+    {
+        return reinterpret_cast<std::byte *>(&header(position) + 1);
+    }
+
+    std::size_t capacity_ = 0;
+    std::size_t mask_ = 0;
+    std::unique_ptr<std::uint64_t[]> words_;
+    static constexpr std::size_t yield_after_ = 1024;
+    static constexpr std::size_t cacheline_size = 64;
+    // Consumer-owned line: head_, the consumer's cached copy of tail_ and the end of the record being read.
+    alignas(cacheline_size)
+        std::atomic<std::uint64_t> head_ = 0;
+    std::uint64_t tail_cache_ = 0;
+    std::uint64_t next_head_ = 0;
+    // Producer-owned line: tail_, the producer's cached copy of head_ and the start of the reserved record.
+    alignas(cacheline_size)
+        std::atomic<std::uint64_t> tail_ = 0;
+    std::uint64_t head_cache_ = 0;
+    std::uint64_t reserved_ = 0;
+    alignas(cacheline_size)
+        std::atomic<bool> closed_ = false;
+};
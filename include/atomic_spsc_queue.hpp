@@ -1,34 +1,325 @@
+#pragma once
+
 #include <concepts>
 #include <thread>
 #include <cstddef>
+#include <algorithm>
+#include <functional>
+#include <iterator>
 #include <optional>
+#include <span>
 #include <stdexcept>
 #include <utility>
-#include <vector>
+#include <memory>
 #include <new>
 #include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
 #include <limits>
+#include <string>
+#include <type_traits>
+
+#include "bulk_copy.hpp"
+#include "queue_awaitables.hpp"
+#include "stats_policies.hpp"
+#include "wait_policies.hpp"
+
+/// @brief Index policies for atomic_spsc_queue.
+///
+/// head_ and tail_ are free-running 64-bit counters; an index policy maps a counter
+/// onto a slot of the ring buffer, decides how large that buffer is and holds the capacity.
+///
+/// - modulo_index_policy: buffer holds exactly capacity slots, slot = counter % capacity.
+///   Works for any capacity, but the modulo by a runtime value is a real division.
+/// - pow2_index_policy: buffer is rounded up to the next power of two, slot = counter & mask.
+///   Removes the division from the hot path at the cost of up to 2x the slot memory.
+/// - static_pow2_index_policy<N>: pow2_index_policy with capacity N fixed at compile time.
+///   capacity(), buffer_size() and mask are constexpr, so the full check compares against an
+///   immediate and slot math folds to an AND with one. The queue can be default-constructed;
+///   constructing it with any capacity other than N throws.
+///
+/// In all cases the queue still holds at most capacity items, so capacity() is unchanged.
+
+struct modulo_index_policy
+{
+    explicit modulo_index_policy(std::size_t capacity) : buffer_size_(capacity)
+    {
+        if (capacity == 0)
+        {
+            throw std::invalid_argument("Invalid capacity: " + std::to_string(capacity));
+        }
+    }
+
+    std::size_t capacity() const
+    {
+        return buffer_size_;
+    }
+
+    std::size_t buffer_size() const
+    {
+        return buffer_size_;
+    }
+
+    std::size_t slot(std::uint64_t counter) const
+    {
+        return static_cast<std::size_t>(counter % buffer_size_);
+    }
+
+private:
+    std::size_t buffer_size_;
+};
+
+struct pow2_index_policy
+{
+    explicit pow2_index_policy(std::size_t capacity) : capacity_(capacity)
+    {
+        if (capacity == 0 || capacity > (std::numeric_limits<std::size_t>::max() / 2 + 1))
+        {
+            throw std::invalid_argument("Invalid capacity: " + std::to_string(capacity));
+        }
+        mask_ = std::bit_ceil(capacity) - 1;
+    }
+
+    std::size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    std::size_t buffer_size() const
+    {
+        return mask_ + 1;
+    }
+
+    std::size_t slot(std::uint64_t counter) const
+    {
+        return static_cast<std::size_t>(counter) & mask_;
+    }
+
+private:
+    std::size_t capacity_;
+    std::size_t mask_;
+};
+
+template <std::size_t N>
+    requires(N >= 1 && N <= std::numeric_limits<std::size_t>::max() / 2 + 1)
+struct static_pow2_index_policy
+{
+    static constexpr std::size_t mask = std::bit_ceil(N) - 1;
+
+    static_pow2_index_policy() = default;
+
+    explicit static_pow2_index_policy(std::size_t capacity)
+    {
+        if (capacity != N)
+        {
+            throw std::invalid_argument("Invalid capacity: " + std::to_string(capacity));
+        }
+    }
+
+    static constexpr std::size_t capacity()
+    {
+        return N;
+    }
+
+    static constexpr std::size_t buffer_size()
+    {
+        return mask + 1;
+    }
+
+    static constexpr std::size_t slot(std::uint64_t counter)
+    {
+        return static_cast<std::size_t>(counter) & mask;
+    }
+};
+
+// Index policies whose capacity is a compile-time constant; the queue is then default-constructible.
+template <class P>
+concept static_index_policy = requires { std::integral_constant<std::size_t, P::capacity()>{}; };
+
+/// @brief Ring storage for atomic_spsc_queue.
+///
+/// The Allocator parameter of atomic_spsc_queue is either a standard allocator, which provides
+/// the ring at construction, or inline_storage<T, Slots>, which makes the ring a
+/// cache-line-aligned array of Slots raw slots inside the queue object:
+///
+/// - No heap allocation at all, so queues can be embedded in preallocated per-core structs or
+///   arrays, or placed in a shared-memory segment (with a trivially copyable T and a wait
+///   policy without process-private state such as park_wait's futex word).
+/// - The ring address is a fixed offset from this, so no buffer pointer is loaded per operation.
+/// - The IndexPolicy's buffer_size() must not exceed Slots; the constructor throws otherwise.
+///   With static_pow2_index_policy that check folds away (see static_spsc_queue.hpp).
+///
+/// sizeof(queue) includes the whole ring, so large rings belong in static or heap-allocated
+/// storage, not on a thread's stack.
+
+template <class T, std::size_t Slots>
+    requires(Slots >= 1)
+struct inline_storage
+{
+    using value_type = T;
+    static constexpr std::size_t slots = Slots;
+};
+
+namespace detail
+{
+    template <class Allocator>
+    inline constexpr bool is_inline_storage = false;
+
+    template <class T, std::size_t Slots>
+    inline constexpr bool is_inline_storage<inline_storage<T, Slots>> = true;
+
+    // Allocator-backed ring: raw memory for buffer_size slots from Allocator.
+    template <class Allocator>
+    class ring_storage
+    {
+    public:
+        using T = typename Allocator::value_type;
+
+        ring_storage(std::size_t buffer_size, const Allocator &alloc)
+            : alloc_(alloc), buffer_size_(buffer_size), data_(alloc_traits::allocate(alloc_, buffer_size))
+        {
+        }
+
+        ~ring_storage()
+        {
+            alloc_traits::deallocate(alloc_, data_, buffer_size_);
+        }
+
+        ring_storage(const ring_storage &) = delete;
+        ring_storage &operator=(const ring_storage &) = delete;
+
+        T *data() const
+        {
+            return data_;
+        }
+
+        Allocator get_allocator() const
+        {
+            return alloc_;
+        }
+
+    private:
+        using alloc_traits = std::allocator_traits<Allocator>;
+
+        [[no_unique_address]] Allocator alloc_;
+        std::size_t buffer_size_;
+        T *data_;
+    };
+
+    // Inline ring: Slots raw slots stored in the object itself, on their own cache lines.
+    template <class T, std::size_t Slots>
+    class ring_storage<inline_storage<T, Slots>>
+    {
+    public:
+        ring_storage(std::size_t buffer_size, const inline_storage<T, Slots> &)
+        {
+            if (buffer_size > Slots)
+            {
+                throw std::invalid_argument("Invalid capacity: ring needs " + std::to_string(buffer_size) +
+                                            " slots, inline storage has " + std::to_string(Slots));
+            }
+        }
+
+        ring_storage(const ring_storage &) = delete;
+        ring_storage &operator=(const ring_storage &) = delete;
+
+        T *data()
+        {
+            return std::launder(reinterpret_cast<T *>(bytes_));
+        }
+
+    private:
+        static constexpr std::size_t cacheline_size = 64;
+
+        alignas(std::max(cacheline_size, alignof(T))) std::byte bytes_[sizeof(T) * Slots];
+    };
+} // namespace detail
+
+/// @brief Publish policies for atomic_spsc_queue.
+///
+/// A publish policy decides how often each side makes its progress visible to the other.
+///
+/// - eager_publish: every push releases tail_ and every pop releases head_.
+/// - lazy_publish<ProducerBatch, ConsumerBatch>: each side advances a private position and
+///   releases its shared index only once that many operations are pending, in the style of
+///   FastForward/MCRingBuffer. One release store and one transfer of the index cache line
+///   then cover a whole batch, even when the caller pushes or pops one item at a time.
+///
+/// Pending operations are published early:
+///   * by flush() (producer) and flush_pops() (consumer),
+///   * by close(),
+///   * whenever an operation of that side fails because the queue looks full (producer) or
+///     empty (consumer), so retry loops and blocking waits never wait on unpublished work.
+/// A producer that stops pushing without closing must call flush(), or its last items stay
+/// invisible to the consumer.
+
+struct eager_publish
+{
+    static constexpr std::size_t producer_batch = 1;
+    static constexpr std::size_t consumer_batch = 1;
+};
+
+template <std::size_t ProducerBatch, std::size_t ConsumerBatch = ProducerBatch>
+    requires(ProducerBatch >= 1 && ConsumerBatch >= 1)
+struct lazy_publish
+{
+    static constexpr std::size_t producer_batch = ProducerBatch;
+    static constexpr std::size_t consumer_batch = ConsumerBatch;
+};
+
+template <class P>
+concept publish_policy = requires {
+    { P::producer_batch } -> std::convertible_to<std::size_t>;
+    { P::consumer_batch } -> std::convertible_to<std::size_t>;
+} && P::producer_batch >= 1 && P::consumer_batch >= 1;
 
 /// @class atomic_spsc_queue
 /// @brief A single-producer, single-consumer (SPSC) bounded queue.
 ///
 /// @tparam T The type of elements stored in the queue.
-/// Must be default-initializable and movable.
+/// Must be movable.
+/// @tparam IndexPolicy Maps head_/tail_ counters onto ring slots and holds the capacity
+/// (modulo_index_policy, pow2_index_policy or static_pow2_index_policy<N>).
+/// @tparam WaitPolicy How blocking operations wait, see wait_policies.hpp. async_wait
+/// (queue_awaitables.hpp) also enables async_pop()/async_push() for coroutines.
+/// @tparam Allocator Allocates the ring buffer. The default is std::allocator; use
+/// mmap_allocator (mmap_allocator.hpp) to bind the ring to a NUMA node or prefault it, or
+/// inline_storage<T, Slots> to keep the ring inside the queue object.
+/// @tparam StatsPolicy Optional event counters, see stats_policies.hpp. The default no_stats
+/// compiles them out; queue_stats enables stats().
+/// @tparam PublishPolicy How often tail_/head_ are published (eager_publish or lazy_publish<K>).
+/// With lazy_publish, size()/approx_size() count only published items, done() and the
+/// destructor must run on the consumer (or after both threads stopped), and close() must be
+/// called by the producer.
 ///
 /// @details
-/// Ring-buffer based SPSC queue using atomic head_ and tail_ indices.
+/// Ring-buffer based SPSC queue using atomic head_ and tail_ counters.
 ///
 /// - Exactly one producer modifies tail_.
 /// - Exactly one consumer modifies head_.
 /// - No locks; synchronization via atomics only.
-/// - Blocking push()/pop() use busy wait with periodic yield().
-/// - Storage is std::vector<T> sized to (capacity + 1), so slots are
-///   pre-constructed and updated by move-assignment.
+/// - Blocking push()/pop() wait according to WaitPolicy (busy wait with periodic yield() by default).
+/// - Storage is raw, uninitialized memory sized by the IndexPolicy and obtained from Allocator
+///   (or held inline).
+///   push() placement-constructs the item in its slot and pop() destroys it, so T does not need
+///   a default constructor and creating the queue does not touch the ring pages (unless the
+///   allocator prefaults them).
+/// - Bulk operations on contiguous ranges of trivially copyable T copy whole runs with memcpy,
+///   optionally with non-temporal stores (see bulk_copy.hpp).
 ///
-/// The internal buffer size is (capacity + 1). One slot is intentionally unused so that:
+/// head_ and tail_ are free-running 64-bit counters that never wrap in practice, so:
 ///   * empty : head_ == tail_
-///   * full  : (tail_ + 1) % buffer_size_ == head_
-/// This avoids a shared atomic size counter and any shared RMW operations in the hot path.
+///   * full  : tail_ - head_ == capacity()
+/// No slot is wasted to tell full from empty, and there is no shared atomic size counter
+/// or any shared RMW operation in the hot path.
+///
+/// - Cached remote indices:
+///   * The producer keeps a private copy of head_ (head_cache_) and the consumer keeps a
+///     private copy of tail_ (tail_cache_).
+///   * The remote index is reloaded only when the cached copy says the queue is full (producer)
+///     or empty (consumer), so the other side's cache line is not pulled in on every operation.
+///   * Each cached copy lives on the cache line of the index its owner writes.
 ///
 /// - Memory ordering:
 ///   * Relaxed for loading indices in the thread that modifies them.
@@ -37,8 +328,9 @@
 ///     - tail_ is released by push() and acquired in pop().
 ///     - head_ is released by pop() and acquired in push().
 ///
-/// close() sets a flag that is polled by blocked operations. No explicit
-/// wakeup primitive is needed because blocking operations spin.
+/// close() sets a flag that is polled by blocked operations and lets the wait policy wake
+/// any parked side. With spin_yield_wait no wakeup primitive is needed because blocking
+/// operations spin.
 ///
 /// @note The queue is non-copyable and non-movable. The queue must outlive
 /// all threads accessing it. Users are responsible for stopping and joining
@@ -46,42 +338,63 @@
 ///
 /// @warning This queue is NOT thread-safe for multiple producers or consumers.
 
-template <class T>
-    requires std::default_initializable<T> && std::movable<T>
+template <class T, class IndexPolicy = modulo_index_policy, class WaitPolicy = spin_yield_wait,
+          class Allocator = std::allocator<T>, class StatsPolicy = no_stats, class PublishPolicy = eager_publish>
+    requires std::movable<T> && wait_policy<WaitPolicy> && std::same_as<typename Allocator::value_type, T> &&
+             stats_policy<StatsPolicy> && publish_policy<PublishPolicy>
 class atomic_spsc_queue
 {
 public:
     using value_type = T;
+    using allocator_type = Allocator;
 
-    atomic_spsc_queue(std::size_t capacity) : capacity_(capacity), buffer_size_(capacity + 1), buffer_(buffer_size_)
+    atomic_spsc_queue(std::size_t capacity, const Allocator &alloc = Allocator())
+        : index_(capacity), storage_(index_.buffer_size(), alloc)
+    {
+    }
+
+    // Capacity fixed by the IndexPolicy, e.g. static_pow2_index_policy<N>.
+    atomic_spsc_queue()
+        requires static_index_policy<IndexPolicy>
+        : atomic_spsc_queue(IndexPolicy::capacity())
     {
-        if (capacity_ == 0 || capacity_ > (std::numeric_limits<std::size_t>::max() - 1))
-        {
-            throw std::invalid_argument("Invalid capacity: " + std::to_string(capacity_));
-        }
     }
 
     // Non-blocking push. Returns false if queue is full or closed.
     template <typename U>
         requires std::constructible_from<T, U &&>
     bool try_push(U &&item)
+    {
+        return try_emplace(std::forward<U>(item));
+    }
+
+    // Non-blocking push constructing the item directly in its slot from args.
+    // Returns false if queue is full or closed.
+    template <typename... Args>
+        requires std::constructible_from<T, Args &&...>
+    bool try_emplace(Args &&...args)
     {
         if (closed_.load(std::memory_order_acquire))
         {
             return false;
         }
-        const std::size_t t = tail_.load(std::memory_order_relaxed);
-        const std::size_t next = (t + 1) % buffer_size_;
+        const std::uint64_t t = producer_tail();
 
-        // Full if advancing tail would collide with head.
-        if (next == head_.load(std::memory_order_acquire))
+        // Full if capacity() items are in flight. Refresh the cached head only when it says full.
+        if (t - head_cache_ == capacity())
         {
-            return false;
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (t - head_cache_ == capacity())
+            {
+                flush();
+                stats_.on_push_failed();
+                return false;
+            }
         }
 
-        buffer_[t] = T(std::forward<U>(item));
+        std::construct_at(ring() + index_.slot(t), std::forward<Args>(args)...);
 
-        tail_.store(next, std::memory_order_release);
+        advance_tail(t + 1);
         return true;
     }
 
@@ -90,69 +403,350 @@ public:
         requires std::constructible_from<T, U &&>
     bool push(U &&item)
     {
-        std::size_t spin = 0;
-
-        while (!closed()) {
-            if (try_push(std::forward<U>(item)))
-            {
-                return true;
-            }
+        return push_until_deadline(std::forward<U>(item), no_deadline);
+    }
 
-            if (++spin >= yield_after_)
-            {
-                std::this_thread::yield();
-                spin = 0;
-            }
-        }
+    // Timed blocking push. Returns false if queue gets closed or the deadline passes while waiting.
+    template <typename U, class Clock, class Duration>
+        requires std::constructible_from<T, U &&>
+    bool push_until(U &&item, const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        return push_until_deadline(std::forward<U>(item), to_steady_deadline(deadline));
+    }
 
-        return false;
+    // Timed blocking push. Returns false if queue gets closed or timeout expires while waiting.
+    template <typename U, class Rep, class Period>
+        requires std::constructible_from<T, U &&>
+    bool push_for(U &&item, const std::chrono::duration<Rep, Period> &timeout)
+    {
+        return push_until_deadline(std::forward<U>(item), deadline_after(timeout));
     }
 
     // Non-blocking pop. Returns nullopt if queue is empty.
     std::optional<T> try_pop()
     {
-        const std::size_t h = head_.load(std::memory_order_relaxed);
-
-        // Empty if head catches tail.
-        if (h == tail_.load(std::memory_order_acquire))
+        T *item = front();
+        if (item == nullptr)
         {
             return std::nullopt;
         }
 
-        T value = std::move(buffer_[h]);
-        const std::size_t next = (h + 1) % buffer_size_;
-
-        head_.store(next, std::memory_order_release);
+        T value = std::move(*item);
+        pop_front();
         return value;
     }
 
+    // Non-blocking in-place consume. Invokes f on the oldest item while it is still in its slot,
+    // then releases the slot. Returns false (without invoking f) if queue is empty.
+    // If f throws, the item stays in the queue.
+    template <typename F>
+        requires std::invocable<F, T &>
+    bool try_consume(F &&f)
+    {
+        T *item = front();
+        if (item == nullptr)
+        {
+            return false;
+        }
+
+        std::invoke(std::forward<F>(f), *item);
+        pop_front();
+        return true;
+    }
+
+    // Non-blocking in-place drain. Invokes f on every item available at the call, oldest first,
+    // in its slot, then releases them all with one publish of head_. tail_ is loaded once, so items
+    // pushed meanwhile are left for the next call. Returns the number of items consumed (0 if empty).
+    // If f throws, the items before the throwing one are released and it stays in the queue.
+    template <typename F>
+        requires std::invocable<F &, T &>
+    std::size_t consume_all(F &&f)
+    {
+        return consume_batch(f, std::numeric_limits<std::size_t>::max());
+    }
+
+    // Same as consume_all(), but consumes at most max items.
+    template <typename F>
+        requires std::invocable<F &, T &>
+    std::size_t consume_up_to(std::size_t max, F &&f)
+    {
+        return consume_batch(f, max);
+    }
+
+    // Consumer-side access to the oldest item without removing it. Returns nullptr if queue is empty.
+    // The pointer stays valid until the item is removed by pop_front(), try_pop() or try_consume().
+    T *front()
+    {
+        const std::uint64_t h = consumer_head();
+
+        // Empty if head catches tail. Refresh the cached tail only when it says empty.
+        if (h == tail_cache_)
+        {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (h == tail_cache_)
+            {
+                flush_pops();
+                stats_.on_pop_failed();
+                return nullptr;
+            }
+        }
+
+        return ring() + index_.slot(h);
+    }
+
+    // Removes the oldest item. Must only be called after front() returned a non-null pointer.
+    void pop_front()
+    {
+        const std::uint64_t h = consumer_head();
+        std::destroy_at(ring() + index_.slot(h));
+
+        advance_head(h + 1);
+    }
+
     // Blocking pop. Returns nullopt if queue is closed and empty.
     std::optional<T> pop()
     {
-        for (std::size_t spin = 0;;)
+        return pop_until_deadline(no_deadline);
+    }
+
+    // Timed blocking pop. Returns nullopt if queue is closed and empty, or the deadline passes while waiting.
+    template <class Clock, class Duration>
+    std::optional<T> pop_until(const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        return pop_until_deadline(to_steady_deadline(deadline));
+    }
+
+    // Timed blocking pop. Returns nullopt if queue is closed and empty, or timeout expires while waiting.
+    template <class Rep, class Period>
+    std::optional<T> pop_for(const std::chrono::duration<Rep, Period> &timeout)
+    {
+        return pop_until_deadline(deadline_after(timeout));
+    }
+
+    // Awaitable pop: co_await q.async_pop() yields the oldest item, suspending while queue is empty,
+    // or nullopt once queue is closed and drained. post resumes the coroutine, see queue_awaitables.hpp.
+    template <typename Post = inline_resume>
+        requires async_wait_policy<WaitPolicy> && std::invocable<Post &, std::coroutine_handle<>>
+    queue_pop_awaitable<atomic_spsc_queue, Post> async_pop(Post post = {})
+    {
+        return {*this, std::move(post)};
+    }
+
+    // Awaitable push: co_await q.async_push(item) yields true once item is pushed, suspending while
+    // queue is full, or false if queue gets closed.
+    template <typename U, typename Post = inline_resume>
+        requires async_wait_policy<WaitPolicy> && std::constructible_from<T, U &&> &&
+                 std::invocable<Post &, std::coroutine_handle<>>
+    queue_push_awaitable<atomic_spsc_queue, Post> async_push(U &&item, Post post = {})
+    {
+        return {*this, std::forward<U>(item), std::move(post)};
+    }
+
+    // Non-blocking bulk push. Pushes as many items from [first, last) as currently fit and
+    // publishes tail_ once for the whole batch. Returns the number of items pushed
+    // (0 if queue is full or closed).
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+        requires std::constructible_from<T, std::iter_reference_t<InputIt>>
+    std::size_t try_push_n(InputIt first, Sentinel last)
+    {
+        return push_batch(first, last);
+    }
+
+    // try_push_n() writing the ring with non-temporal stores, see bulk_copy.hpp.
+    template <std::input_iterator InputIt, std::sized_sentinel_for<InputIt> Sentinel>
+        requires contiguous_source_of<InputIt, T>
+    std::size_t try_push_n(InputIt first, Sentinel last, streaming_copy_t)
+    {
+        return push_batch<true>(first, last);
+    }
+
+    // Blocking bulk push. Pushes all items from [first, last), publishing once per batch that fits.
+    // Returns the number of items pushed, which is less than the range size only if queue gets closed.
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+        requires std::constructible_from<T, std::iter_reference_t<InputIt>>
+    std::size_t push_n(InputIt first, Sentinel last)
+    {
+        return push_all<false>(first, last);
+    }
+
+    // push_n() writing the ring with non-temporal stores, see bulk_copy.hpp.
+    template <std::input_iterator InputIt, std::sized_sentinel_for<InputIt> Sentinel>
+        requires contiguous_source_of<InputIt, T>
+    std::size_t push_n(InputIt first, Sentinel last, streaming_copy_t)
+    {
+        return push_all<true>(first, last);
+    }
+
+    // Non-blocking bulk pop. Moves up to max items into out and publishes head_ once.
+    // Returns the number of items popped (0 if queue is empty).
+    template <typename OutputIt>
+        requires std::output_iterator<OutputIt, T &&>
+    std::size_t try_pop_n(OutputIt out, std::size_t max)
+    {
+        return pop_batch(out, max);
+    }
+
+    // Blocking bulk pop. Waits until at least one item is available, then moves up to max items into out.
+    // Returns the number of items popped; 0 only if queue is closed and empty (or max is 0).
+    template <typename OutputIt>
+        requires std::output_iterator<OutputIt, T &&>
+    std::size_t pop_n(OutputIt out, std::size_t max)
+    {
+        for (std::size_t spin = 0; max != 0;)
         {
-            auto item = try_pop();
-            if (item.has_value())
+            const std::size_t n = pop_batch(out, max);
+            if (n != 0)
             {
-                return item;
+                return n;
             }
 
             if (done())
             {
-                return std::nullopt;
+                return 0;
+            }
+
+            stats_.on_pop_wait();
+            wait_.wait_for_items(spin, [this]
+                                 { return items_or_closed(); }, no_deadline);
+        }
+        return 0;
+    }
+
+    // Producer-side zero-copy write. Returns a span of up to n contiguous free slots starting at tail_;
+    // the span is shorter than n if fewer slots are free or the free space wraps around the end of the
+    // ring, and empty if queue is full or closed. Write into the span, then publish with commit().
+    // Only for trivially copyable T, whose slots can be written without constructing an object first.
+    std::span<T> reserve(std::size_t n)
+        requires std::is_trivially_copyable_v<T>
+    {
+        if (closed_.load(std::memory_order_acquire))
+        {
+            return {};
+        }
+        const std::uint64_t t = producer_tail();
+
+        // Refresh the cached head only if it does not leave room for n slots.
+        std::size_t free = capacity() - static_cast<std::size_t>(t - head_cache_);
+        if (free < n)
+        {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            free = capacity() - static_cast<std::size_t>(t - head_cache_);
+        }
+        if (free == 0)
+        {
+            flush();
+            stats_.on_push_failed();
+        }
+
+        const std::size_t start = index_.slot(t);
+        return {ring() + start, std::min({n, free, index_.buffer_size() - start})};
+    }
+
+    // Publishes the first k slots of the span returned by the last reserve(). k must not exceed its size.
+    void commit(std::size_t k)
+        requires std::is_trivially_copyable_v<T>
+    {
+        const std::uint64_t t = producer_tail();
+        advance_tail(t + k);
+    }
+
+    // Consumer-side zero-copy read. Returns a span of the contiguous items starting at head_
+    // (up to the end of the ring), or an empty span if queue is empty. Release them with release().
+    std::span<T> readable()
+        requires std::is_trivially_copyable_v<T>
+    {
+        const std::uint64_t h = consumer_head();
+        const std::size_t start = index_.slot(h);
+        const std::size_t to_end = index_.buffer_size() - start;
+
+        // Refresh the cached tail only if it does not already reach the end of the ring.
+        std::size_t available = static_cast<std::size_t>(tail_cache_ - h);
+        if (available < to_end)
+        {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            available = static_cast<std::size_t>(tail_cache_ - h);
+        }
+        if (available == 0)
+        {
+            flush_pops();
+            stats_.on_pop_failed();
+        }
+
+        return {ring() + start, std::min(available, to_end)};
+    }
+
+    // Releases the first k items of the span returned by the last readable(). k must not exceed its size.
+    void release(std::size_t k)
+        requires std::is_trivially_copyable_v<T>
+    {
+        const std::uint64_t h = consumer_head();
+        advance_head(h + k);
+    }
+
+    // Producer side: publishes pushes still pending under lazy_publish. No-op with eager_publish.
+    void flush()
+    {
+        if constexpr (lazy_tail)
+        {
+            if (tail_pos_ != tail_.load(std::memory_order_relaxed))
+            {
+                publish_tail(tail_pos_);
             }
+        }
+    }
 
-            if (++spin >= yield_after_)
+    // Consumer side: publishes pops still pending under lazy_publish, freeing their slots for
+    // the producer. No-op with eager_publish.
+    void flush_pops()
+    {
+        if constexpr (lazy_head)
+        {
+            if (head_pos_ != head_.load(std::memory_order_relaxed))
             {
-                std::this_thread::yield();
-                spin = 0;
+                publish_head(head_pos_);
             }
         }
     }
 
+    // Number of queued items. Called from the producer or the consumer thread, the caller's own
+    // index cannot move, so the result is exact at the moment the other index is loaded.
+    std::size_t size() const
+    {
+        const std::uint64_t h = head_.load(std::memory_order_acquire);
+        return static_cast<std::size_t>(tail_.load(std::memory_order_acquire) - h);
+    }
+
+    // Monitoring variant of size() for any thread: relaxed loads, clamped to [0, capacity()].
+    // The indices are read at slightly different times, so the value may be momentarily stale.
+    std::size_t approx_size() const
+    {
+        const std::uint64_t h = head_.load(std::memory_order_relaxed);
+        const std::uint64_t t = tail_.load(std::memory_order_relaxed);
+        return t <= h ? 0 : std::min(static_cast<std::size_t>(t - h), capacity());
+    }
+
     std::size_t capacity() const
     {
-        return capacity_;
+        return index_.capacity();
+    }
+
+    // Snapshot of the counters kept by StatsPolicy. Safe to call from any thread.
+    queue_stats_snapshot stats() const
+        requires StatsPolicy::enabled
+    {
+        return stats_.snapshot();
+    }
+
+    allocator_type get_allocator() const
+        requires(!detail::is_inline_storage<Allocator>)
+    {
+        return storage_.get_allocator();
+    }
+
+    // The queue's wait policy, e.g. to attach a selector_wait to an spsc_selector (spsc_selector.hpp).
+    WaitPolicy &get_wait_policy()
+    {
+        return wait_;
     }
 
     bool closed() const
@@ -168,22 +762,32 @@ public:
             return false;
         }
 
-        const std::size_t h = head_.load(std::memory_order_relaxed);
+        const std::uint64_t h = consumer_head();
         return h == tail_.load(std::memory_order_acquire);
     }
 
     void close()
     {
+        // Pending pushes become visible before the flag, so a consumer that sees closed_ drains them.
+        flush();
         // Blocked operations poll this flag and exit.
         closed_.store(true, std::memory_order_release);
+        wait_.notify_close();
     }
 
     // Destructor calling close() is only a best-effort wakeup.
     // The queue must outlive all threads that may access it.
     // Users must stop/join producer & consumer before destroying the queue.
+    // Items that were never popped are destroyed here.
     ~atomic_spsc_queue()
     {
         close();
+
+        const std::uint64_t t = tail_.load(std::memory_order_acquire);
+        for (std::uint64_t h = consumer_head(); h != t; ++h)
+        {
+            std::destroy_at(ring() + index_.slot(h));
+        }
     }
 
     // Let's not allow copying or moving the queue
@@ -193,15 +797,422 @@ public:
     atomic_spsc_queue &operator=(atomic_spsc_queue &&) = delete;
 
 private:
-    const std::size_t capacity_;
-    const std::size_t buffer_size_;
-    std::vector<T> buffer_;
-    static constexpr std::size_t yield_after_ = 1024;
+    T *ring()
+    {
+        return storage_.data();
+    }
+
+    template <class, class>
+    friend class queue_pop_awaitable;
+    template <class, class>
+    friend class queue_push_awaitable;
+
+    // Awaitable hooks: register w with the wait policy unless there is no need to suspend.
+    bool suspend_consumer(async_waiter &w)
+        requires async_wait_policy<WaitPolicy>
+    {
+        return wait_.suspend_consumer(w, [this]
+                                      { return items_or_closed(); });
+    }
+
+    bool suspend_producer(async_waiter &w)
+        requires async_wait_policy<WaitPolicy>
+    {
+        return wait_.suspend_producer(w, [this]
+                                      { return space_or_closed(); });
+    }
+
+    template <typename U>
+    bool push_until_deadline(U &&item, std::chrono::steady_clock::time_point deadline)
+    {
+        std::size_t spin = 0;
+
+        while (!closed())
+        {
+            if (try_push(std::forward<U>(item)))
+            {
+                return true;
+            }
+
+            stats_.on_push_wait();
+            if (!wait_.wait_for_space(spin, [this]
+                                      { return space_or_closed(); }, deadline))
+            {
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    std::optional<T> pop_until_deadline(std::chrono::steady_clock::time_point deadline)
+    {
+        for (std::size_t spin = 0;;)
+        {
+            auto item = try_pop();
+            if (item.has_value())
+            {
+                return item;
+            }
+
+            if (done())
+            {
+                return std::nullopt;
+            }
+
+            stats_.on_pop_wait();
+            if (!wait_.wait_for_items(spin, [this]
+                                      { return items_or_closed(); }, deadline))
+            {
+                return std::nullopt;
+            }
+        }
+    }
+
+    static constexpr bool lazy_tail = PublishPolicy::producer_batch > 1;
+    static constexpr bool lazy_head = PublishPolicy::consumer_batch > 1;
+
+    // Producer's write position: tail_, or with lazy_publish the private position that runs
+    // ahead of tail_ by the pushes not published yet.
+    std::uint64_t producer_tail() const
+    {
+        if constexpr (lazy_tail)
+        {
+            return tail_pos_;
+        }
+        else
+        {
+            return tail_.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Consumer's read position, the counterpart of producer_tail().
+    std::uint64_t consumer_head() const
+    {
+        if constexpr (lazy_head)
+        {
+            return head_pos_;
+        }
+        else
+        {
+            return head_.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Moves the producer's position to t and publishes it once producer_batch pushes are pending.
+    void advance_tail(std::uint64_t t)
+    {
+        if constexpr (lazy_tail)
+        {
+            tail_pos_ = t;
+            if (t - tail_.load(std::memory_order_relaxed) < PublishPolicy::producer_batch)
+            {
+                return;
+            }
+        }
+        publish_tail(t);
+    }
+
+    // Moves the consumer's position to h and publishes it once consumer_batch pops are pending.
+    void advance_head(std::uint64_t h)
+    {
+        if constexpr (lazy_head)
+        {
+            head_pos_ = h;
+            if (h - head_.load(std::memory_order_relaxed) < PublishPolicy::consumer_batch)
+            {
+                return;
+            }
+        }
+        publish_head(h);
+    }
+
+    // Publishes tail_ and lets the wait policy wake a parked consumer.
+    void publish_tail(std::uint64_t t)
+    {
+        if constexpr (StatsPolicy::enabled)
+        {
+            const std::uint64_t old = tail_.load(std::memory_order_relaxed);
+            stats_.on_push(static_cast<std::size_t>(t - old), static_cast<std::size_t>(t - head_.load(std::memory_order_relaxed)));
+        }
+        tail_.store(t, std::memory_order_release);
+        wait_.notify_items();
+    }
+
+    // Publishes head_ and lets the wait policy wake a parked producer.
+    void publish_head(std::uint64_t h)
+    {
+        if constexpr (StatsPolicy::enabled)
+        {
+            stats_.on_pop(static_cast<std::size_t>(h - head_.load(std::memory_order_relaxed)));
+        }
+        head_.store(h, std::memory_order_release);
+        wait_.notify_space();
+    }
+
+    // Wake-up predicate of a blocked producer.
+    bool space_or_closed() const
+    {
+        return closed() || tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_acquire) < capacity();
+    }
+
+    // Wake-up predicate of a blocked consumer.
+    bool items_or_closed() const
+    {
+        return closed() || head_.load(std::memory_order_relaxed) != tail_.load(std::memory_order_acquire);
+    }
+
+    template <bool Stream, typename InputIt, typename Sentinel>
+    std::size_t push_all(InputIt &first, Sentinel last)
+    {
+        std::size_t pushed = 0;
+        std::size_t spin = 0;
+
+        while (first != last && !closed())
+        {
+            const std::size_t n = push_batch<Stream>(first, last);
+            if (n != 0)
+            {
+                pushed += n;
+                spin = 0;
+                continue;
+            }
+
+            stats_.on_push_wait();
+            wait_.wait_for_space(spin, [this]
+                                 { return space_or_closed(); }, no_deadline);
+        }
+
+        return pushed;
+    }
+
+    // Pushes items from first (advancing it) into at most two contiguous runs of free slots:
+    // [slot(tail_), buffer end) and then [0, ...) after wrap-around. tail_ is published once.
+    // A contiguous range of trivially copyable T is copied with one memcpy (or streaming copy)
+    // per run. If constructing an item throws, the items constructed so far are still published.
+    template <bool Stream = false, typename InputIt, typename Sentinel>
+    std::size_t push_batch(InputIt &first, Sentinel last)
+    {
+        if (closed_.load(std::memory_order_acquire) || first == last)
+        {
+            return 0;
+        }
+        const std::uint64_t t = producer_tail();
+
+        // Refresh the cached head only if it does not leave room for the whole batch.
+        std::size_t wanted = capacity();
+        if constexpr (std::sized_sentinel_for<Sentinel, InputIt>)
+        {
+            wanted = std::min(wanted, static_cast<std::size_t>(last - first));
+        }
+        std::size_t free = capacity() - static_cast<std::size_t>(t - head_cache_);
+        if (free < wanted)
+        {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            free = capacity() - static_cast<std::size_t>(t - head_cache_);
+        }
+        if (free == 0)
+        {
+            flush();
+            stats_.on_push_failed();
+            return 0;
+        }
+
+        const std::size_t start = index_.slot(t);
+        const std::size_t first_run = std::min(free, index_.buffer_size() - start);
+
+        if constexpr (contiguous_source_of<InputIt, T> && std::sized_sentinel_for<Sentinel, InputIt>)
+        {
+            const std::size_t n = std::min(free, static_cast<std::size_t>(last - first));
+            const std::size_t run = std::min(n, first_run);
+            const T *src = std::to_address(first);
+            if constexpr (Stream)
+            {
+                stream_items(ring() + start, src, run);
+                stream_items(ring(), src + run, n - run);
+                // Before tail_ is released, now or by a later flush().
+                stream_fence();
+            }
+            else
+            {
+                copy_items(ring() + start, src, run);
+                copy_items(ring(), src + run, n - run);
+            }
+            first += static_cast<std::iter_difference_t<InputIt>>(n);
+            advance_tail(t + n);
+            return n;
+        }
+
+        std::size_t pushed = 0;
+        try
+        {
+            for (; pushed < first_run && first != last; ++pushed, ++first)
+            {
+                std::construct_at(ring() + start + pushed, *first);
+            }
+            for (; pushed < free && first != last; ++pushed, ++first)
+            {
+                std::construct_at(ring() + (pushed - first_run), *first);
+            }
+        }
+        catch (...)
+        {
+            advance_tail(t + pushed);
+            throw;
+        }
+
+        advance_tail(t + pushed);
+        return pushed;
+    }
+
+    // Moves up to max items into out from at most two contiguous runs of occupied slots.
+    // head_ is published once. Into a contiguous range of trivially copyable T, each run is one
+    // memcpy. If writing to out throws, the items moved so far are still released.
+    template <typename OutputIt>
+    std::size_t pop_batch(OutputIt &out, std::size_t max)
+    {
+        // Asking for nothing is not a failed pop.
+        if (max == 0)
+        {
+            return 0;
+        }
+
+        const std::uint64_t h = consumer_head();
+
+        // Refresh the cached tail only if it does not cover the whole batch.
+        std::size_t available = static_cast<std::size_t>(tail_cache_ - h);
+        if (available < max)
+        {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            available = static_cast<std::size_t>(tail_cache_ - h);
+        }
+
+        if (available == 0)
+        {
+            flush_pops();
+            stats_.on_pop_failed();
+            return 0;
+        }
+
+        const std::size_t n = std::min(available, max);
+        const std::size_t start = index_.slot(h);
+        const std::size_t first_run = std::min(n, index_.buffer_size() - start);
+
+        // Trivially copyable items have nothing to destroy.
+        if constexpr (contiguous_sink_of<OutputIt, T>)
+        {
+            T *dst = std::to_address(out);
+            copy_items(dst, ring() + start, first_run);
+            copy_items(dst + first_run, ring(), n - first_run);
+            out += static_cast<std::iter_difference_t<OutputIt>>(n);
+            if (n != 0)
+            {
+                advance_head(h + n);
+            }
+            return n;
+        }
+
+        std::size_t popped = 0;
+        try
+        {
+            for (; popped < first_run; ++popped, ++out)
+            {
+                *out = std::move(ring()[start + popped]);
+                std::destroy_at(ring() + start + popped);
+            }
+            for (; popped < n; ++popped, ++out)
+            {
+                *out = std::move(ring()[popped - first_run]);
+                std::destroy_at(ring() + (popped - first_run));
+            }
+        }
+        catch (...)
+        {
+            advance_head(h + popped);
+            throw;
+        }
+
+        if (n != 0)
+        {
+            advance_head(h + n);
+        }
+        return n;
+    }
+
+    // Invokes f on up to max items in place, from at most two contiguous runs of occupied slots,
+    // destroying each after f returns. head_ is published once. If f throws, the items consumed
+    // so far are still released.
+    template <typename F>
+    std::size_t consume_batch(F &f, std::size_t max)
+    {
+        // Asking for nothing is not a failed pop.
+        if (max == 0)
+        {
+            return 0;
+        }
+
+        const std::uint64_t h = consumer_head();
+
+        // Refresh the cached tail only if it does not cover the whole batch.
+        std::size_t available = static_cast<std::size_t>(tail_cache_ - h);
+        if (available < max)
+        {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            available = static_cast<std::size_t>(tail_cache_ - h);
+        }
+
+        if (available == 0)
+        {
+            flush_pops();
+            stats_.on_pop_failed();
+            return 0;
+        }
+
+        const std::size_t n = std::min(available, max);
+        const std::size_t start = index_.slot(h);
+        const std::size_t first_run = std::min(n, index_.buffer_size() - start);
+
+        std::size_t consumed = 0;
+        try
+        {
+            for (; consumed < first_run; ++consumed)
+            {
+                std::invoke(f, ring()[start + consumed]);
+                std::destroy_at(ring() + start + consumed);
+            }
+            for (; consumed < n; ++consumed)
+            {
+                std::invoke(f, ring()[consumed - first_run]);
+                std::destroy_at(ring() + (consumed - first_run));
+            }
+        }
+        catch (...)
+        {
+            advance_head(h + consumed);
+            throw;
+        }
+
+        advance_head(h + n);
+        return n;
+    }
+
+    [[no_unique_address]] const IndexPolicy index_;
+    [[no_unique_address]] detail::ring_storage<Allocator> storage_;
     static constexpr std::size_t cacheline_size = 64;
+    // Consumer-owned line: head_ and the consumer's cached copy of tail_.
     alignas(cacheline_size)
-        std::atomic<std::size_t> head_ = 0;
+        std::atomic<std::uint64_t> head_ = 0;
+    std::uint64_t tail_cache_ = 0;
+    // Consumer's unpublished position under lazy_publish.
+    std::uint64_t head_pos_ = 0;
+    // Producer-owned line: tail_ and the producer's cached copy of head_.
     alignas(cacheline_size)
-        std::atomic<std::size_t> tail_ = 0;
+        std::atomic<std::uint64_t> tail_ = 0;
+    std::uint64_t head_cache_ = 0;
+    // Producer's unpublished position under lazy_publish.
+    std::uint64_t tail_pos_ = 0;
     alignas(cacheline_size)
         std::atomic<bool> closed_ = false;
+    [[no_unique_address]] WaitPolicy wait_;
+    [[no_unique_address]] StatsPolicy stats_;
 };
@@ -0,0 +1,621 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "wait_policies.hpp"
+
+/// @class broadcast_queue
+/// @brief A single-producer, multi-reader bounded ring where every reader sees every item.
+///
+/// @tparam T The type of elements stored in the queue. Readers get copies or const references,
+/// so T must be copy constructible.
+/// @tparam WaitPolicy How blocking operations wait, see wait_policies.hpp. Every reader has its
+/// own instance, so parking policies work with several readers.
+///
+/// @details
+/// Disruptor-style broadcast: each slot is written once by the producer and read in place by
+/// all readers, instead of copying every item into one SPSC queue per reader.
+///
+/// - The producer owns tail_. Each reader owns a cursor (its head) on a cache line of its own,
+///   next to its cached copy of tail_, so readers never write a shared line.
+/// - The producer may overwrite a slot only once the slowest reader has passed it. It keeps a
+///   cached minimum of all cursors and rescans them only when that cached minimum says the ring is full,
+///   as atomic_spsc_queue does with its single head_.
+/// - Items stay in their slots after being read and are destroyed when the producer reuses the
+///   slot, or by the destructor.
+/// - The ring has std::bit_ceil(capacity) slots, so slot = counter & mask, but at most capacity
+///   items are unread by the slowest reader.
+/// - close() works as in the SPSC queues: pushes fail, and each reader drains what it has not
+///   read yet; reader::done() turns true independently for each reader.
+///
+/// A blocked producer waits on the wait policy of the slowest reader, which wakes it when that
+/// reader moves on; a blocked reader waits on its own instance, woken by every publish.
+///
+/// @note The queue is non-copyable and non-movable. Each reader index must be used by only one
+/// thread at a time, and all threads must be stopped before destroying the queue.
+
+template <class T, class WaitPolicy = spin_yield_wait>
+    requires std::copy_constructible<T> && std::movable<T> && wait_policy<WaitPolicy>
+class broadcast_queue
+{
+    struct reader_state;
+
+public:
+    using value_type = T;
+
+    /// @brief One reader's view of the queue. Cheap to copy; all copies share the same cursor.
+    class reader
+    {
+    public:
+        // Non-blocking read. Returns a copy of the next item, or nullopt if this reader is caught up.
+        std::optional<T> try_pop()
+        {
+            const T *item = front();
+            if (item == nullptr)
+            {
+                return std::nullopt;
+            }
+
+            T value = *item;
+            pop_front();
+            return value;
+        }
+
+        // Non-blocking in-place read. Invokes f on the next item in its slot, then moves this
+        // reader past it. Returns false (without invoking f) if this reader is caught up.
+        // If f throws, the item stays unread.
+        template <typename F>
+            requires std::invocable<F, const T &>
+        bool try_consume(F &&f)
+        {
+            const T *item = front();
+            if (item == nullptr)
+            {
+                return false;
+            }
+
+            std::invoke(std::forward<F>(f), *item);
+            pop_front();
+            return true;
+        }
+
+        // The next item without moving past it, or nullptr if this reader is caught up. The item
+        // stays valid until this reader calls pop_front(), try_pop() or try_consume().
+        const T *front()
+        {
+            return q_->front(*state_);
+        }
+
+        // Moves past the next item. Must only be called after front() returned a non-null pointer.
+        void pop_front()
+        {
+            q_->pop_front(*state_);
+        }
+
+        // Blocking read. Returns nullopt once the queue is closed and this reader has read everything.
+        std::optional<T> pop()
+        {
+            return pop_until_deadline(no_deadline);
+        }
+
+        // Timed blocking read. Also returns nullopt if the deadline passes while waiting.
+        template <class Clock, class Duration>
+        std::optional<T> pop_until(const std::chrono::time_point<Clock, Duration> &deadline)
+        {
+            return pop_until_deadline(to_steady_deadline(deadline));
+        }
+
+        // Timed blocking read. Also returns nullopt if the timeout expires while waiting.
+        template <class Rep, class Period>
+        std::optional<T> pop_for(const std::chrono::duration<Rep, Period> &timeout)
+        {
+            return pop_until_deadline(deadline_after(timeout));
+        }
+
+        // Non-blocking bulk read. Copies up to max items into out and publishes the cursor once.
+        // Returns the number of items read (0 if this reader is caught up).
+        template <typename OutputIt>
+            requires std::output_iterator<OutputIt, const T &>
+        std::size_t try_pop_n(OutputIt out, std::size_t max)
+        {
+            return q_->pop_batch(*state_, out, max);
+        }
+
+        // Blocking bulk read. Waits until at least one item is unread, then copies up to max items into out.
+        // Returns the number of items read; 0 only if the queue is closed and this reader is done (or max is 0).
+        template <typename OutputIt>
+            requires std::output_iterator<OutputIt, const T &>
+        std::size_t pop_n(OutputIt out, std::size_t max)
+        {
+            for (std::size_t spin = 0; max != 0;)
+            {
+                const std::size_t n = q_->pop_batch(*state_, out, max);
+                if (n != 0)
+                {
+                    return n;
+                }
+
+                if (done())
+                {
+                    return 0;
+                }
+
+                wait_for_items(spin, no_deadline);
+            }
+            return 0;
+        }
+
+        // Items this reader has not read yet. Exact when called from this reader's thread.
+        std::size_t size() const
+        {
+            const std::uint64_t h = state_->head.load(std::memory_order_relaxed);
+            return static_cast<std::size_t>(q_->tail_.load(std::memory_order_acquire) - h);
+        }
+
+        // True once the queue is closed and this reader has read every item.
+        bool done() const
+        {
+            if (!q_->closed())
+            {
+                return false;
+            }
+
+            const std::uint64_t h = state_->head.load(std::memory_order_relaxed);
+            return h == q_->tail_.load(std::memory_order_acquire);
+        }
+
+        bool closed() const
+        {
+            return q_->closed();
+        }
+
+    private:
+        friend class broadcast_queue;
+
+        reader(broadcast_queue &q, reader_state &state) : q_(&q), state_(&state) {}
+
+        bool wait_for_items(std::size_t &spin, std::chrono::steady_clock::time_point deadline)
+        {
+            return state_->wait.wait_for_items(spin, [this]
+                                               { return q_->items_or_closed(*state_); }, deadline);
+        }
+
+        std::optional<T> pop_until_deadline(std::chrono::steady_clock::time_point deadline)
+        {
+            for (std::size_t spin = 0;;)
+            {
+                auto item = try_pop();
+                if (item.has_value())
+                {
+                    return item;
+                }
+
+                if (done())
+                {
+                    return std::nullopt;
+                }
+
+                if (!wait_for_items(spin, deadline))
+                {
+                    return std::nullopt;
+                }
+            }
+        }
+
+        broadcast_queue *q_;
+        reader_state *state_;
+    };
+
+    broadcast_queue(std::size_t capacity, std::size_t readers)
+        : capacity_(capacity), reader_count_(readers)
+    {
+        if (capacity_ == 0 || capacity_ > std::numeric_limits<std::size_t>::max() / 2 + 1)
+        {
+            throw std::invalid_argument("Invalid capacity: " + std::to_string(capacity_));
+        }
+        if (reader_count_ == 0)
+        {
+            throw std::invalid_argument("Invalid reader count: " + std::to_string(reader_count_));
+        }
+        mask_ = std::bit_ceil(capacity_) - 1;
+        readers_ = std::make_unique<reader_state[]>(reader_count_);
+        buffer_ = std::allocator<T>{}.allocate(mask_ + 1);
+    }
+
+    // The view of reader index (0 <= index < readers()). Readers are fixed at construction and
+    // all start at the first item.
+    reader get_reader(std::size_t index)
+    {
+        if (index >= reader_count_)
+        {
+            throw std::invalid_argument("Invalid reader index: " + std::to_string(index));
+        }
+        return reader(*this, readers_[index]);
+    }
+
+    // Non-blocking push. Returns false if the slowest reader is capacity items behind, or queue is closed.
+    template <typename U>
+        requires std::constructible_from<T, U &&>
+    bool try_push(U &&item)
+    {
+        return try_emplace(std::forward<U>(item));
+    }
+
+    // Non-blocking push constructing the item in its slot from args.
+    // Returns false if queue is full or closed.
+    template <typename... Args>
+        requires std::constructible_from<T, Args &&...>
+    bool try_emplace(Args &&...args)
+    {
+        if (closed_.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        const std::uint64_t t = tail_.load(std::memory_order_relaxed);
+
+        if (free_slots(t, 1) == 0)
+        {
+            return false;
+        }
+
+        construct(t, std::forward<Args>(args)...);
+
+        publish_tail(t + 1);
+        return true;
+    }
+
+    // Blocking push. Returns false if queue gets closed while waiting.
+    template <typename U>
+        requires std::constructible_from<T, U &&>
+    bool push(U &&item)
+    {
+        return push_until_deadline(std::forward<U>(item), no_deadline);
+    }
+
+    // Timed blocking push. Returns false if queue gets closed or the deadline passes while waiting.
+    template <typename U, class Clock, class Duration>
+        requires std::constructible_from<T, U &&>
+    bool push_until(U &&item, const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        return push_until_deadline(std::forward<U>(item), to_steady_deadline(deadline));
+    }
+
+    // Timed blocking push. Returns false if queue gets closed or timeout expires while waiting.
+    template <typename U, class Rep, class Period>
+        requires std::constructible_from<T, U &&>
+    bool push_for(U &&item, const std::chrono::duration<Rep, Period> &timeout)
+    {
+        return push_until_deadline(std::forward<U>(item), deadline_after(timeout));
+    }
+
+    // Non-blocking bulk push. Pushes as many items from [first, last) as currently fit and
+    // publishes tail_ once. Returns the number of items pushed (0 if queue is full or closed).
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+        requires std::constructible_from<T, std::iter_reference_t<InputIt>>
+    std::size_t try_push_n(InputIt first, Sentinel last)
+    {
+        return push_batch(first, last);
+    }
+
+    // Blocking bulk push. Pushes all items from [first, last), publishing once per batch that fits.
+    // Returns the number of items pushed, which is less than the range size only if queue gets closed.
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+        requires std::constructible_from<T, std::iter_reference_t<InputIt>>
+    std::size_t push_n(InputIt first, Sentinel last)
+    {
+        std::size_t pushed = 0;
+        std::size_t spin = 0;
+
+        while (first != last && !closed())
+        {
+            const std::size_t n = push_batch(first, last);
+            if (n != 0)
+            {
+                pushed += n;
+                spin = 0;
+                continue;
+            }
+
+            wait_for_space(spin, no_deadline);
+        }
+
+        return pushed;
+    }
+
+    // Items the slowest reader has not read yet. Exact when called from the producer thread.
+    std::size_t size() const
+    {
+        const std::uint64_t h = slowest_head();
+        return static_cast<std::size_t>(tail_.load(std::memory_order_acquire) - h);
+    }
+
+    std::size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    std::size_t readers() const
+    {
+        return reader_count_;
+    }
+
+    bool closed() const
+    {
+        return closed_.load(std::memory_order_acquire);
+    }
+
+    void close()
+    {
+        // Blocked operations poll this flag and exit.
+        closed_.store(true, std::memory_order_release);
+        for (std::size_t i = 0; i < reader_count_; ++i)
+        {
+            readers_[i].wait.notify_close();
+        }
+    }
+
+    // Items still in the ring, read or not, are destroyed here. Producer and reader threads must
+    // be stopped before destroying the queue.
+    ~broadcast_queue()
+    {
+        close();
+
+        const std::uint64_t t = tail_.load(std::memory_order_acquire);
+        for (std::uint64_t c = live_begin_; c != t; ++c)
+        {
+            std::destroy_at(buffer_ + slot(c));
+        }
+        std::allocator<T>{}.deallocate(buffer_, mask_ + 1);
+    }
+
+    // Let's not allow copying or moving the queue
+    broadcast_queue(const broadcast_queue &) = delete;
+    broadcast_queue &operator=(const broadcast_queue &) = delete;
+    broadcast_queue(broadcast_queue &&) = delete;
+    broadcast_queue &operator=(broadcast_queue &&) = delete;
+
+private:
+    static constexpr std::size_t cacheline_size = 64;
+
+    // Cursor of one reader and its cached copy of tail_, on cache lines of their own.
+    struct alignas(cacheline_size) reader_state
+    {
+        std::atomic<std::uint64_t> head = 0;
+        std::uint64_t tail_cache = 0;
+        [[no_unique_address]] WaitPolicy wait;
+    };
+
+    std::size_t slot(std::uint64_t counter) const
+    {
+        return static_cast<std::size_t>(counter) & mask_;
+    }
+
+    // Minimum over all cursors, i.e. the next item the slowest reader will read. Stores the
+    // reader holding it in slowest if given.
+    std::uint64_t slowest_head(std::size_t *slowest = nullptr) const
+    {
+        std::uint64_t h = readers_[0].head.load(std::memory_order_acquire);
+        std::size_t index = 0;
+        for (std::size_t i = 1; i < reader_count_; ++i)
+        {
+            const std::uint64_t r = readers_[i].head.load(std::memory_order_acquire);
+            if (r < h)
+            {
+                h = r;
+                index = i;
+            }
+        }
+        if (slowest != nullptr)
+        {
+            *slowest = index;
+        }
+        return h;
+    }
+
+    // Producer: free slots at t, up to wanted. Rescans the cursors only if the cached minimum
+    // does not leave room for wanted slots.
+    std::size_t free_slots(std::uint64_t t, std::size_t wanted)
+    {
+        std::size_t free = capacity_ - static_cast<std::size_t>(t - head_cache_);
+        if (free < wanted)
+        {
+            head_cache_ = slowest_head(&slowest_reader_);
+            free = capacity_ - static_cast<std::size_t>(t - head_cache_);
+        }
+        return free;
+    }
+
+    // Producer: constructs item t in its slot. The slot still holds the item a full lap earlier,
+    // which every reader has passed, unless that one was already destroyed.
+    template <typename... Args>
+    void construct(std::uint64_t t, Args &&...args)
+    {
+        T *p = buffer_ + slot(t);
+        if (t - live_begin_ > mask_)
+        {
+            std::destroy_at(p);
+            ++live_begin_;
+        }
+        // If this throws, the slot stays empty and live_begin_ already excludes it.
+        std::construct_at(p, std::forward<Args>(args)...);
+    }
+
+    template <typename U>
+    bool push_until_deadline(U &&item, std::chrono::steady_clock::time_point deadline)
+    {
+        std::size_t spin = 0;
+
+        while (!closed())
+        {
+            if (try_push(std::forward<U>(item)))
+            {
+                return true;
+            }
+
+            if (!wait_for_space(spin, deadline))
+            {
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    // Producer: waits on the wait policy of the reader that held the minimum at the last rescan,
+    // until that reader moves. Another reader may still be as slow; the retry rescans and then
+    // waits on that one.
+    bool wait_for_space(std::size_t &spin, std::chrono::steady_clock::time_point deadline)
+    {
+        const reader_state &slowest = readers_[slowest_reader_];
+        return readers_[slowest_reader_].wait.wait_for_space(spin, [this, &slowest]
+                                                              { return closed() || slowest.head.load(std::memory_order_acquire) != head_cache_; }, deadline);
+    }
+
+    // Publishes tail_ and lets every reader's wait policy wake a parked reader.
+    void publish_tail(std::uint64_t t)
+    {
+        tail_.store(t, std::memory_order_release);
+        for (std::size_t i = 0; i < reader_count_; ++i)
+        {
+            readers_[i].wait.notify_items();
+        }
+    }
+
+    // Wake-up predicate of a blocked reader.
+    bool items_or_closed(const reader_state &r) const
+    {
+        return closed() || r.head.load(std::memory_order_relaxed) != tail_.load(std::memory_order_acquire);
+    }
+
+    const T *front(reader_state &r)
+    {
+        const std::uint64_t h = r.head.load(std::memory_order_relaxed);
+
+        // Caught up if the cursor reaches tail. Refresh the cached tail only when it says so.
+        if (h == r.tail_cache)
+        {
+            r.tail_cache = tail_.load(std::memory_order_acquire);
+            if (h == r.tail_cache)
+            {
+                return nullptr;
+            }
+        }
+
+        return buffer_ + slot(h);
+    }
+
+    // Moves the cursor; the producer can reuse the slot once every reader has done so.
+    void pop_front(reader_state &r)
+    {
+        const std::uint64_t h = r.head.load(std::memory_order_relaxed);
+        r.head.store(h + 1, std::memory_order_release);
+        r.wait.notify_space();
+    }
+
+    // Pushes items from first (advancing it) into the free slots. tail_ is published once. If
+    // constructing an item throws, the items constructed so far are still published.
+    template <typename InputIt, typename Sentinel>
+    std::size_t push_batch(InputIt &first, Sentinel last)
+    {
+        if (closed_.load(std::memory_order_acquire) || first == last)
+        {
+            return 0;
+        }
+        const std::uint64_t t = tail_.load(std::memory_order_relaxed);
+
+        std::size_t wanted = capacity_;
+        if constexpr (std::sized_sentinel_for<Sentinel, InputIt>)
+        {
+            wanted = std::min(wanted, static_cast<std::size_t>(last - first));
+        }
+        const std::size_t free = free_slots(t, wanted);
+
+        std::size_t pushed = 0;
+        try
+        {
+            for (; pushed < free && first != last; ++pushed, ++first)
+            {
+                construct(t + pushed, *first);
+            }
+        }
+        catch (...)
+        {
+            publish_tail(t + pushed);
+            throw;
+        }
+
+        if (pushed != 0)
+        {
+            publish_tail(t + pushed);
+        }
+        return pushed;
+    }
+
+    // Copies up to max items into out. The cursor is published once. If writing to out throws,
+    // the items copied so far still count as read.
+    template <typename OutputIt>
+    std::size_t pop_batch(reader_state &r, OutputIt &out, std::size_t max)
+    {
+        const std::uint64_t h = r.head.load(std::memory_order_relaxed);
+
+        // Refresh the cached tail only if it does not cover the whole batch.
+        std::size_t available = static_cast<std::size_t>(r.tail_cache - h);
+        if (available < max)
+        {
+            r.tail_cache = tail_.load(std::memory_order_acquire);
+            available = static_cast<std::size_t>(r.tail_cache - h);
+        }
+
+        const std::size_t n = std::min(available, max);
+        std::size_t copied = 0;
+        try
+        {
+            for (; copied < n; ++copied, ++out)
+            {
+                *out = std::as_const(buffer_[slot(h + copied)]);
+            }
+        }
+        catch (...)
+        {
+            r.head.store(h + copied, std::memory_order_release);
+            r.wait.notify_space();
+            throw;
+        }
+
+        if (n != 0)
+        {
+            r.head.store(h + n, std::memory_order_release);
+            r.wait.notify_space();
+        }
+        return n;
+    }
+
+    const std::size_t capacity_;
+    const std::size_t reader_count_;
+    std::size_t mask_ = 0;
+    std::unique_ptr<reader_state[]> readers_;
+    T *buffer_ = nullptr;
+    // Producer-owned line: tail_, the cached slowest cursor and the reader that held it.
+    alignas(cacheline_size)
+        std::atomic<std::uint64_t> tail_ = 0;
+    std::uint64_t head_cache_ = 0;
+    std::size_t slowest_reader_ = 0;
+    // Oldest item whose slot still holds a live object; [live_begin_, tail_) is what the destructor destroys.
+    std::uint64_t live_begin_ = 0;
+    alignas(cacheline_size)
+        std::atomic<bool> closed_ = false;
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+#if defined(__AVX512F__) || defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/// @brief Bulk copies between caller ranges and ring slots, used by the batch operations.
+///
+/// For a trivially copyable T whose source (push) or destination (pop) is a contiguous range of
+/// T, try_push_n()/push_n()/try_pop_n()/pop_n() copy each contiguous run of the ring with one
+/// memcpy instead of constructing or assigning item by item. memcpy picks the widest vector
+/// stores the CPU has at run time, so a 64-byte item costs about one cache-line store.
+///
+/// Pushes can also use non-temporal stores, by passing streaming_copy to try_push_n()/push_n().
+/// They write the ring lines straight to memory instead of into the producer's cache: worth it
+/// for rings much larger than the cache whose consumer runs on another socket, where the line
+/// would otherwise be fetched from the producer's cache. Small rings in a shared cache are
+/// faster with plain stores. Non-temporal stores use the widest vectors enabled at compile time
+/// (SSE2, AVX or AVX-512 via -march); other targets fall back to memcpy.
+
+// Tag selecting non-temporal stores for a bulk push.
+struct streaming_copy_t
+{
+    explicit streaming_copy_t() = default;
+};
+
+inline constexpr streaming_copy_t streaming_copy{};
+
+// It is a contiguous iterator over T, and T can be copied into ring slots with memcpy.
+template <class It, class T>
+concept contiguous_source_of = std::is_trivially_copyable_v<T> && std::contiguous_iterator<It> &&
+                               std::same_as<std::remove_cv_t<std::iter_value_t<It>>, T>;
+
+// It is a contiguous iterator over writable T, and T can be copied out of ring slots with memcpy.
+template <class It, class T>
+concept contiguous_sink_of = std::is_trivially_copyable_v<T> && std::contiguous_iterator<It> &&
+                             std::same_as<std::iter_reference_t<It>, T &>;
+
+// Copies n items. Trivially copyable items come to life in raw slots by being copied there.
+template <class T>
+void copy_items(T *dst, const T *src, std::size_t n)
+{
+    if (n != 0)
+    {
+        std::memcpy(static_cast<void *>(dst), src, n * sizeof(T));
+    }
+}
+
+// Copies n items with non-temporal stores where the destination is vector-aligned. The stores
+// are weakly ordered: call stream_fence() before publishing them.
+template <class T>
+void stream_items(T *dst, const T *src, std::size_t n)
+{
+    auto *d = reinterpret_cast<unsigned char *>(dst);
+    const auto *s = reinterpret_cast<const unsigned char *>(src);
+    std::size_t bytes = n * sizeof(T);
+
+#if defined(__AVX512F__) || defined(__AVX__) || defined(__SSE2__)
+#if defined(__AVX512F__)
+    constexpr std::size_t width = 64;
+#elif defined(__AVX__)
+    constexpr std::size_t width = 32;
+#else
+    constexpr std::size_t width = 16;
+#endif
+    // Plain stores up to the first aligned vector, then one streaming store per vector.
+    const std::size_t misalignment = reinterpret_cast<std::uintptr_t>(d) % width;
+    const std::size_t head = std::min(bytes, misalignment == 0 ? 0 : width - misalignment);
+    std::memcpy(d, s, head);
+    d += head;
+    s += head;
+    bytes -= head;
+
+    for (; bytes >= width; d += width, s += width, bytes -= width)
+    {
+#if defined(__AVX512F__)
+        _mm512_stream_si512(reinterpret_cast<__m512i *>(d), _mm512_loadu_si512(s));
+#elif defined(__AVX__)
+        _mm256_stream_si256(reinterpret_cast<__m256i *>(d), _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s)));
+#else
+        _mm_stream_si128(reinterpret_cast<__m128i *>(d), _mm_loadu_si128(reinterpret_cast<const __m128i *>(s)));
+#endif
+    }
+#endif
+
+    std::memcpy(d, s, bytes);
+}
+
+// Orders preceding non-temporal stores before the following stores, e.g. the release of tail_.
+inline void stream_fence()
+{
+#if defined(__AVX512F__) || defined(__AVX__) || defined(__SSE2__)
+    _mm_sfence();
+#endif
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "atomic_spsc_queue.hpp"
+#include "wait_policies.hpp"
+
+/// @class message_pool
+/// @brief Fixed slab of preallocated payload buffers, recycled from the consumer back to the producer.
+///
+/// @tparam Buffer The payload type, e.g. std::vector<int> with reserved capacity. Must be movable.
+/// @tparam WaitPolicy How a blocking acquire() waits for a buffer to come back, see wait_policies.hpp.
+///
+/// @details
+/// Pairs with a forward queue that carries handles instead of payloads:
+///
+///   producer: h = pool.acquire(); fill pool[h]; q.push(h);
+///   consumer: h = q.pop(); read pool[h]; pool.release(h);
+///
+/// The buffers are created once, up front, so neither side allocates or frees while running and
+/// the consumer never frees memory the producer's thread allocated.
+///
+/// - Free handles travel back to the producer through a reverse atomic_spsc_queue, whose
+///   release/acquire hand-off orders the consumer's last access to a buffer before the
+///   producer's next one. The forward queue orders the producer's writes before the consumer's reads.
+/// - The reverse queue holds every handle, so release() never waits.
+/// - Each buffer sits on its own cache line, so filling one buffer does not false-share with
+///   the consumer reading its neighbour.
+/// - Size the pool for the forward queue's capacity plus the buffers each side holds at once
+///   (capacity + 2 for one at a time), or acquire() will wait on the consumer.
+///
+/// @note Exactly one thread acquires and one thread releases. The pool is non-copyable and
+/// non-movable, and must outlive both threads.
+
+template <class Buffer, class WaitPolicy = spin_yield_wait>
+    requires std::movable<Buffer> && wait_policy<WaitPolicy>
+class message_pool
+{
+public:
+    using value_type = Buffer;
+    // Index of a buffer in the slab. Small enough to keep the forward queue's slots compact.
+    using handle = std::uint32_t;
+
+    explicit message_pool(std::size_t count)
+        requires std::default_initializable<Buffer>
+        : message_pool(count, []
+                       { return Buffer(); })
+    {
+    }
+
+    // Creates count buffers with make(), e.g. to reserve their capacity up front.
+    template <typename Factory>
+        requires std::is_invocable_r_v<Buffer, Factory &>
+    message_pool(std::size_t count, Factory make) : free_(checked_count(count))
+    {
+        slots_.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            slots_.push_back(slot{make()});
+            // Cannot fail: the free queue's capacity is count.
+            free_.try_push(static_cast<handle>(i));
+        }
+    }
+
+    // Producer side. Non-blocking: returns nullopt if every buffer is in flight.
+    std::optional<handle> try_acquire()
+    {
+        return free_.try_pop();
+    }
+
+    // Producer side. Blocking: waits until a buffer is released. Returns nullopt only if the
+    // pool is closed and every buffer is in flight.
+    std::optional<handle> acquire()
+    {
+        return free_.pop();
+    }
+
+    // Consumer side: hands h back to the producer. Never blocks.
+    void release(handle h)
+    {
+        free_.try_push(h);
+    }
+
+    // The buffer behind h. Only the side currently holding h may access it.
+    Buffer &operator[](handle h)
+    {
+        return slots_[h].buffer;
+    }
+
+    const Buffer &operator[](handle h) const
+    {
+        return slots_[h].buffer;
+    }
+
+    // Total number of buffers.
+    std::size_t size() const
+    {
+        return slots_.size();
+    }
+
+    // Buffers ready to be acquired; exact only on the producer thread.
+    std::size_t available() const
+    {
+        return free_.approx_size();
+    }
+
+    // Shutdown: wakes a producer blocked in acquire(). Buffers already released can still be
+    // acquired; handles released afterwards are discarded.
+    void close()
+    {
+        free_.close();
+    }
+
+    bool closed() const
+    {
+        return free_.closed();
+    }
+
+    // Let's not allow copying or moving the pool
+    message_pool(const message_pool &) = delete;
+    message_pool &operator=(const message_pool &) = delete;
+    message_pool(message_pool &&) = delete;
+    message_pool &operator=(message_pool &&) = delete;
+
+private:
+    static constexpr std::size_t cacheline_size = 64;
+
+    struct alignas(cacheline_size) slot
+    {
+        Buffer buffer;
+    };
+
+    static std::size_t checked_count(std::size_t count)
+    {
+        if (count == 0 || count > std::numeric_limits<handle>::max())
+        {
+            throw std::invalid_argument("Invalid count: " + std::to_string(count));
+        }
+        return count;
+    }
+
+    std::vector<slot> slots_;
+    atomic_spsc_queue<handle, modulo_index_policy, WaitPolicy> free_;
+};
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/// @brief Page size requested by mmap_options::huge_pages.
+///
+/// - none: normal pages.
+/// - transparent: normal mapping rounded up to 2MB and marked MADV_HUGEPAGE, so the kernel
+///   may back it with transparent huge pages.
+/// - huge_2mb / huge_1gb: explicit hugetlb pages (MAP_HUGETLB). These need pages reserved in
+///   /proc/sys/vm/nr_hugepages (or the 1GB pool); if none are free the allocation falls back
+///   to transparent, and from there to normal pages if THP is disabled.
+///
+/// Any huge page size rounds the mapping up to that size, also when it falls back.
+
+enum class mmap_huge_pages
+{
+    none,
+    transparent,
+    huge_2mb,
+    huge_1gb,
+};
+
+/// @brief Placement options for mmap_allocator.
+///
+/// - numa_node: NUMA node the pages are bound to, or -1 to keep the default
+///   (first-touch) policy.
+/// - prefault: touch every page inside allocate(), so the pages are populated right away on
+///   the allocating thread's node (or on numa_node) instead of on whichever thread writes
+///   them first. With huge pages this also means the first lap of a ring takes no page faults.
+/// - huge_pages: back the mapping with huge pages to cut TLB misses on large rings, see
+///   mmap_huge_pages.
+/// - lock: mlock() the mapping so it is never swapped out. Best effort: it fails silently
+///   beyond RLIMIT_MEMLOCK. Locking also populates the pages.
+
+struct mmap_options
+{
+    int numa_node = -1;
+    bool prefault = false;
+    mmap_huge_pages huge_pages = mmap_huge_pages::none;
+    bool lock = false;
+};
+
+/// @class mmap_allocator
+/// @brief Page-granular allocator for ring buffers with NUMA placement control.
+///
+/// @details
+/// Every allocation is its own anonymous mmap() rounded up to whole pages, so its placement
+/// policy does not affect, and is not affected by, other heap allocations.
+///
+/// - A NUMA node is applied with the raw mbind() syscall (MPOL_BIND), so no libnuma is needed
+///   at build or run time. Binding is best effort: if the kernel rejects it (single-node
+///   kernel, node out of range, syscall filtered), the pages keep the default policy.
+/// - Without a node, Linux places each page on the node of the thread that first writes it.
+///   To have the ring first-touched by the consumer, construct the queue on the consumer's
+///   thread (or a thread pinned to its CPU) with prefault enabled.
+///
+/// - Huge pages and locking fall back the same way: a MAP_HUGETLB mapping that cannot be
+///   satisfied is retried as a transparent huge page mapping, and a failing mlock() is ignored.
+///
+/// On other platforms allocations fall back to aligned operator new; numa_node, huge_pages and
+/// lock are ignored and prefault still touches the pages.
+///
+/// Plug it into atomic_spsc_queue through its Allocator parameter:
+///   atomic_spsc_queue<T, modulo_index_policy, spin_yield_wait, mmap_allocator<T>>
+///       q(capacity, mmap_allocator<T>({.numa_node = 1}));
+
+template <class T>
+class mmap_allocator
+{
+public:
+    using value_type = T;
+
+    mmap_allocator() = default;
+
+    explicit mmap_allocator(mmap_options options) : options_(options) {}
+
+    template <class U>
+    mmap_allocator(const mmap_allocator<U> &other) : options_(other.options()) {}
+
+    T *allocate(std::size_t n)
+    {
+        if (n > (std::numeric_limits<std::size_t>::max() - granule()) / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+        const std::size_t bytes = mapping_size(n);
+
+#if defined(__linux__)
+        void *p = MAP_FAILED;
+        if (options_.huge_pages == mmap_huge_pages::huge_2mb || options_.huge_pages == mmap_huge_pages::huge_1gb)
+        {
+            // log2 of the page size, as MAP_HUGE_2MB/MAP_HUGE_1GB from <linux/mman.h> encode it.
+            const int size_flag = (options_.huge_pages == mmap_huge_pages::huge_2mb ? 21 : 30) << MAP_HUGE_SHIFT;
+            p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | size_flag, -1, 0);
+        }
+        if (p == MAP_FAILED)
+        {
+            p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED)
+            {
+                throw std::bad_alloc();
+            }
+            if (options_.huge_pages != mmap_huge_pages::none)
+            {
+                // Failure only means THP is disabled; the mapping keeps normal pages.
+                ::madvise(p, bytes, MADV_HUGEPAGE);
+            }
+        }
+        if (options_.numa_node >= 0)
+        {
+            bind_to_node(p, bytes, options_.numa_node);
+        }
+        if (options_.lock)
+        {
+            ::mlock(p, bytes);
+        }
+#else
+        void *p = ::operator new(bytes, std::align_val_t{page_size()});
+#endif
+
+        if (options_.prefault)
+        {
+            // One write per (normal) page is enough to populate it, whatever backs it.
+            for (std::size_t offset = 0; offset < bytes; offset += page_size())
+            {
+                static_cast<volatile unsigned char *>(p)[offset] = 0;
+            }
+        }
+        return static_cast<T *>(p);
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept
+    {
+#if defined(__linux__)
+        ::munmap(p, mapping_size(n));
+#else
+        ::operator delete(p, std::align_val_t{page_size()});
+#endif
+    }
+
+    const mmap_options &options() const
+    {
+        return options_;
+    }
+
+    template <class U>
+    bool operator==(const mmap_allocator<U> &other) const
+    {
+        return options_.numa_node == other.options().numa_node && options_.prefault == other.options().prefault &&
+               options_.huge_pages == other.options().huge_pages && options_.lock == other.options().lock;
+    }
+
+    static std::size_t page_size()
+    {
+#if defined(__linux__)
+        static const std::size_t size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        return size;
+#else
+        return 4096;
+#endif
+    }
+
+private:
+    // Mappings are whole multiples of this, so deallocate() computes the same size whether or
+    // not the huge pages were granted.
+    std::size_t granule() const
+    {
+        switch (options_.huge_pages)
+        {
+        case mmap_huge_pages::none:
+            return page_size();
+        case mmap_huge_pages::transparent:
+        case mmap_huge_pages::huge_2mb:
+            return std::size_t{1} << 21;
+        case mmap_huge_pages::huge_1gb:
+            return std::size_t{1} << 30;
+        }
+        return page_size();
+    }
+
+    std::size_t mapping_size(std::size_t n) const
+    {
+        const std::size_t size = granule();
+        return (n * sizeof(T) + size - 1) / size * size;
+    }
+
+#if defined(__linux__)
+    static void bind_to_node(void *p, std::size_t bytes, int node)
+    {
+        constexpr std::size_t word_bits = std::numeric_limits<unsigned long>::digits;
+        std::vector<unsigned long> mask(static_cast<std::size_t>(node) / word_bits + 1, 0);
+        mask.back() = 1UL << (static_cast<std::size_t>(node) % word_bits);
+
+        // maxnode counts one past the last bit the kernel reads from mask.
+        ::syscall(SYS_mbind, p, bytes, MPOL_BIND, mask.data(), mask.size() * word_bits + 1, 0U);
+    }
+#endif
+
+    mmap_options options_{};
+};
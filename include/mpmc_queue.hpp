@@ -0,0 +1,551 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "wait_policies.hpp"
+
+/// @class mp_queue
+/// @brief Bounded multi-producer queue with per-slot sequence numbers (Vyukov style).
+///
+/// @tparam T The type of elements stored in the queue. Must be movable.
+/// @tparam WaitPolicy How blocking operations wait, see wait_policies.hpp. Only policies without
+/// notifications (derived from no_notify_wait) are accepted: park_wait tracks a single parked
+/// waiter per side and would lose wake-ups with several producers or consumers.
+/// @tparam MultiConsumer false for a single consumer (mpsc_queue), true for several (mpmc_queue).
+///
+/// @details
+/// Use the aliases mpsc_queue<T> and mpmc_queue<T>. Both expose the same surface as
+/// atomic_spsc_queue (try_push/push/try_pop/pop, timed and bulk variants, try_consume,
+/// close/done/capacity/size), so they drop into code written against the SPSC queues.
+///
+/// - Every slot carries a sequence number that tells which lap of the ring it belongs to and
+///   whether it is free or full. With pos a free-running 64-bit position:
+///   * 2 * pos     : free, waiting for the producer that claims pos;
+///   * 2 * pos + 1 : full, holding the item pushed at pos.
+///   Releasing the slot moves it to 2 * (pos + capacity), the next lap. The factor 2 keeps the
+///   states apart even for capacity 1.
+/// - Producers claim a position with a CAS on tail_, construct the item and publish the slot
+///   with a release store of its sequence. Producers and consumers never read each other's
+///   index: full/empty is decided by the slot sequence alone.
+/// - With several consumers, they claim positions with a CAS on head_ the same way. A single
+///   consumer owns head_ and advances it with a plain store after releasing the slot, which
+///   also makes front()/pop_front() possible.
+/// - Items are constructed only after their slot is claimed, so a failed try_push() leaves the
+///   argument untouched. If constructing an item throws, the slot is published as a hole that
+///   consumers skip.
+///
+/// Unlike atomic_spsc_queue, bulk operations claim and publish item by item, and creating the
+/// queue writes the sequence of every slot, so the ring pages are touched up front.
+///
+/// @note The queue is non-copyable and non-movable and must outlive all threads accessing it.
+
+template <class T, class WaitPolicy, bool MultiConsumer>
+    requires std::movable<T> && wait_policy<WaitPolicy> && std::derived_from<WaitPolicy, no_notify_wait>
+class mp_queue
+{
+public:
+    using value_type = T;
+
+    explicit mp_queue(std::size_t capacity) : capacity_(capacity)
+    {
+        if (capacity_ == 0)
+        {
+            throw std::invalid_argument("Invalid capacity: " + std::to_string(capacity_));
+        }
+        slots_ = std::make_unique_for_overwrite<slot[]>(capacity_);
+        for (std::size_t i = 0; i < capacity_; ++i)
+        {
+            slots_[i].seq.store(2 * static_cast<std::uint64_t>(i), std::memory_order_relaxed);
+        }
+    }
+
+    // Non-blocking push. Returns false if queue is full or closed.
+    template <typename U>
+        requires std::constructible_from<T, U &&>
+    bool try_push(U &&item)
+    {
+        return try_emplace(std::forward<U>(item));
+    }
+
+    // Non-blocking push constructing the item directly in its slot from args.
+    // Returns false (without using args) if queue is full or closed.
+    template <typename... Args>
+        requires std::constructible_from<T, Args &&...>
+    bool try_emplace(Args &&...args)
+    {
+        if (closed_.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        std::uint64_t pos = 0;
+        slot *s = claim_push(pos);
+        if (s == nullptr)
+        {
+            return false;
+        }
+
+        // Another producer may have closed the queue since the check above, and the consumer may
+        // already have seen done(). The claim and this load are seq_cst, as are close() and
+        // done(): either done() sees pos in tail_ and waits for it, or this load sees the close
+        // and the slot becomes a hole.
+        if (closed_.load(std::memory_order_seq_cst))
+        {
+            publish(*s, pos, false);
+            return false;
+        }
+
+        try
+        {
+            std::construct_at(s->item(), std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            publish(*s, pos, false);
+            throw;
+        }
+        publish(*s, pos, true);
+        return true;
+    }
+
+    // Blocking push. Returns false if queue gets closed while waiting.
+    template <typename U>
+        requires std::constructible_from<T, U &&>
+    bool push(U &&item)
+    {
+        return push_until_deadline(std::forward<U>(item), no_deadline);
+    }
+
+    // Timed blocking push. Returns false if queue gets closed or the deadline passes while waiting.
+    template <typename U, class Clock, class Duration>
+        requires std::constructible_from<T, U &&>
+    bool push_until(U &&item, const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        return push_until_deadline(std::forward<U>(item), to_steady_deadline(deadline));
+    }
+
+    // Timed blocking push. Returns false if queue gets closed or timeout expires while waiting.
+    template <typename U, class Rep, class Period>
+        requires std::constructible_from<T, U &&>
+    bool push_for(U &&item, const std::chrono::duration<Rep, Period> &timeout)
+    {
+        return push_until_deadline(std::forward<U>(item), deadline_after(timeout));
+    }
+
+    // Non-blocking pop. Returns nullopt if queue is empty.
+    std::optional<T> try_pop()
+    {
+        std::optional<T> value;
+        consume_one([&](T &item)
+                    { value.emplace(std::move(item)); });
+        return value;
+    }
+
+    // Non-blocking in-place consume. Invokes f on the oldest item while it is still in its slot,
+    // then releases the slot. Returns false (without invoking f) if queue is empty.
+    // If f throws, a single consumer keeps the item in the queue; with several consumers the slot
+    // is already claimed, so the item is destroyed and released before the exception propagates.
+    template <typename F>
+        requires std::invocable<F, T &>
+    bool try_consume(F &&f)
+    {
+        return consume_one(f);
+    }
+
+    // Consumer-side access to the oldest item without removing it. Returns nullptr if queue is empty.
+    // Single consumer only: with several consumers another one could take the item.
+    T *front()
+        requires(!MultiConsumer)
+    {
+        std::uint64_t pos = 0;
+        slot *s = claim_pop(pos);
+        return s == nullptr ? nullptr : s->item();
+    }
+
+    // Removes the oldest item. Must only be called after front() returned a non-null pointer.
+    void pop_front()
+        requires(!MultiConsumer)
+    {
+        const std::uint64_t pos = head_.load(std::memory_order_relaxed);
+        slot &s = slots_[slot_of(pos)];
+        std::destroy_at(s.item());
+        release(s, pos);
+    }
+
+    // Blocking pop. Returns nullopt if queue is closed and empty.
+    std::optional<T> pop()
+    {
+        return pop_until_deadline(no_deadline);
+    }
+
+    // Timed blocking pop. Returns nullopt if queue is closed and empty, or the deadline passes while waiting.
+    template <class Clock, class Duration>
+    std::optional<T> pop_until(const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        return pop_until_deadline(to_steady_deadline(deadline));
+    }
+
+    // Timed blocking pop. Returns nullopt if queue is closed and empty, or timeout expires while waiting.
+    template <class Rep, class Period>
+    std::optional<T> pop_for(const std::chrono::duration<Rep, Period> &timeout)
+    {
+        return pop_until_deadline(deadline_after(timeout));
+    }
+
+    // Non-blocking bulk push. Pushes items from [first, last) until the queue is full or closed.
+    // Returns the number of items pushed.
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+        requires std::constructible_from<T, std::iter_reference_t<InputIt>>
+    std::size_t try_push_n(InputIt first, Sentinel last)
+    {
+        std::size_t pushed = 0;
+        for (; first != last && try_push(*first); ++first)
+        {
+            ++pushed;
+        }
+        return pushed;
+    }
+
+    // Blocking bulk push. Returns the number of items pushed, which is less than the range size
+    // only if queue gets closed.
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+        requires std::constructible_from<T, std::iter_reference_t<InputIt>>
+    std::size_t push_n(InputIt first, Sentinel last)
+    {
+        std::size_t pushed = 0;
+        for (; first != last && push(*first); ++first)
+        {
+            ++pushed;
+        }
+        return pushed;
+    }
+
+    // Non-blocking bulk pop. Moves up to max items into out. Returns the number of items popped.
+    template <typename OutputIt>
+        requires std::output_iterator<OutputIt, T &&>
+    std::size_t try_pop_n(OutputIt out, std::size_t max)
+    {
+        std::size_t popped = 0;
+        while (popped < max && consume_one([&](T &item)
+                                           { *out = std::move(item); ++out; }))
+        {
+            ++popped;
+        }
+        return popped;
+    }
+
+    // Blocking bulk pop. Waits until at least one item is available, then moves up to max items into out.
+    // Returns the number of items popped; 0 only if queue is closed and empty (or max is 0).
+    template <typename OutputIt>
+        requires std::output_iterator<OutputIt, T &&>
+    std::size_t pop_n(OutputIt out, std::size_t max)
+    {
+        if (max == 0)
+        {
+            return 0;
+        }
+
+        auto first = pop();
+        if (!first.has_value())
+        {
+            return 0;
+        }
+        *out = std::move(*first);
+        ++out;
+        return 1 + try_pop_n(out, max - 1);
+    }
+
+    // Number of claimed positions not yet released, clamped to [0, capacity()]. Items being
+    // pushed or popped at this moment are included.
+    std::size_t size() const
+    {
+        const std::uint64_t h = head_.load(std::memory_order_acquire);
+        const std::uint64_t t = tail_.load(std::memory_order_acquire);
+        return t <= h ? 0 : std::min(static_cast<std::size_t>(t - h), capacity_);
+    }
+
+    // Monitoring variant of size() with relaxed loads.
+    std::size_t approx_size() const
+    {
+        const std::uint64_t h = head_.load(std::memory_order_relaxed);
+        const std::uint64_t t = tail_.load(std::memory_order_relaxed);
+        return t <= h ? 0 : std::min(static_cast<std::size_t>(t - h), capacity_);
+    }
+
+    std::size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    bool closed() const
+    {
+        return closed_.load(std::memory_order_acquire);
+    }
+
+    // True only when close() has been called and all queued items are drained.
+    bool done() const
+    {
+        if (!closed_.load(std::memory_order_seq_cst))
+        {
+            return false;
+        }
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_seq_cst);
+    }
+
+    // Any producer may close the queue while others push: a racing push either fails or is
+    // delivered before done() returns true.
+    void close()
+    {
+        closed_.store(true, std::memory_order_seq_cst);
+        wait_.notify_close();
+    }
+
+    // Items that were never popped are destroyed here. All producer and consumer threads
+    // must be stopped before destroying the queue.
+    ~mp_queue()
+    {
+        close();
+
+        const std::uint64_t t = tail_.load(std::memory_order_acquire);
+        for (std::uint64_t pos = head_.load(std::memory_order_acquire); pos != t; ++pos)
+        {
+            slot &s = slots_[slot_of(pos)];
+            if (s.seq.load(std::memory_order_acquire) == full_seq(pos) && s.valid)
+            {
+                std::destroy_at(s.item());
+            }
+        }
+    }
+
+    mp_queue(const mp_queue &) = delete;
+    mp_queue &operator=(const mp_queue &) = delete;
+    mp_queue(mp_queue &&) = delete;
+    mp_queue &operator=(mp_queue &&) = delete;
+
+private:
+    struct slot
+    {
+        std::atomic<std::uint64_t> seq;
+        // False for a hole left by a throwing constructor. Published by the release store of seq.
+        bool valid;
+        alignas(T) std::byte storage[sizeof(T)];
+
+        T *item()
+        {
+            return std::launder(reinterpret_cast<T *>(storage));
+        }
+    };
+
+    static std::uint64_t free_seq(std::uint64_t pos)
+    {
+        return 2 * pos;
+    }
+
+    static std::uint64_t full_seq(std::uint64_t pos)
+    {
+        return 2 * pos + 1;
+    }
+
+    std::size_t slot_of(std::uint64_t pos) const
+    {
+        return static_cast<std::size_t>(pos % capacity_);
+    }
+
+    // Claims the next free position for a producer. Returns its slot, or nullptr if queue is full.
+    slot *claim_push(std::uint64_t &pos)
+    {
+        pos = tail_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            slot &s = slots_[slot_of(pos)];
+            const auto diff = static_cast<std::int64_t>(s.seq.load(std::memory_order_acquire) - free_seq(pos));
+            if (diff == 0)
+            {
+                // On failure pos is reloaded with the current tail_. seq_cst orders the claim
+                // before try_emplace()'s second closed_ check.
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    return &s;
+                }
+            }
+            else if (diff < 0)
+            {
+                // The slot still holds the item of the previous lap.
+                return nullptr;
+            }
+            else
+            {
+                // Another producer claimed pos; retry at the current tail.
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Finds the oldest published item. A single consumer only peeks (head_ moves in release());
+    // several consumers claim the position with a CAS on head_. Holes are released and skipped.
+    // Returns nullptr if queue is empty.
+    slot *claim_pop(std::uint64_t &pos)
+    {
+        pos = head_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            slot &s = slots_[slot_of(pos)];
+            const auto diff = static_cast<std::int64_t>(s.seq.load(std::memory_order_acquire) - full_seq(pos));
+            if (diff == 0)
+            {
+                if constexpr (MultiConsumer)
+                {
+                    if (!head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        continue;
+                    }
+                }
+                if (s.valid)
+                {
+                    return &s;
+                }
+                release(s, pos);
+                pos = head_.load(std::memory_order_relaxed);
+            }
+            else if (diff < 0)
+            {
+                // Not published yet: the producer of pos has not finished (or not started).
+                return nullptr;
+            }
+            else
+            {
+                // Another consumer claimed pos; retry at the current head.
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void publish(slot &s, std::uint64_t pos, bool valid)
+    {
+        s.valid = valid;
+        s.seq.store(full_seq(pos), std::memory_order_release);
+        wait_.notify_items();
+    }
+
+    // Hands the slot of pos to the producer of the next lap.
+    void release(slot &s, std::uint64_t pos)
+    {
+        s.seq.store(free_seq(pos + capacity_), std::memory_order_release);
+        if constexpr (!MultiConsumer)
+        {
+            head_.store(pos + 1, std::memory_order_release);
+        }
+        wait_.notify_space();
+    }
+
+    // Invokes f on the oldest item, then destroys it and releases its slot.
+    template <typename F>
+    bool consume_one(F &&f)
+    {
+        std::uint64_t pos = 0;
+        slot *s = claim_pop(pos);
+        if (s == nullptr)
+        {
+            return false;
+        }
+
+        if constexpr (MultiConsumer)
+        {
+            try
+            {
+                std::invoke(f, *s->item());
+            }
+            catch (...)
+            {
+                std::destroy_at(s->item());
+                release(*s, pos);
+                throw;
+            }
+        }
+        else
+        {
+            std::invoke(f, *s->item());
+        }
+        std::destroy_at(s->item());
+        release(*s, pos);
+        return true;
+    }
+
+    template <typename U>
+    bool push_until_deadline(U &&item, std::chrono::steady_clock::time_point deadline)
+    {
+        std::size_t spin = 0;
+
+        while (!closed())
+        {
+            if (try_push(std::forward<U>(item)))
+            {
+                return true;
+            }
+
+            if (!wait_.wait_for_space(spin, [this]
+                                      { return closed() || approx_size() < capacity_; }, deadline))
+            {
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    std::optional<T> pop_until_deadline(std::chrono::steady_clock::time_point deadline)
+    {
+        for (std::size_t spin = 0;;)
+        {
+            auto item = try_pop();
+            if (item.has_value())
+            {
+                return item;
+            }
+
+            if (done())
+            {
+                return std::nullopt;
+            }
+
+            if (!wait_.wait_for_items(spin, [this]
+                                      { return closed() || approx_size() != 0; }, deadline))
+            {
+                return std::nullopt;
+            }
+        }
+    }
+
+    static constexpr std::size_t cacheline_size = 64;
+
+    const std::size_t capacity_;
+    std::unique_ptr<slot[]> slots_;
+    // Consumer side: next position to pop.
+    alignas(cacheline_size)
+        std::atomic<std::uint64_t> head_ = 0;
+    // Producer side: next position to claim.
+    alignas(cacheline_size)
+        std::atomic<std::uint64_t> tail_ = 0;
+    alignas(cacheline_size)
+        std::atomic<bool> closed_ = false;
+    [[no_unique_address]] WaitPolicy wait_;
+};
+
+template <class T, class WaitPolicy = spin_yield_wait>
+using mpsc_queue = mp_queue<T, WaitPolicy, false>;
+
+template <class T, class WaitPolicy = spin_yield_wait>
+using mpmc_queue = mp_queue<T, WaitPolicy, true>;
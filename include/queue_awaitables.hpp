@@ -0,0 +1,237 @@
+#pragma once
+
+#include <atomic>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <utility>
+
+#include "wait_policies.hpp"
+
+/// @brief C++20 awaitables for the queues: co_await q.async_pop() / co_await q.async_push(x).
+///
+/// An awaitable first tries the non-blocking operation. If the queue is empty (full), it
+/// registers the coroutine with the queue and suspends; the other side resumes it after it
+/// publishes items (releases slots) or closes the queue. async_pop() then yields the item, or
+/// nullopt once the queue is closed and drained; async_push() yields true, or false if the
+/// queue got closed. A thread never blocks, so one event loop can serve many queue endpoints.
+///
+/// Resumption goes through Post, a callable taking the std::coroutine_handle<>:
+/// - inline_resume (default) resumes the coroutine right away, on the thread that pushed,
+///   popped or closed, inside that call. Fine when both ends run on the same thread.
+/// - Anything else is an executor hook, e.g. [&loop](std::coroutine_handle<> h) { loop.post(h); },
+///   which hands the coroutine back to its own event loop. Needed when the other side runs on
+///   a different thread.
+///
+/// A wake can be stale, e.g. meant for an item the coroutine already took before suspending.
+/// The awaitable then re-registers from the waking thread instead of resuming, so a resumed
+/// coroutine always finds an item (free slot) or a closed queue.
+///
+/// One coroutine per side may wait at a time (the queues are SPSC). The awaitable lives in the
+/// awaiting coroutine's frame; it must not be co_awaited twice.
+///
+/// simple_spsc_queue supports the awaitables with any configuration. atomic_spsc_queue needs
+/// the async_wait policy below, which holds its two waiter slots.
+
+// A coroutine suspended on a queue. The side that makes it ready calls resume(*this).
+struct async_waiter
+{
+    std::coroutine_handle<> handle;
+    void (*resume)(async_waiter &) = nullptr;
+};
+
+// Post that resumes the coroutine on the notifying thread.
+struct inline_resume
+{
+    void operator()(std::coroutine_handle<> h) const
+    {
+        h.resume();
+    }
+};
+
+/// @brief Wait policy for atomic_spsc_queue with async_pop()/async_push() support.
+///
+/// Blocking operations behave like spin_yield_wait. Each side has one waiter slot, where an
+/// awaitable registers itself before suspending; publishing items, releasing slots and close()
+/// take the waiter out of the slot and resume it. Like park_wait, every publish pays a seq_cst
+/// fence, so the slot check cannot miss a coroutine that is about to suspend. Like a futex wake,
+/// a wake may hit a later registration than the one it was meant for; the awaitables re-check.
+
+class async_wait : public spin_yield_wait
+{
+public:
+    // Registers w as the waiting consumer, unless ready() holds once registered.
+    // Returns true if the caller should suspend (the producer will resume w).
+    template <typename Ready>
+    bool suspend_consumer(async_waiter &w, Ready &&ready)
+    {
+        return suspend(consumer_, w, ready);
+    }
+
+    // Producer-side counterpart of suspend_consumer().
+    template <typename Ready>
+    bool suspend_producer(async_waiter &w, Ready &&ready)
+    {
+        return suspend(producer_, w, ready);
+    }
+
+    void notify_items()
+    {
+        wake(consumer_);
+    }
+
+    void notify_space()
+    {
+        wake(producer_);
+    }
+
+    void notify_close()
+    {
+        wake(consumer_);
+        wake(producer_);
+    }
+
+private:
+    static constexpr std::size_t cacheline_size = 64;
+
+    template <typename Ready>
+    static bool suspend(std::atomic<async_waiter *> &slot, async_waiter &w, Ready &ready)
+    {
+        slot.store(&w, std::memory_order_release);
+        // Pairs with the fence in wake(): either we see the new state or the notifier sees w.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!ready())
+        {
+            return true;
+        }
+        // Ready after all. Take w back, unless a notifier already took it and will resume it.
+        return slot.exchange(nullptr, std::memory_order_acq_rel) != &w;
+    }
+
+    static void wake(std::atomic<async_waiter *> &slot)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (slot.load(std::memory_order_relaxed) == nullptr)
+        {
+            return;
+        }
+        if (async_waiter *w = slot.exchange(nullptr, std::memory_order_acq_rel))
+        {
+            w->resume(*w);
+        }
+    }
+
+    alignas(cacheline_size) std::atomic<async_waiter *> consumer_ = nullptr;
+    alignas(cacheline_size) std::atomic<async_waiter *> producer_ = nullptr;
+};
+
+template <class P>
+concept async_wait_policy = wait_policy<P> && requires(P p, async_waiter &w, bool (*ready)()) {
+    { p.suspend_consumer(w, ready) } -> std::same_as<bool>;
+    { p.suspend_producer(w, ready) } -> std::same_as<bool>;
+};
+
+// Awaitable returned by async_pop(). Queue provides suspend_consumer(async_waiter &), which
+// registers the waiter unless an item is available or the queue is closed.
+template <class Queue, class Post>
+class queue_pop_awaitable : private async_waiter
+{
+public:
+    using value_type = typename Queue::value_type;
+
+    queue_pop_awaitable(Queue &q, Post post) : q_(q), post_(std::move(post)) {}
+
+    bool await_ready()
+    {
+        result_ = q_.try_pop();
+        return result_.has_value() || q_.done();
+    }
+
+    bool await_suspend(std::coroutine_handle<> h)
+    {
+        handle = h;
+        resume = &resume_with_post;
+        return q_.suspend_consumer(*this);
+    }
+
+    // Only the consumer pops, so an item that woke us up is still there.
+    std::optional<value_type> await_resume()
+    {
+        if (!result_.has_value())
+        {
+            result_ = q_.try_pop();
+        }
+        return std::move(result_);
+    }
+
+private:
+    // Runs on the waking thread. A stale wake re-registers the waiter instead of resuming it.
+    static void resume_with_post(async_waiter &w)
+    {
+        auto &self = static_cast<queue_pop_awaitable &>(w);
+        if (!self.q_.suspend_consumer(self))
+        {
+            std::invoke(self.post_, self.handle);
+        }
+    }
+
+    Queue &q_;
+    Post post_;
+    std::optional<value_type> result_;
+};
+
+// Awaitable returned by async_push(). Holds the item until it is pushed; dropped if the queue
+// gets closed first. Queue provides suspend_producer(async_waiter &).
+template <class Queue, class Post>
+class queue_push_awaitable : private async_waiter
+{
+public:
+    using value_type = typename Queue::value_type;
+
+    template <typename U>
+    queue_push_awaitable(Queue &q, U &&item, Post post) : q_(q), post_(std::move(post)), item_(std::forward<U>(item))
+    {
+    }
+
+    // try_push() only moves from item_ when it succeeds.
+    bool await_ready()
+    {
+        pushed_ = q_.try_push(std::move(item_));
+        return pushed_ || q_.closed();
+    }
+
+    bool await_suspend(std::coroutine_handle<> h)
+    {
+        handle = h;
+        resume = &resume_with_post;
+        return q_.suspend_producer(*this);
+    }
+
+    // Only the producer pushes, so the space that woke us up is still there.
+    bool await_resume()
+    {
+        if (!pushed_)
+        {
+            pushed_ = q_.try_push(std::move(item_));
+        }
+        return pushed_;
+    }
+
+private:
+    // Runs on the waking thread. A stale wake re-registers the waiter instead of resuming it.
+    static void resume_with_post(async_waiter &w)
+    {
+        auto &self = static_cast<queue_push_awaitable &>(w);
+        if (!self.q_.suspend_producer(self))
+        {
+            std::invoke(self.post_, self.handle);
+        }
+    }
+
+    Queue &q_;
+    Post post_;
+    value_type item_;
+    bool pushed_ = false;
+};
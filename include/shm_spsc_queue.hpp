@@ -0,0 +1,859 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bulk_copy.hpp"
+#include "wait_policies.hpp"
+
+/// @brief Options for the shared region of an shm_spsc_queue.
+///
+/// - huge_pages: back the region with huge pages. Anonymous (memfd) regions use MFD_HUGETLB and
+///   fall back to normal pages if none are reserved; named regions ask for transparent huge
+///   pages with madvise(). Best effort either way.
+/// - prefault: populate the mapping with MAP_POPULATE, so the first lap does not page-fault.
+
+struct shm_options
+{
+    bool huge_pages = false;
+    bool prefault = false;
+};
+
+namespace detail
+{
+    /// Header at the start of every shared region. Everything a second process needs to attach
+    /// lives here, and nothing process-specific (no pointers, no cached indices). Bump
+    /// shm_layout_version whenever the layout changes, so mismatched builds refuse to attach.
+    struct shm_queue_header
+    {
+        static constexpr std::size_t cacheline_size = 64;
+
+        // Written last by the creator, with release, once the rest of the header is valid.
+        std::atomic<std::uint64_t> magic;
+        std::uint32_t version;
+        std::uint32_t value_size;
+        std::uint32_t value_align;
+        std::uint64_t capacity;
+        // Offset of the first slot from the start of the region.
+        std::uint64_t ring_offset;
+        // head, tail and closed each on their own cache line, as in atomic_spsc_queue.
+        alignas(cacheline_size) std::atomic<std::uint64_t> head;
+        alignas(cacheline_size) std::atomic<std::uint64_t> tail;
+        alignas(cacheline_size) std::atomic<bool> closed;
+    };
+
+    inline constexpr std::uint64_t shm_magic = 0x3168'6d73'6373'7073; // "spscshm1", little endian
+    inline constexpr std::uint32_t shm_layout_version = 1;
+
+    // The atomics are shared between processes, which is only defined for lock-free atomics.
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<bool>::is_always_lock_free);
+
+    [[noreturn]] inline void throw_errno(const char *what)
+    {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+} // namespace detail
+
+/// @class shm_spsc_queue
+/// @brief A single-producer, single-consumer (SPSC) bounded queue in shared memory, for
+/// passing items between processes.
+///
+/// @tparam T The type of elements stored in the queue. Must be trivially copyable, since the
+/// other process reads the bytes as they are; in particular T must not contain pointers.
+/// @tparam WaitPolicy How blocking operations wait. Only policies without notifications are
+/// accepted: park_wait keeps its state in the process that owns the queue object.
+///
+/// @details
+/// Same algorithm as atomic_spsc_queue (free-running head/tail counters, cached remote indices,
+/// release/acquire publishing), but the counters, closed flag and ring live in one mapped region:
+///
+///   [shm_queue_header: metadata | head | tail | closed][ring: capacity slots]
+///
+/// The cached copies of the remote indices stay in the process-local queue object.
+///
+/// - create(name, capacity): creates a named POSIX shared memory object (shm_open) that another
+///   process opens with attach(name). The creator unlinks the name on destruction; processes that
+///   already attached keep their mapping.
+/// - shm_spsc_queue(capacity): creates an anonymous memfd region. Share fd() with another process
+///   (inherit it across fork(), or send it over a Unix socket), which opens it with attach(fd).
+/// - attach() checks the magic, layout version, sizeof(T), alignof(T) and capacity stored in the
+///   header, and throws std::runtime_error on a mismatch. System call failures throw std::system_error.
+///
+/// Exactly one process (thread) pushes and one pops. Destroying any queue object closes the queue.
+///
+/// @note The queue is non-copyable and non-movable; create() and attach() rely on guaranteed
+/// copy elision (auto q = shm_spsc_queue<T>::attach("/feed");).
+
+template <class T, class WaitPolicy = spin_yield_wait>
+    requires std::is_trivially_copyable_v<T> && wait_policy<WaitPolicy> && std::derived_from<WaitPolicy, no_notify_wait>
+class shm_spsc_queue
+{
+public:
+    using value_type = T;
+
+    // Anonymous region, see fd().
+    explicit shm_spsc_queue(std::size_t capacity, shm_options options = {})
+        : shm_spsc_queue(create_memfd(checked_region_size(capacity, options), options), "", capacity, options)
+    {
+    }
+
+    // Creates the named region; fails if it already exists. name follows shm_open(), e.g. "/feed".
+    static shm_spsc_queue create(const std::string &name, std::size_t capacity, shm_options options = {})
+    {
+        const std::size_t bytes = checked_region_size(capacity, options);
+        const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if (fd < 0)
+        {
+            detail::throw_errno("shm_open");
+        }
+        if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0)
+        {
+            const int error = errno;
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            errno = error;
+            detail::throw_errno("ftruncate");
+        }
+        return shm_spsc_queue(region_fd{fd, false}, name, capacity, options);
+    }
+
+    // Attaches to a region created by create(name).
+    static shm_spsc_queue attach(const std::string &name, shm_options options = {})
+    {
+        const int fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            detail::throw_errno("shm_open");
+        }
+        return shm_spsc_queue(region_fd{fd, false}, name, 0, options);
+    }
+
+    // Attaches to the region behind fd, e.g. the fd() of an anonymous queue. fd is duplicated,
+    // so the caller keeps ownership of it.
+    static shm_spsc_queue attach(int fd, shm_options options = {})
+    {
+        const int dup = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        if (dup < 0)
+        {
+            detail::throw_errno("fcntl");
+        }
+        return shm_spsc_queue(region_fd{dup, false}, "", 0, options);
+    }
+
+    // Non-blocking push. Returns false if queue is full or closed.
+    template <typename U>
+        requires std::constructible_from<T, U &&>
+    bool try_push(U &&item)
+    {
+        return try_emplace(std::forward<U>(item));
+    }
+
+    // Non-blocking push constructing the item directly in its slot from args.
+    // Returns false if queue is full or closed.
+    template <typename... Args>
+        requires std::constructible_from<T, Args &&...>
+    bool try_emplace(Args &&...args)
+    {
+        if (closed())
+        {
+            return false;
+        }
+        const std::uint64_t t = header_->tail.load(std::memory_order_relaxed);
+
+        // Full if capacity_ items are in flight. Refresh the cached head only when it says full.
+        if (t - head_cache_ == capacity_)
+        {
+            head_cache_ = header_->head.load(std::memory_order_acquire);
+            if (t - head_cache_ == capacity_)
+            {
+                return false;
+            }
+        }
+
+        std::construct_at(ring_ + slot(t), std::forward<Args>(args)...);
+
+        publish_tail(t + 1);
+        return true;
+    }
+
+    // Blocking push. Returns false if queue gets closed while waiting.
+    template <typename U>
+        requires std::constructible_from<T, U &&>
+    bool push(U &&item)
+    {
+        return push_until_deadline(std::forward<U>(item), no_deadline);
+    }
+
+    // Timed blocking push. Returns false if queue gets closed or the deadline passes while waiting.
+    template <typename U, class Clock, class Duration>
+        requires std::constructible_from<T, U &&>
+    bool push_until(U &&item, const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        return push_until_deadline(std::forward<U>(item), to_steady_deadline(deadline));
+    }
+
+    // Timed blocking push. Returns false if queue gets closed or timeout expires while waiting.
+    template <typename U, class Rep, class Period>
+        requires std::constructible_from<T, U &&>
+    bool push_for(U &&item, const std::chrono::duration<Rep, Period> &timeout)
+    {
+        return push_until_deadline(std::forward<U>(item), deadline_after(timeout));
+    }
+
+    // Non-blocking pop. Returns nullopt if queue is empty.
+    std::optional<T> try_pop()
+    {
+        T *item = front();
+        if (item == nullptr)
+        {
+            return std::nullopt;
+        }
+
+        T value = *item;
+        pop_front();
+        return value;
+    }
+
+    // Non-blocking in-place consume. Invokes f on the oldest item while it is still in its slot,
+    // then releases the slot. Returns false (without invoking f) if queue is empty.
+    // If f throws, the item stays in the queue.
+    template <typename F>
+        requires std::invocable<F, T &>
+    bool try_consume(F &&f)
+    {
+        T *item = front();
+        if (item == nullptr)
+        {
+            return false;
+        }
+
+        std::invoke(std::forward<F>(f), *item);
+        pop_front();
+        return true;
+    }
+
+    // Consumer-side access to the oldest item without removing it. Returns nullptr if queue is empty.
+    // The pointer stays valid until the item is removed by pop_front(), try_pop() or try_consume().
+    T *front()
+    {
+        const std::uint64_t h = header_->head.load(std::memory_order_relaxed);
+
+        // Empty if head catches tail. Refresh the cached tail only when it says empty.
+        if (h == tail_cache_)
+        {
+            tail_cache_ = header_->tail.load(std::memory_order_acquire);
+            if (h == tail_cache_)
+            {
+                return nullptr;
+            }
+        }
+
+        return ring_ + slot(h);
+    }
+
+    // Removes the oldest item. Must only be called after front() returned a non-null pointer.
+    void pop_front()
+    {
+        publish_head(header_->head.load(std::memory_order_relaxed) + 1);
+    }
+
+    // Blocking pop. Returns nullopt if queue is closed and empty.
+    std::optional<T> pop()
+    {
+        return pop_until_deadline(no_deadline);
+    }
+
+    // Timed blocking pop. Returns nullopt if queue is closed and empty, or the deadline passes while waiting.
+    template <class Clock, class Duration>
+    std::optional<T> pop_until(const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        return pop_until_deadline(to_steady_deadline(deadline));
+    }
+
+    // Timed blocking pop. Returns nullopt if queue is closed and empty, or timeout expires while waiting.
+    template <class Rep, class Period>
+    std::optional<T> pop_for(const std::chrono::duration<Rep, Period> &timeout)
+    {
+        return pop_until_deadline(deadline_after(timeout));
+    }
+
+    // Non-blocking bulk push. Pushes as many items from [first, last) as currently fit and
+    // publishes the tail once for the whole batch. Returns the number of items pushed
+    // (0 if queue is full or closed).
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+        requires std::constructible_from<T, std::iter_reference_t<InputIt>>
+    std::size_t try_push_n(InputIt first, Sentinel last)
+    {
+        return push_batch(first, last);
+    }
+
+    // Blocking bulk push. Pushes all items from [first, last), publishing once per batch that fits.
+    // Returns the number of items pushed, which is less than the range size only if queue gets closed.
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+        requires std::constructible_from<T, std::iter_reference_t<InputIt>>
+    std::size_t push_n(InputIt first, Sentinel last)
+    {
+        std::size_t pushed = 0;
+        std::size_t spin = 0;
+
+        while (first != last && !closed())
+        {
+            const std::size_t n = push_batch(first, last);
+            if (n != 0)
+            {
+                pushed += n;
+                spin = 0;
+                continue;
+            }
+
+            wait_.wait_for_space(spin, [this]
+                                 { return space_or_closed(); }, no_deadline);
+        }
+
+        return pushed;
+    }
+
+    // Non-blocking bulk pop. Copies up to max items into out and publishes the head once.
+    // Returns the number of items popped (0 if queue is empty).
+    template <typename OutputIt>
+        requires std::output_iterator<OutputIt, T &&>
+    std::size_t try_pop_n(OutputIt out, std::size_t max)
+    {
+        return pop_batch(out, max);
+    }
+
+    // Blocking bulk pop. Waits until at least one item is available, then copies up to max items into out.
+    // Returns the number of items popped; 0 only if queue is closed and empty (or max is 0).
+    template <typename OutputIt>
+        requires std::output_iterator<OutputIt, T &&>
+    std::size_t pop_n(OutputIt out, std::size_t max)
+    {
+        for (std::size_t spin = 0; max != 0;)
+        {
+            const std::size_t n = pop_batch(out, max);
+            if (n != 0)
+            {
+                return n;
+            }
+
+            if (done())
+            {
+                return 0;
+            }
+
+            wait_.wait_for_items(spin, [this]
+                                 { return items_or_closed(); }, no_deadline);
+        }
+        return 0;
+    }
+
+    // Producer-side zero-copy write, as in atomic_spsc_queue: up to n contiguous free slots
+    // starting at the tail, written in place and published with commit().
+    std::span<T> reserve(std::size_t n)
+    {
+        if (closed())
+        {
+            return {};
+        }
+        const std::uint64_t t = header_->tail.load(std::memory_order_relaxed);
+
+        // Refresh the cached head only if it does not leave room for n slots.
+        std::size_t free = capacity_ - static_cast<std::size_t>(t - head_cache_);
+        if (free < n)
+        {
+            head_cache_ = header_->head.load(std::memory_order_acquire);
+            free = capacity_ - static_cast<std::size_t>(t - head_cache_);
+        }
+
+        const std::size_t start = slot(t);
+        return {ring_ + start, std::min({n, free, capacity_ - start})};
+    }
+
+    // Publishes the first k slots of the span returned by the last reserve(). k must not exceed its size.
+    void commit(std::size_t k)
+    {
+        publish_tail(header_->tail.load(std::memory_order_relaxed) + k);
+    }
+
+    // Consumer-side zero-copy read. Returns a span of the contiguous items starting at the head
+    // (up to the end of the ring), or an empty span if queue is empty. Release them with release().
+    std::span<T> readable()
+    {
+        const std::uint64_t h = header_->head.load(std::memory_order_relaxed);
+        const std::size_t start = slot(h);
+        const std::size_t to_end = capacity_ - start;
+
+        // Refresh the cached tail only if it does not already reach the end of the ring.
+        std::size_t available = static_cast<std::size_t>(tail_cache_ - h);
+        if (available < to_end)
+        {
+            tail_cache_ = header_->tail.load(std::memory_order_acquire);
+            available = static_cast<std::size_t>(tail_cache_ - h);
+        }
+
+        return {ring_ + start, std::min(available, to_end)};
+    }
+
+    // Releases the first k items of the span returned by the last readable(). k must not exceed its size.
+    void release(std::size_t k)
+    {
+        publish_head(header_->head.load(std::memory_order_relaxed) + k);
+    }
+
+    // Number of queued items, exact when called from the producer or the consumer.
+    std::size_t size() const
+    {
+        const std::uint64_t h = header_->head.load(std::memory_order_acquire);
+        return static_cast<std::size_t>(header_->tail.load(std::memory_order_acquire) - h);
+    }
+
+    // Monitoring variant of size() for any thread or process, clamped to [0, capacity()].
+    std::size_t approx_size() const
+    {
+        const std::uint64_t h = header_->head.load(std::memory_order_relaxed);
+        const std::uint64_t t = header_->tail.load(std::memory_order_relaxed);
+        return t <= h ? 0 : std::min(static_cast<std::size_t>(t - h), capacity_);
+    }
+
+    std::size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    // File descriptor of the shared region, for attach(int) in another process.
+    int fd() const
+    {
+        return fd_;
+    }
+
+    // Size of the mapping in bytes, header included; a multiple of the (huge) page size.
+    std::size_t region_size() const
+    {
+        return region_size_;
+    }
+
+    // True if the region is backed by huge pages (MFD_HUGETLB). Named regions report false,
+    // since transparent huge pages are not guaranteed.
+    bool huge_pages() const
+    {
+        return huge_pages_;
+    }
+
+    bool closed() const
+    {
+        return header_->closed.load(std::memory_order_acquire);
+    }
+
+    // True only when producer has called close() and all queued items are drained.
+    bool done() const
+    {
+        if (!closed())
+        {
+            return false;
+        }
+
+        const std::uint64_t h = header_->head.load(std::memory_order_relaxed);
+        return h == header_->tail.load(std::memory_order_acquire);
+    }
+
+    void close()
+    {
+        // Blocked operations of both processes poll this flag and exit.
+        header_->closed.store(true, std::memory_order_release);
+        wait_.notify_close();
+    }
+
+    // Closes the queue (best-effort wakeup of the other side), unmaps the region and, in the
+    // process that created a named region, unlinks its name.
+    ~shm_spsc_queue()
+    {
+        close();
+        ::munmap(header_, region_size_);
+        ::close(fd_);
+        if (owner_ && !name_.empty())
+        {
+            ::shm_unlink(name_.c_str());
+        }
+    }
+
+    // Let's not allow copying or moving the queue
+    shm_spsc_queue(const shm_spsc_queue &) = delete;
+    shm_spsc_queue &operator=(const shm_spsc_queue &) = delete;
+    shm_spsc_queue(shm_spsc_queue &&) = delete;
+    shm_spsc_queue &operator=(shm_spsc_queue &&) = delete;
+
+private:
+    using header = detail::shm_queue_header;
+
+    static constexpr std::size_t cacheline_size = 64;
+    static constexpr std::size_t huge_page_size = std::size_t{2} << 20;
+    static constexpr std::size_t ring_offset = (sizeof(header) + std::max(cacheline_size, alignof(T)) - 1) /
+                                               std::max(cacheline_size, alignof(T)) * std::max(cacheline_size, alignof(T));
+
+    struct region_fd
+    {
+        int fd;
+        bool huge_pages;
+    };
+
+    static std::size_t page_size()
+    {
+        static const std::size_t size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        return size;
+    }
+
+    static std::size_t round_up(std::size_t n, std::size_t granule)
+    {
+        return (n + granule - 1) / granule * granule;
+    }
+
+    // Region size for capacity slots, rounded up to whole (huge) pages.
+    static std::size_t checked_region_size(std::size_t capacity, shm_options options)
+    {
+        const std::size_t granule = options.huge_pages ? huge_page_size : page_size();
+        if (capacity == 0 || capacity > (std::numeric_limits<std::size_t>::max() - ring_offset - granule) / sizeof(T))
+        {
+            throw std::invalid_argument("Invalid capacity: " + std::to_string(capacity));
+        }
+        return round_up(ring_offset + capacity * sizeof(T), granule);
+    }
+
+    // memfd for an anonymous region of bytes, huge-page backed if asked for and available.
+    static region_fd create_memfd(std::size_t bytes, shm_options options)
+    {
+        if (options.huge_pages)
+        {
+            const int fd = ::memfd_create("shm_spsc_queue", MFD_CLOEXEC | MFD_HUGETLB);
+            if (fd >= 0)
+            {
+                // Reserving the huge pages happens at mmap(); check that it succeeds up front.
+                void *p = ::ftruncate(fd, static_cast<off_t>(bytes)) == 0
+                              ? ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                              : MAP_FAILED;
+                if (p != MAP_FAILED)
+                {
+                    ::munmap(p, bytes);
+                    return {fd, true};
+                }
+                ::close(fd);
+            }
+        }
+
+        const int fd = ::memfd_create("shm_spsc_queue", MFD_CLOEXEC);
+        if (fd < 0)
+        {
+            detail::throw_errno("memfd_create");
+        }
+        if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0)
+        {
+            const int error = errno;
+            ::close(fd);
+            errno = error;
+            detail::throw_errno("ftruncate");
+        }
+        return {fd, false};
+    }
+
+    // Maps the region behind rfd. capacity != 0 initializes a new region of that capacity,
+    // capacity == 0 attaches to an existing one and reads the capacity from its header.
+    // Takes ownership of rfd.fd.
+    shm_spsc_queue(region_fd rfd, std::string name, std::size_t capacity, shm_options options)
+        : fd_(rfd.fd), huge_pages_(rfd.huge_pages), owner_(capacity != 0), name_(std::move(name))
+    {
+        try
+        {
+            map(options);
+            if (owner_)
+            {
+                initialize(capacity);
+            }
+            else
+            {
+                validate();
+            }
+        }
+        catch (...)
+        {
+            if (header_ != nullptr)
+            {
+                ::munmap(header_, region_size_);
+            }
+            ::close(fd_);
+            if (owner_ && !name_.empty())
+            {
+                ::shm_unlink(name_.c_str());
+            }
+            throw;
+        }
+    }
+
+    void map(shm_options options)
+    {
+        struct stat st{};
+        if (::fstat(fd_, &st) != 0)
+        {
+            detail::throw_errno("fstat");
+        }
+        region_size_ = static_cast<std::size_t>(st.st_size);
+        if (region_size_ < ring_offset)
+        {
+            throw std::runtime_error("Shared queue region too small: " + std::to_string(region_size_));
+        }
+
+        const int flags = MAP_SHARED | (options.prefault ? MAP_POPULATE : 0);
+        void *p = ::mmap(nullptr, region_size_, PROT_READ | PROT_WRITE, flags, fd_, 0);
+        if (p == MAP_FAILED)
+        {
+            detail::throw_errno("mmap");
+        }
+        if (options.huge_pages && !huge_pages_)
+        {
+            // Transparent huge pages for shmem, if the kernel allows them. Failure is harmless.
+            ::madvise(p, region_size_, MADV_HUGEPAGE);
+        }
+        header_ = static_cast<header *>(p);
+        ring_ = reinterpret_cast<T *>(static_cast<unsigned char *>(p) + ring_offset);
+    }
+
+    void initialize(std::size_t capacity)
+    {
+        header *h = std::construct_at(header_);
+        h->version = detail::shm_layout_version;
+        h->value_size = static_cast<std::uint32_t>(sizeof(T));
+        h->value_align = static_cast<std::uint32_t>(alignof(T));
+        h->capacity = capacity;
+        h->ring_offset = ring_offset;
+        h->head.store(0, std::memory_order_relaxed);
+        h->tail.store(0, std::memory_order_relaxed);
+        h->closed.store(false, std::memory_order_relaxed);
+        capacity_ = capacity;
+        // Publishes the header to processes that attach later.
+        h->magic.store(detail::shm_magic, std::memory_order_release);
+    }
+
+    void validate()
+    {
+        if (header_->magic.load(std::memory_order_acquire) != detail::shm_magic)
+        {
+            throw std::runtime_error("Not an initialized shm_spsc_queue region");
+        }
+        if (header_->version != detail::shm_layout_version)
+        {
+            throw std::runtime_error("Incompatible shm_spsc_queue layout version: " + std::to_string(header_->version));
+        }
+        if (header_->value_size != sizeof(T) || header_->value_align != alignof(T))
+        {
+            throw std::runtime_error("shm_spsc_queue value type mismatch: size " + std::to_string(header_->value_size) +
+                                     ", alignment " + std::to_string(header_->value_align));
+        }
+        if (header_->ring_offset != ring_offset || header_->capacity == 0 ||
+            header_->capacity > (region_size_ - ring_offset) / sizeof(T))
+        {
+            throw std::runtime_error("Invalid shm_spsc_queue capacity: " + std::to_string(header_->capacity));
+        }
+        capacity_ = static_cast<std::size_t>(header_->capacity);
+        // Another process may have worked on the queue already; start the caches from the shared state.
+        head_cache_ = header_->head.load(std::memory_order_acquire);
+        tail_cache_ = header_->tail.load(std::memory_order_acquire);
+    }
+
+    std::size_t slot(std::uint64_t counter) const
+    {
+        return static_cast<std::size_t>(counter % capacity_);
+    }
+
+    template <typename U>
+    bool push_until_deadline(U &&item, std::chrono::steady_clock::time_point deadline)
+    {
+        std::size_t spin = 0;
+
+        while (!closed())
+        {
+            if (try_push(std::forward<U>(item)))
+            {
+                return true;
+            }
+
+            if (!wait_.wait_for_space(spin, [this]
+                                      { return space_or_closed(); }, deadline))
+            {
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    std::optional<T> pop_until_deadline(std::chrono::steady_clock::time_point deadline)
+    {
+        for (std::size_t spin = 0;;)
+        {
+            auto item = try_pop();
+            if (item.has_value())
+            {
+                return item;
+            }
+
+            if (done())
+            {
+                return std::nullopt;
+            }
+
+            if (!wait_.wait_for_items(spin, [this]
+                                      { return items_or_closed(); }, deadline))
+            {
+                return std::nullopt;
+            }
+        }
+    }
+
+    void publish_tail(std::uint64_t t)
+    {
+        header_->tail.store(t, std::memory_order_release);
+        wait_.notify_items();
+    }
+
+    void publish_head(std::uint64_t h)
+    {
+        header_->head.store(h, std::memory_order_release);
+        wait_.notify_space();
+    }
+
+    // Wake-up predicate of a blocked producer.
+    bool space_or_closed() const
+    {
+        return closed() || header_->tail.load(std::memory_order_relaxed) - header_->head.load(std::memory_order_acquire) < capacity_;
+    }
+
+    // Wake-up predicate of a blocked consumer.
+    bool items_or_closed() const
+    {
+        return closed() || header_->head.load(std::memory_order_relaxed) != header_->tail.load(std::memory_order_acquire);
+    }
+
+    // Copies items from first (advancing it) into at most two contiguous runs of free slots,
+    // with one memcpy per run for a contiguous range. The tail is published once.
+    template <typename InputIt, typename Sentinel>
+    std::size_t push_batch(InputIt &first, Sentinel last)
+    {
+        if (closed() || first == last)
+        {
+            return 0;
+        }
+        const std::uint64_t t = header_->tail.load(std::memory_order_relaxed);
+
+        // Refresh the cached head only if it does not leave room for the whole batch.
+        std::size_t wanted = capacity_;
+        if constexpr (std::sized_sentinel_for<Sentinel, InputIt>)
+        {
+            wanted = std::min(wanted, static_cast<std::size_t>(last - first));
+        }
+        std::size_t free = capacity_ - static_cast<std::size_t>(t - head_cache_);
+        if (free < wanted)
+        {
+            head_cache_ = header_->head.load(std::memory_order_acquire);
+            free = capacity_ - static_cast<std::size_t>(t - head_cache_);
+        }
+
+        const std::size_t start = slot(t);
+        const std::size_t first_run = std::min(free, capacity_ - start);
+        std::size_t pushed = 0;
+        if constexpr (contiguous_source_of<InputIt, T> && std::sized_sentinel_for<Sentinel, InputIt>)
+        {
+            pushed = std::min(free, static_cast<std::size_t>(last - first));
+            const std::size_t run = std::min(pushed, first_run);
+            copy_items(ring_ + start, std::to_address(first), run);
+            copy_items(ring_, std::to_address(first) + run, pushed - run);
+            first += static_cast<std::iter_difference_t<InputIt>>(pushed);
+        }
+        for (; pushed < first_run && first != last; ++pushed, ++first)
+        {
+            std::construct_at(ring_ + start + pushed, *first);
+        }
+        for (; pushed < free && first != last; ++pushed, ++first)
+        {
+            std::construct_at(ring_ + (pushed - first_run), *first);
+        }
+
+        if (pushed != 0)
+        {
+            publish_tail(t + pushed);
+        }
+        return pushed;
+    }
+
+    // Copies up to max items into out from at most two contiguous runs of occupied slots,
+    // with one memcpy per run into a contiguous range. The head is published once.
+    template <typename OutputIt>
+    std::size_t pop_batch(OutputIt &out, std::size_t max)
+    {
+        const std::uint64_t h = header_->head.load(std::memory_order_relaxed);
+
+        // Refresh the cached tail only if it does not cover the whole batch.
+        std::size_t available = static_cast<std::size_t>(tail_cache_ - h);
+        if (available < max)
+        {
+            tail_cache_ = header_->tail.load(std::memory_order_acquire);
+            available = static_cast<std::size_t>(tail_cache_ - h);
+        }
+
+        const std::size_t n = std::min(available, max);
+        const std::size_t start = slot(h);
+        const std::size_t first_run = std::min(n, capacity_ - start);
+        if constexpr (contiguous_sink_of<OutputIt, T>)
+        {
+            T *dst = std::to_address(out);
+            copy_items(dst, ring_ + start, first_run);
+            copy_items(dst + first_run, ring_, n - first_run);
+            out += static_cast<std::iter_difference_t<OutputIt>>(n);
+        }
+        else
+        {
+            for (std::size_t i = 0; i < n; ++i, ++out)
+            {
+                *out = ring_[i < first_run ? start + i : i - first_run];
+            }
+        }
+
+        if (n != 0)
+        {
+            publish_head(h + n);
+        }
+        return n;
+    }
+
+    int fd_;
+    bool huge_pages_;
+    // True for the process that created (and initialized) the region.
+    bool owner_;
+    std::string name_;
+    std::size_t region_size_ = 0;
+    std::size_t capacity_ = 0;
+    header *header_ = nullptr;
+    T *ring_ = nullptr;
+    // Process-local caches of the remote indices, on the cache lines of their owners.
+    alignas(cacheline_size) std::uint64_t tail_cache_ = 0;
+    alignas(cacheline_size) std::uint64_t head_cache_ = 0;
+    [[no_unique_address]] WaitPolicy wait_;
+};
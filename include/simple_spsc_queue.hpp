@@ -1,12 +1,20 @@
+#pragma once
+
+#include <chrono>
 #include <concepts>
 #include <condition_variable>
 #include <cstddef>
 #include <deque>
+#include <functional>
+#include <iterator>
+#include <limits>
 #include <mutex>
 #include <optional>
 #include <stdexcept>
 #include <utility>
 
+#include "queue_awaitables.hpp"
+
 /// @class simple_spsc_queue
 /// @brief A single-producer, single-consumer (SPSC) bounded queue.
 ///
@@ -18,6 +26,7 @@
 /// - Uses a deque for storage with mutex-protected access.
 /// - Blocking push()/pop() use condition variables for efficient waiting.
 /// - close() wakes blocked producer/consumer operations.
+/// - async_pop()/async_push() suspend a coroutine instead of blocking, see queue_awaitables.hpp.
 /// - The queue is non-copyable and non-movable.
 /// - NOT thread-safe for multiple producers or consumers.
 ///
@@ -46,7 +55,17 @@ public:
     bool try_push(U &&item)
     {
         std::unique_lock<std::mutex> lock(mtx_);
-        return locked_push(lock, std::forward<U>(item));
+        return locked_emplace(lock, std::forward<U>(item));
+    }
+
+    // Non-blocking push constructing the item in place from args.
+    // Returns false if queue is full or closed.
+    template <typename... Args>
+        requires std::constructible_from<T, Args &&...>
+    bool try_emplace(Args &&...args)
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        return locked_emplace(lock, std::forward<Args>(args)...);
     }
 
     // Blocking push. Returns false if the queue gets closed.
@@ -59,7 +78,33 @@ public:
         producer_cv_.wait(lock, [this]
                           { return closed_ || q_.size() < capacity_; });
 
-        return locked_push(lock, std::forward<U>(item));
+        return locked_emplace(lock, std::forward<U>(item));
+    }
+
+    // Timed blocking push. Returns false if queue gets closed or the deadline passes while waiting.
+    template <typename U, class Clock, class Duration>
+        requires std::constructible_from<T, U &&>
+    bool push_until(U &&item, const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        // Wait until there is space, the queue gets closed, or the deadline passes.
+        producer_cv_.wait_until(lock, deadline, [this]
+                                { return closed_ || q_.size() < capacity_; });
+
+        return locked_emplace(lock, std::forward<U>(item));
+    }
+
+    // Timed blocking push. Returns false if queue gets closed or timeout expires while waiting.
+    template <typename U, class Rep, class Period>
+        requires std::constructible_from<T, U &&>
+    bool push_for(U &&item, const std::chrono::duration<Rep, Period> &timeout)
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        // Wait until there is space, the queue gets closed, or timeout expires.
+        producer_cv_.wait_for(lock, timeout, [this]
+                              { return closed_ || q_.size() < capacity_; });
+
+        return locked_emplace(lock, std::forward<U>(item));
     }
 
     // Non-blocking pop. Returns nullopt if the queue is empty.
@@ -69,6 +114,131 @@ public:
         return locked_pop(lock);
     }
 
+    // Non-blocking bulk push. Pushes as many items from [first, last) as currently fit
+    // under a single lock acquisition. Returns the number of items pushed (0 if full or closed).
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+        requires std::constructible_from<T, std::iter_reference_t<InputIt>>
+    std::size_t try_push_n(InputIt first, Sentinel last)
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        return locked_push_batch(lock, first, last);
+    }
+
+    // Blocking bulk push. Pushes all items from [first, last), taking the lock once per batch that fits.
+    // Returns the number of items pushed, which is less than the range size only if queue gets closed.
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+        requires std::constructible_from<T, std::iter_reference_t<InputIt>>
+    std::size_t push_n(InputIt first, Sentinel last)
+    {
+        std::size_t pushed = 0;
+
+        while (first != last)
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            // Wait until there is space, or until the queue gets closed.
+            producer_cv_.wait(lock, [this]
+                              { return closed_ || q_.size() < capacity_; });
+
+            const std::size_t n = locked_push_batch(lock, first, last);
+            if (n == 0)
+            {
+                break;
+            }
+            pushed += n;
+        }
+
+        return pushed;
+    }
+
+    // Non-blocking bulk pop. Moves up to max items into out under a single lock acquisition.
+    // Returns the number of items popped (0 if queue is empty).
+    template <typename OutputIt>
+        requires std::output_iterator<OutputIt, T &&>
+    std::size_t try_pop_n(OutputIt out, std::size_t max)
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        return locked_pop_batch(lock, out, max);
+    }
+
+    // Blocking bulk pop. Waits until at least one item is available, then moves up to max items into out.
+    // Returns the number of items popped; 0 only if queue is closed and empty (or max is 0).
+    template <typename OutputIt>
+        requires std::output_iterator<OutputIt, T &&>
+    std::size_t pop_n(OutputIt out, std::size_t max)
+    {
+        if (max == 0)
+        {
+            return 0;
+        }
+
+        std::unique_lock<std::mutex> lock(mtx_);
+        // Wait until there is data, or until the queue gets closed.
+        consumer_cv_.wait(lock, [this]
+                          { return closed_ || !q_.empty(); });
+
+        return locked_pop_batch(lock, out, max);
+    }
+
+    // Non-blocking in-place consume. Invokes f on the oldest item, then removes it.
+    // Returns false (without invoking f) if queue is empty. If f throws, the item stays in the queue.
+    // The lock is not held while f runs; deque::push_back does not invalidate references to
+    // existing elements, so the producer can keep pushing meanwhile.
+    template <typename F>
+        requires std::invocable<F, T &>
+    bool try_consume(F &&f)
+    {
+        T *item = front();
+        if (item == nullptr)
+        {
+            return false;
+        }
+
+        std::invoke(std::forward<F>(f), *item);
+        pop_front();
+        return true;
+    }
+
+    // Non-blocking in-place drain. Invokes f on every queued item, oldest first, and removes them,
+    // all under a single lock acquisition, with one producer notification for the batch. The
+    // producer cannot push while f runs. Returns the number of items consumed (0 if empty).
+    // If f throws, the items before the throwing one are removed and it stays in the queue.
+    template <typename F>
+        requires std::invocable<F &, T &>
+    std::size_t consume_all(F &&f)
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        return locked_consume_batch(lock, f, std::numeric_limits<std::size_t>::max());
+    }
+
+    // Same as consume_all(), but consumes at most max items.
+    template <typename F>
+        requires std::invocable<F &, T &>
+    std::size_t consume_up_to(std::size_t max, F &&f)
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        return locked_consume_batch(lock, f, max);
+    }
+
+    // Consumer-side access to the oldest item without removing it. Returns nullptr if queue is empty.
+    // The pointer stays valid until the item is removed by pop_front(), try_pop() or try_consume().
+    T *front()
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return q_.empty() ? nullptr : &q_.front();
+    }
+
+    // Removes the oldest item. Must only be called after front() returned a non-null pointer.
+    void pop_front()
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        q_.pop_front();
+        async_waiter *waiter = std::exchange(producer_waiter_, nullptr);
+
+        lock.unlock();
+        producer_cv_.notify_one();
+        resume_waiter(waiter);
+    }
+
     // Blocking pop. Returns nullopt if queue is closed and empty.
     std::optional<T> pop()
     {
@@ -80,12 +250,60 @@ public:
         return locked_pop(lock);
     }
 
+    // Timed blocking pop. Returns nullopt if queue is closed and empty, or the deadline passes while waiting.
+    template <class Clock, class Duration>
+    std::optional<T> pop_until(const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        // Wait until there is data, the queue gets closed, or the deadline passes.
+        consumer_cv_.wait_until(lock, deadline, [this]
+                                { return closed_ || !q_.empty(); });
+
+        return locked_pop(lock);
+    }
+
+    // Timed blocking pop. Returns nullopt if queue is closed and empty, or timeout expires while waiting.
+    template <class Rep, class Period>
+    std::optional<T> pop_for(const std::chrono::duration<Rep, Period> &timeout)
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        // Wait until there is data, the queue gets closed, or timeout expires.
+        consumer_cv_.wait_for(lock, timeout, [this]
+                              { return closed_ || !q_.empty(); });
+
+        return locked_pop(lock);
+    }
+
+    // Awaitable pop: co_await q.async_pop() yields the oldest item, suspending while queue is empty,
+    // or nullopt once queue is closed and drained. post resumes the coroutine, see queue_awaitables.hpp.
+    template <typename Post = inline_resume>
+        requires std::invocable<Post &, std::coroutine_handle<>>
+    queue_pop_awaitable<simple_spsc_queue, Post> async_pop(Post post = {})
+    {
+        return {*this, std::move(post)};
+    }
+
+    // Awaitable push: co_await q.async_push(item) yields true once item is pushed, suspending while
+    // queue is full, or false if queue gets closed.
+    template <typename U, typename Post = inline_resume>
+        requires std::constructible_from<T, U &&> && std::invocable<Post &, std::coroutine_handle<>>
+    queue_push_awaitable<simple_spsc_queue, Post> async_push(U &&item, Post post = {})
+    {
+        return {*this, std::forward<U>(item), std::move(post)};
+    }
+
     std::size_t size() const
     {
         std::lock_guard<std::mutex> lock(mtx_);
         return q_.size();
     }
 
+    // Same as size(); provided so monitoring code can treat both queues alike.
+    std::size_t approx_size() const
+    {
+        return size();
+    }
+
     std::size_t capacity() const
     {
         return capacity_;
@@ -106,14 +324,20 @@ public:
 
     void close()
     {
+        async_waiter *consumer = nullptr;
+        async_waiter *producer = nullptr;
         {
             std::lock_guard<std::mutex> lock(mtx_);
             closed_ = true;
+            consumer = std::exchange(consumer_waiter_, nullptr);
+            producer = std::exchange(producer_waiter_, nullptr);
         }
 
         // Wake both sides so blocked push/pop can re-check close state.
         consumer_cv_.notify_all();
         producer_cv_.notify_all();
+        resume_waiter(consumer);
+        resume_waiter(producer);
     }
 
     // NOTE: Destructor calling close() is only a best-effort wakeup.
@@ -131,23 +355,136 @@ public:
     simple_spsc_queue &operator=(simple_spsc_queue &&) = delete;
 
 private:
-    template <typename U>
-        requires std::constructible_from<T, U &&>
-    bool locked_push(std::unique_lock<std::mutex> &lock, U &&item)
+    template <class, class>
+    friend class queue_pop_awaitable;
+    template <class, class>
+    friend class queue_push_awaitable;
+
+    // Awaitable hooks: register w to be resumed by the other side, unless there is no need to suspend.
+    bool suspend_consumer(async_waiter &w)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (closed_ || !q_.empty())
+        {
+            return false;
+        }
+        consumer_waiter_ = &w;
+        return true;
+    }
+
+    bool suspend_producer(async_waiter &w)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (closed_ || q_.size() < capacity_)
+        {
+            return false;
+        }
+        producer_waiter_ = &w;
+        return true;
+    }
+
+    // Waiters are taken out under the lock and resumed after it is released.
+    static void resume_waiter(async_waiter *w)
+    {
+        if (w != nullptr)
+        {
+            w->resume(*w);
+        }
+    }
+
+    template <typename... Args>
+        requires std::constructible_from<T, Args &&...>
+    bool locked_emplace(std::unique_lock<std::mutex> &lock, Args &&...args)
     {
         if (q_.size() >= capacity_ || closed_)
         {
             return false;
         }
 
-        q_.push_back(std::forward<U>(item));
+        q_.emplace_back(std::forward<Args>(args)...);
+        async_waiter *waiter = std::exchange(consumer_waiter_, nullptr);
 
         lock.unlock();
         consumer_cv_.notify_one();
+        resume_waiter(waiter);
 
         return true;
     }
 
+    template <typename InputIt, typename Sentinel>
+    std::size_t locked_push_batch(std::unique_lock<std::mutex> &lock, InputIt &first, Sentinel last)
+    {
+        if (closed_)
+        {
+            return 0;
+        }
+
+        std::size_t pushed = 0;
+        for (; q_.size() < capacity_ && first != last; ++first, ++pushed)
+        {
+            q_.emplace_back(*first);
+        }
+        async_waiter *waiter = pushed != 0 ? std::exchange(consumer_waiter_, nullptr) : nullptr;
+
+        lock.unlock();
+        if (pushed != 0)
+        {
+            consumer_cv_.notify_one();
+        }
+        resume_waiter(waiter);
+
+        return pushed;
+    }
+
+    template <typename OutputIt>
+    std::size_t locked_pop_batch(std::unique_lock<std::mutex> &lock, OutputIt &out, std::size_t max)
+    {
+        std::size_t popped = 0;
+        for (; popped < max && !q_.empty(); ++popped, ++out)
+        {
+            *out = std::move(q_.front());
+            q_.pop_front();
+        }
+        unlock_after_pops(lock, popped);
+
+        return popped;
+    }
+
+    template <typename F>
+    std::size_t locked_consume_batch(std::unique_lock<std::mutex> &lock, F &f, std::size_t max)
+    {
+        std::size_t consumed = 0;
+        try
+        {
+            for (; consumed < max && !q_.empty(); ++consumed)
+            {
+                std::invoke(f, q_.front());
+                q_.pop_front();
+            }
+        }
+        catch (...)
+        {
+            unlock_after_pops(lock, consumed);
+            throw;
+        }
+        unlock_after_pops(lock, consumed);
+
+        return consumed;
+    }
+
+    // Releases the lock and, if popped items freed space, wakes a blocked or suspended producer.
+    void unlock_after_pops(std::unique_lock<std::mutex> &lock, std::size_t popped)
+    {
+        async_waiter *waiter = popped != 0 ? std::exchange(producer_waiter_, nullptr) : nullptr;
+
+        lock.unlock();
+        if (popped != 0)
+        {
+            producer_cv_.notify_one();
+        }
+        resume_waiter(waiter);
+    }
+
     std::optional<T> locked_pop(std::unique_lock<std::mutex> &lock)
     {
         if (q_.empty())
@@ -157,9 +494,11 @@ private:
 
         T item = std::move(q_.front());
         q_.pop_front();
+        async_waiter *waiter = std::exchange(producer_waiter_, nullptr);
 
         lock.unlock();
         producer_cv_.notify_one();
+        resume_waiter(waiter);
 
         return item;
     }
@@ -170,4 +509,7 @@ private:
     mutable std::mutex mtx_;
     bool closed_ = false;
     std::deque<T> q_;
+    // Coroutines suspended in async_pop()/async_push(), protected by mtx_.
+    async_waiter *consumer_waiter_ = nullptr;
+    async_waiter *producer_waiter_ = nullptr;
 };
@@ -0,0 +1,419 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "wait_policies.hpp"
+
+/// @class slot_spsc_queue
+/// @brief SPSC bounded queue where every slot carries its own full flag (FastForward style).
+///
+/// @tparam T The type of elements stored in the queue. Must be movable.
+/// @tparam WaitPolicy How blocking operations wait, see wait_policies.hpp.
+/// @tparam SlotAlign Alignment of each slot. The default gives every slot its own cache line,
+/// so a consumer polling slot i never false-shares with the producer writing slot i + 1;
+/// alignof(T) packs the slots instead (less memory, more sharing when the queue runs near empty).
+///
+/// @details
+/// Same surface as atomic_spsc_queue, different synchronization:
+///
+/// - Each slot holds an atomic full flag next to the item. The producer writes the slot it is
+///   about to fill only after seeing the flag clear, then sets it with a release store; the
+///   consumer reads the next slot only after seeing the flag set, then clears it with a
+///   release store once the item is destroyed.
+/// - head_ and tail_ are private positions. Neither side reads the other's index in push/pop:
+///   full and empty are decided by the flag of a single slot, so the only line that moves
+///   between the cores is the slot line itself. Each index is still stored (relaxed) by its owner
+///   so size()/approx_size() can be answered from any thread.
+/// - There is no cached remote index to refresh. The price is one atomic load of a slot flag
+///   per operation and, with padded slots, one cache line per slot.
+/// - Items are constructed directly in their slot, so a failed or throwing try_emplace() leaves
+///   the queue unchanged.
+///
+/// Bulk operations move item by item; creating the queue writes every slot flag, so the ring
+/// pages are touched up front.
+///
+/// @note The queue is non-copyable and non-movable and must outlive all threads accessing it.
+/// @warning This queue is NOT thread-safe for multiple producers or consumers.
+
+template <class T, class WaitPolicy = spin_yield_wait, std::size_t SlotAlign = 64>
+    requires std::movable<T> && wait_policy<WaitPolicy> && (std::has_single_bit(SlotAlign))
+class slot_spsc_queue
+{
+public:
+    using value_type = T;
+
+    explicit slot_spsc_queue(std::size_t capacity) : capacity_(capacity)
+    {
+        if (capacity_ == 0)
+        {
+            throw std::invalid_argument("Invalid capacity: " + std::to_string(capacity_));
+        }
+        slots_ = std::make_unique_for_overwrite<slot[]>(capacity_);
+        for (std::size_t i = 0; i < capacity_; ++i)
+        {
+            slots_[i].full.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    // Non-blocking push. Returns false if queue is full or closed.
+    template <typename U>
+        requires std::constructible_from<T, U &&>
+    bool try_push(U &&item)
+    {
+        return try_emplace(std::forward<U>(item));
+    }
+
+    // Non-blocking push constructing the item directly in its slot from args.
+    // Returns false (without using args) if queue is full or closed.
+    template <typename... Args>
+        requires std::constructible_from<T, Args &&...>
+    bool try_emplace(Args &&...args)
+    {
+        if (closed_.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        const std::uint64_t t = tail_.load(std::memory_order_relaxed);
+        slot &s = slots_[slot_of(t)];
+        // Full if the consumer has not released this slot from the previous lap.
+        if (s.full.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        std::construct_at(s.item(), std::forward<Args>(args)...);
+        s.full.store(true, std::memory_order_release);
+        tail_.store(t + 1, std::memory_order_relaxed);
+        wait_.notify_items();
+        return true;
+    }
+
+    // Blocking push. Returns false if queue gets closed while waiting.
+    template <typename U>
+        requires std::constructible_from<T, U &&>
+    bool push(U &&item)
+    {
+        return push_until_deadline(std::forward<U>(item), no_deadline);
+    }
+
+    // Timed blocking push. Returns false if queue gets closed or the deadline passes while waiting.
+    template <typename U, class Clock, class Duration>
+        requires std::constructible_from<T, U &&>
+    bool push_until(U &&item, const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        return push_until_deadline(std::forward<U>(item), to_steady_deadline(deadline));
+    }
+
+    // Timed blocking push. Returns false if queue gets closed or timeout expires while waiting.
+    template <typename U, class Rep, class Period>
+        requires std::constructible_from<T, U &&>
+    bool push_for(U &&item, const std::chrono::duration<Rep, Period> &timeout)
+    {
+        return push_until_deadline(std::forward<U>(item), deadline_after(timeout));
+    }
+
+    // Non-blocking pop. Returns nullopt if queue is empty.
+    std::optional<T> try_pop()
+    {
+        T *item = front();
+        if (item == nullptr)
+        {
+            return std::nullopt;
+        }
+
+        T value = std::move(*item);
+        pop_front();
+        return value;
+    }
+
+    // Non-blocking in-place consume. Invokes f on the oldest item while it is still in its slot,
+    // then releases the slot. Returns false (without invoking f) if queue is empty.
+    // If f throws, the item stays in the queue.
+    template <typename F>
+        requires std::invocable<F, T &>
+    bool try_consume(F &&f)
+    {
+        T *item = front();
+        if (item == nullptr)
+        {
+            return false;
+        }
+
+        std::invoke(std::forward<F>(f), *item);
+        pop_front();
+        return true;
+    }
+
+    // Consumer-side access to the oldest item without removing it. Returns nullptr if queue is empty.
+    T *front()
+    {
+        slot &s = slots_[slot_of(head_.load(std::memory_order_relaxed))];
+        return s.full.load(std::memory_order_acquire) ? s.item() : nullptr;
+    }
+
+    // Removes the oldest item. Must only be called after front() returned a non-null pointer.
+    void pop_front()
+    {
+        const std::uint64_t h = head_.load(std::memory_order_relaxed);
+        slot &s = slots_[slot_of(h)];
+        std::destroy_at(s.item());
+        s.full.store(false, std::memory_order_release);
+        head_.store(h + 1, std::memory_order_relaxed);
+        wait_.notify_space();
+    }
+
+    // Blocking pop. Returns nullopt if queue is closed and empty.
+    std::optional<T> pop()
+    {
+        return pop_until_deadline(no_deadline);
+    }
+
+    // Timed blocking pop. Returns nullopt if queue is closed and empty, or the deadline passes while waiting.
+    template <class Clock, class Duration>
+    std::optional<T> pop_until(const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        return pop_until_deadline(to_steady_deadline(deadline));
+    }
+
+    // Timed blocking pop. Returns nullopt if queue is closed and empty, or timeout expires while waiting.
+    template <class Rep, class Period>
+    std::optional<T> pop_for(const std::chrono::duration<Rep, Period> &timeout)
+    {
+        return pop_until_deadline(deadline_after(timeout));
+    }
+
+    // Non-blocking bulk push. Pushes items from [first, last) until the queue is full or closed.
+    // Returns the number of items pushed.
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+        requires std::constructible_from<T, std::iter_reference_t<InputIt>>
+    std::size_t try_push_n(InputIt first, Sentinel last)
+    {
+        std::size_t pushed = 0;
+        for (; first != last && try_push(*first); ++first)
+        {
+            ++pushed;
+        }
+        return pushed;
+    }
+
+    // Blocking bulk push. Returns the number of items pushed, which is less than the range size
+    // only if queue gets closed.
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+        requires std::constructible_from<T, std::iter_reference_t<InputIt>>
+    std::size_t push_n(InputIt first, Sentinel last)
+    {
+        std::size_t pushed = 0;
+        for (; first != last && push(*first); ++first)
+        {
+            ++pushed;
+        }
+        return pushed;
+    }
+
+    // Non-blocking bulk pop. Moves up to max items into out. Returns the number of items popped.
+    template <typename OutputIt>
+        requires std::output_iterator<OutputIt, T &&>
+    std::size_t try_pop_n(OutputIt out, std::size_t max)
+    {
+        std::size_t popped = 0;
+        for (T *item = nullptr; popped < max && (item = front()) != nullptr; ++popped, ++out)
+        {
+            *out = std::move(*item);
+            pop_front();
+        }
+        return popped;
+    }
+
+    // Blocking bulk pop. Waits until at least one item is available, then moves up to max items into out.
+    // Returns the number of items popped; 0 only if queue is closed and empty (or max is 0).
+    template <typename OutputIt>
+        requires std::output_iterator<OutputIt, T &&>
+    std::size_t pop_n(OutputIt out, std::size_t max)
+    {
+        if (max == 0)
+        {
+            return 0;
+        }
+
+        auto first = pop();
+        if (!first.has_value())
+        {
+            return 0;
+        }
+        *out = std::move(*first);
+        ++out;
+        return 1 + try_pop_n(out, max - 1);
+    }
+
+    // Number of queued items, clamped to [0, capacity()]. Exact for the caller's own side; the
+    // other side's index may lag slightly.
+    std::size_t size() const
+    {
+        const std::uint64_t h = head_.load(std::memory_order_acquire);
+        const std::uint64_t t = tail_.load(std::memory_order_acquire);
+        return t <= h ? 0 : std::min(static_cast<std::size_t>(t - h), capacity_);
+    }
+
+    // Monitoring variant of size() with relaxed loads.
+    std::size_t approx_size() const
+    {
+        const std::uint64_t h = head_.load(std::memory_order_relaxed);
+        const std::uint64_t t = tail_.load(std::memory_order_relaxed);
+        return t <= h ? 0 : std::min(static_cast<std::size_t>(t - h), capacity_);
+    }
+
+    std::size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    bool closed() const
+    {
+        return closed_.load(std::memory_order_acquire);
+    }
+
+    // True only when producer has called close() and all queued items are drained.
+    // closed_ is released after the producer's last slot flag, so the flag check below sees it.
+    bool done() const
+    {
+        if (!closed_.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        return !slots_[slot_of(head_.load(std::memory_order_relaxed))].full.load(std::memory_order_acquire);
+    }
+
+    void close()
+    {
+        // Blocked operations poll this flag and exit.
+        closed_.store(true, std::memory_order_release);
+        wait_.notify_close();
+    }
+
+    // Items that were never popped are destroyed here. Producer and consumer threads
+    // must be stopped before destroying the queue.
+    ~slot_spsc_queue()
+    {
+        close();
+
+        for (std::uint64_t h = head_.load(std::memory_order_relaxed);; ++h)
+        {
+            slot &s = slots_[slot_of(h)];
+            if (!s.full.load(std::memory_order_acquire))
+            {
+                break;
+            }
+            std::destroy_at(s.item());
+            s.full.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    // Let's not allow copying or moving the queue
+    slot_spsc_queue(const slot_spsc_queue &) = delete;
+    slot_spsc_queue &operator=(const slot_spsc_queue &) = delete;
+    slot_spsc_queue(slot_spsc_queue &&) = delete;
+    slot_spsc_queue &operator=(slot_spsc_queue &&) = delete;
+
+private:
+    static constexpr std::size_t cacheline_size = 64;
+
+    struct alignas(std::max({SlotAlign, alignof(T), alignof(std::atomic<bool>)})) slot
+    {
+        std::atomic<bool> full;
+        alignas(T) std::byte storage[sizeof(T)];
+
+        T *item()
+        {
+            return std::launder(reinterpret_cast<T *>(storage));
+        }
+    };
+
+    std::size_t slot_of(std::uint64_t pos) const
+    {
+        return static_cast<std::size_t>(pos % capacity_);
+    }
+
+    // Wake-up predicate of a blocked producer: the slot it is about to fill was released.
+    bool space_or_closed() const
+    {
+        return closed() || !slots_[slot_of(tail_.load(std::memory_order_relaxed))].full.load(std::memory_order_acquire);
+    }
+
+    // Wake-up predicate of a blocked consumer: the next slot was filled.
+    bool items_or_closed() const
+    {
+        return closed() || slots_[slot_of(head_.load(std::memory_order_relaxed))].full.load(std::memory_order_acquire);
+    }
+
+    template <typename U>
+    bool push_until_deadline(U &&item, std::chrono::steady_clock::time_point deadline)
+    {
+        std::size_t spin = 0;
+
+        while (!closed())
+        {
+            if (try_push(std::forward<U>(item)))
+            {
+                return true;
+            }
+
+            if (!wait_.wait_for_space(spin, [this]
+                                      { return space_or_closed(); }, deadline))
+            {
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    std::optional<T> pop_until_deadline(std::chrono::steady_clock::time_point deadline)
+    {
+        for (std::size_t spin = 0;;)
+        {
+            auto item = try_pop();
+            if (item.has_value())
+            {
+                return item;
+            }
+
+            if (done())
+            {
+                return std::nullopt;
+            }
+
+            if (!wait_.wait_for_items(spin, [this]
+                                      { return items_or_closed(); }, deadline))
+            {
+                return std::nullopt;
+            }
+        }
+    }
+
+    const std::size_t capacity_;
+    std::unique_ptr<slot[]> slots_;
+    // Consumer-owned: next position to pop. Only size() reads it from the other side.
+    alignas(cacheline_size)
+        std::atomic<std::uint64_t> head_ = 0;
+    // Producer-owned: next position to fill. Only size() reads it from the other side.
+    alignas(cacheline_size)
+        std::atomic<std::uint64_t> tail_ = 0;
+    alignas(cacheline_size)
+        std::atomic<bool> closed_ = false;
+    [[no_unique_address]] WaitPolicy wait_;
+};
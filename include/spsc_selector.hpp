@@ -0,0 +1,288 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "wait_policies.hpp"
+
+/// @class select_notifier
+/// @brief Notification word shared by all queues of one spsc_selector.
+///
+/// @details
+/// The selector parks on a single futex word instead of spinning over the cache lines of N
+/// queues. Producers only pay for the wake syscall when the selector has advertised that it is
+/// parked; as with park_wait, the price is a seq_cst fence per publish so the parked check
+/// cannot miss a selector that is about to park. There is exactly one waiter (the selector's
+/// consumer thread), so a single parked flag is enough.
+
+class select_notifier
+{
+public:
+    // Producer side, after publishing items: wakes the selector if it is parked.
+    void notify()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parked())
+        {
+            wake();
+        }
+    }
+
+    // True while the selector is parked or about to park. Only meaningful after a seq_cst fence.
+    bool parked() const
+    {
+        return parked_.load(std::memory_order_relaxed);
+    }
+
+    // Producer side, after close(): wakes unconditionally, closing is rare.
+    void wake()
+    {
+        epoch_.fetch_add(1, std::memory_order_release);
+        detail::futex_wake(epoch_, false);
+    }
+
+    // Consumer side: parks until notified, unless ready() already holds after advertising.
+    // May return spuriously; the caller re-checks its queues.
+    template <typename Ready>
+    void park(Ready &&ready)
+    {
+        // Read the epoch before advertising, so a wake between the check and futex_wait() is not lost.
+        const std::uint32_t epoch = epoch_.load(std::memory_order_acquire);
+        parked_.store(true, std::memory_order_relaxed);
+        // Pairs with the fence in notify(): either we see the new items or the producer sees parked_.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!ready())
+        {
+            detail::futex_wait(epoch_, epoch, nullptr);
+        }
+        parked_.store(false, std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr std::size_t cacheline_size = 64;
+
+    alignas(cacheline_size) std::atomic<std::uint32_t> epoch_ = 0;
+    std::atomic<bool> parked_ = false;
+};
+
+/// @brief Wait policy for the queues of an spsc_selector.
+///
+/// Blocking operations on the queue itself behave like spin_yield_wait. Once the selector has
+/// attached its select_notifier, publishing items and closing the queue also notify it.
+/// Like park_wait, every publish pays one seq_cst fence, attached or not.
+
+class selector_wait : public spin_yield_wait
+{
+public:
+    void attach(select_notifier *notifier)
+    {
+        notifier_.store(notifier, std::memory_order_relaxed);
+    }
+
+    void notify_items()
+    {
+        // One fence covers both loads: the selector attaches before its own fence in park(),
+        // so whenever it may be parked this sees the notifier and its parked flag.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        select_notifier *n = notifier_.load(std::memory_order_relaxed);
+        if (n != nullptr && n->parked())
+        {
+            n->wake();
+        }
+    }
+
+    void notify_close()
+    {
+        if (select_notifier *n = notifier_.load(std::memory_order_relaxed))
+        {
+            n->wake();
+        }
+    }
+
+private:
+    std::atomic<select_notifier *> notifier_ = nullptr;
+};
+
+/// @class spsc_selector
+/// @brief Lets one consumer thread wait on many SPSC queues at once and drain whichever have data.
+///
+/// @tparam Queue The queue type, e.g. atomic_spsc_queue<T, IndexPolicy, selector_wait>. Anything
+/// with try_consume(), done(), closed() and approx_size() works; queues whose wait policy is not
+/// selector_wait cannot notify, so select() spins and yields instead of parking.
+///
+/// @details
+/// - Fairness: try_select() gives every live queue one turn per call, round-robin, starting
+///   after the queue that had the last turn. A turn drains up to the queue's weight items
+///   (batch draining; weight 1 is plain round-robin), consumed in place with try_consume().
+/// - Retirement: a queue that is done() (closed by its producer and drained) is dropped from
+///   the rotation automatically; done() on the selector is true once every queue is retired.
+/// - Blocking: select() spins for SpinBudget empty rounds, then parks on the shared
+///   select_notifier until a producer publishes or closes one of the queues.
+///
+/// The selector is the single consumer of all its queues: no other thread may pop from them.
+///
+/// @note Non-copyable and non-movable: the queues hold a pointer to its notifier. Producers must
+/// have stopped before the selector is destroyed; the destructor detaches the queues.
+
+template <class Queue, std::size_t SpinBudget = 4096>
+class spsc_selector
+{
+public:
+    using value_type = typename Queue::value_type;
+
+    spsc_selector() = default;
+
+    // Adds q to the rotation. Returns its index, passed to the callbacks of try_select()/select().
+    // weight is the most items drained from q per turn and must be positive.
+    std::size_t add(Queue &q, std::size_t weight = 1)
+    {
+        if (weight == 0)
+        {
+            throw std::invalid_argument("Invalid weight: 0");
+        }
+        if constexpr (notifying)
+        {
+            q.get_wait_policy().attach(&notifier_);
+        }
+        const std::size_t index = queues_.size();
+        queues_.push_back(&q);
+        entries_.push_back(entry{&q, weight, index});
+        return index;
+    }
+
+    // Non-blocking: one round over the live queues, invoking f(index, item) for each consumed item.
+    // Stops early once max items are consumed. Returns the number of items consumed.
+    template <typename F>
+        requires std::invocable<F, std::size_t, value_type &>
+    std::size_t try_select(F &&f, std::size_t max = std::numeric_limits<std::size_t>::max())
+    {
+        std::size_t consumed = 0;
+        const std::size_t turns = entries_.size();
+
+        for (std::size_t turn = 0; turn < turns && consumed < max && !entries_.empty(); ++turn)
+        {
+            if (cursor_ >= entries_.size())
+            {
+                cursor_ = 0;
+            }
+            entry &e = entries_[cursor_];
+
+            std::size_t n = 0;
+            const std::size_t limit = std::min(e.weight, max - consumed);
+            while (n < limit && e.queue->try_consume([&](value_type &item)
+                                                     { std::invoke(f, e.index, item); }))
+            {
+                ++n;
+            }
+
+            if (n == 0 && e.queue->done())
+            {
+                // Retire; the next queue moves into cursor_.
+                entries_.erase(entries_.begin() + static_cast<std::ptrdiff_t>(cursor_));
+                continue;
+            }
+            consumed += n;
+            ++cursor_;
+        }
+
+        return consumed;
+    }
+
+    // Blocking: waits until at least one item is consumed, or every queue is retired.
+    // Returns the number of items consumed; 0 only once done() holds (or max is 0).
+    template <typename F>
+        requires std::invocable<F, std::size_t, value_type &>
+    std::size_t select(F &&f, std::size_t max = std::numeric_limits<std::size_t>::max())
+    {
+        if (max == 0)
+        {
+            return 0;
+        }
+
+        for (std::size_t spin = 0;;)
+        {
+            const std::size_t n = try_select(f, max);
+            if (n != 0 || entries_.empty())
+            {
+                return n;
+            }
+
+            if (++spin < SpinBudget)
+            {
+                cpu_relax();
+                continue;
+            }
+            spin = 0;
+
+            if constexpr (notifying)
+            {
+                notifier_.park([this]
+                               { return any_ready(); });
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Number of queues not yet retired.
+    std::size_t active() const
+    {
+        return entries_.size();
+    }
+
+    // True once every added queue is closed and drained.
+    bool done() const
+    {
+        return entries_.empty();
+    }
+
+    ~spsc_selector()
+    {
+        if constexpr (notifying)
+        {
+            for (Queue *q : queues_)
+            {
+                q->get_wait_policy().attach(nullptr);
+            }
+        }
+    }
+
+    spsc_selector(const spsc_selector &) = delete;
+    spsc_selector &operator=(const spsc_selector &) = delete;
+    spsc_selector(spsc_selector &&) = delete;
+    spsc_selector &operator=(spsc_selector &&) = delete;
+
+private:
+    static constexpr bool notifying = requires(Queue &q, select_notifier *n) { q.get_wait_policy().attach(n); };
+
+    struct entry
+    {
+        Queue *queue;
+        std::size_t weight;
+        std::size_t index;
+    };
+
+    // Park predicate: anything to drain or retire?
+    bool any_ready() const
+    {
+        return std::any_of(entries_.begin(), entries_.end(), [](const entry &e)
+                           { return e.queue->approx_size() != 0 || e.queue->closed(); });
+    }
+
+    // Live queues in rotation order, and every queue ever added (to detach them).
+    std::vector<entry> entries_;
+    std::vector<Queue *> queues_;
+    std::size_t cursor_ = 0;
+    select_notifier notifier_;
+};
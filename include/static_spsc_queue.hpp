@@ -0,0 +1,31 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <memory>
+
+#include "atomic_spsc_queue.hpp"
+
+/// @brief atomic_spsc_queue with a compile-time capacity and inline storage.
+///
+/// @tparam T The type of elements stored in the queue. Must be movable.
+/// @tparam N Capacity. The ring has std::bit_ceil(N) slots, and static_pow2_index_policy<N>
+/// makes capacity and mask constexpr, so the full check and slot math fold to immediates.
+/// @tparam WaitPolicy, StatsPolicy, PublishPolicy As for atomic_spsc_queue.
+///
+/// @details
+/// This is atomic_spsc_queue itself, with the ring held in inline_storage: no heap allocation,
+/// a cache-line-aligned array inside the queue object, and every atomic_spsc_queue feature
+/// (bulk copies, spans, consume_all, async waits, stats, lazy publication).
+///
+/// The default constructor gives capacity N; constructing with any other capacity throws.
+///
+/// @note sizeof(static_spsc_queue) includes the whole ring, so large N belong in static or
+/// heap-allocated storage, not on a thread's stack.
+/// @warning This queue is NOT thread-safe for multiple producers or consumers.
+
+template <class T, std::size_t N, class WaitPolicy = spin_yield_wait, class StatsPolicy = no_stats,
+          class PublishPolicy = eager_publish>
+using static_spsc_queue = atomic_spsc_queue<T, static_pow2_index_policy<N>, WaitPolicy,
+                                            inline_storage<T, static_pow2_index_policy<N>::buffer_size()>,
+                                            StatsPolicy, PublishPolicy>;
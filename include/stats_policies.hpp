@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+
+/// @brief Statistics policies for atomic_spsc_queue.
+///
+/// The queue reports every event to its StatsPolicy from the thread that caused it:
+/// - producer: on_push(n, occupancy) after publishing n items, on_push_failed() when a push
+///   attempt finds the queue full, on_push_wait() before each wait_for_space() call;
+/// - consumer: on_pop(n) after releasing n slots, on_pop_failed() when a pop attempt finds the
+///   queue empty, on_pop_wait() before each wait_for_items() call.
+///
+/// - no_stats (default): empty hooks and enabled == false. The queue skips the occupancy
+///   computation behind on_push() at compile time, so the push/pop path is unchanged.
+/// - queue_stats: counts every event. Each side's counters live on their own cache line and
+///   have exactly one writer, so they are bumped with a relaxed load + store instead of an RMW.
+///   The high-water mark needs the real occupancy, so every publish also loads the other
+///   side's index; that is the price of turning stats on.
+
+struct queue_stats_snapshot
+{
+    std::uint64_t pushes = 0;        // Items published, including bulk pushes and commit().
+    std::uint64_t pops = 0;          // Items released, including bulk pops and release().
+    std::uint64_t failed_pushes = 0; // Push attempts (non-blocking or a blocking retry) that found the queue full.
+    std::uint64_t failed_pops = 0;   // Pop attempts (non-blocking or a blocking retry) that found the queue empty.
+    std::uint64_t push_waits = 0;    // wait_for_space() calls: spins, yields, sleeps or parks, depending on WaitPolicy.
+    std::uint64_t pop_waits = 0;     // wait_for_items() calls.
+    std::size_t high_water = 0;      // Highest occupancy seen right after a push.
+};
+
+template <class P>
+concept stats_policy = std::default_initializable<P> &&
+                       requires(P p, std::size_t n) {
+                           { P::enabled } -> std::convertible_to<bool>;
+                           p.on_push(n, n);
+                           p.on_push_failed();
+                           p.on_push_wait();
+                           p.on_pop(n);
+                           p.on_pop_failed();
+                           p.on_pop_wait();
+                       };
+
+struct no_stats
+{
+    static constexpr bool enabled = false;
+
+    void on_push(std::size_t, std::size_t) {}
+    void on_push_failed() {}
+    void on_push_wait() {}
+    void on_pop(std::size_t) {}
+    void on_pop_failed() {}
+    void on_pop_wait() {}
+};
+
+class queue_stats
+{
+public:
+    static constexpr bool enabled = true;
+
+    void on_push(std::size_t n, std::size_t occupancy)
+    {
+        bump(producer_.pushes, n);
+        if (occupancy > producer_.high_water.load(std::memory_order_relaxed))
+        {
+            producer_.high_water.store(occupancy, std::memory_order_relaxed);
+        }
+    }
+
+    void on_push_failed()
+    {
+        bump(producer_.failed, 1);
+    }
+
+    void on_push_wait()
+    {
+        bump(producer_.waits, 1);
+    }
+
+    void on_pop(std::size_t n)
+    {
+        bump(consumer_.pops, n);
+    }
+
+    void on_pop_failed()
+    {
+        bump(consumer_.failed, 1);
+    }
+
+    void on_pop_wait()
+    {
+        bump(consumer_.waits, 1);
+    }
+
+    // Safe to call from any thread. Counters are read one by one, so a snapshot taken while
+    // both sides run is not a consistent cut (e.g. pops may briefly exceed pushes).
+    queue_stats_snapshot snapshot() const
+    {
+        queue_stats_snapshot s;
+        s.pushes = producer_.pushes.load(std::memory_order_relaxed);
+        s.failed_pushes = producer_.failed.load(std::memory_order_relaxed);
+        s.push_waits = producer_.waits.load(std::memory_order_relaxed);
+        s.high_water = producer_.high_water.load(std::memory_order_relaxed);
+        s.pops = consumer_.pops.load(std::memory_order_relaxed);
+        s.failed_pops = consumer_.failed.load(std::memory_order_relaxed);
+        s.pop_waits = consumer_.waits.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    static constexpr std::size_t cacheline_size = 64;
+
+    // Only the owning side writes a counter, so load + store cannot lose an update.
+    static void bump(std::atomic<std::uint64_t> &counter, std::uint64_t n)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    struct alignas(cacheline_size) producer_side
+    {
+        std::atomic<std::uint64_t> pushes = 0;
+        std::atomic<std::uint64_t> failed = 0;
+        std::atomic<std::uint64_t> waits = 0;
+        std::atomic<std::size_t> high_water = 0;
+    };
+
+    struct alignas(cacheline_size) consumer_side
+    {
+        std::atomic<std::uint64_t> pops = 0;
+        std::atomic<std::uint64_t> failed = 0;
+        std::atomic<std::uint64_t> waits = 0;
+    };
+
+    producer_side producer_;
+    consumer_side consumer_;
+};
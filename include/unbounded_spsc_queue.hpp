@@ -0,0 +1,540 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "atomic_spsc_queue.hpp"
+#include "wait_policies.hpp"
+
+/// @class unbounded_spsc_queue
+/// @brief A single-producer, single-consumer queue that grows instead of getting full.
+///
+/// @tparam T The type of elements stored in the queue. Must be movable.
+/// @tparam WaitPolicy How a blocking pop() waits, see wait_policies.hpp. The producer never waits.
+/// @tparam Allocator Allocates the segments. Rebound for the segment headers.
+///
+/// @details
+/// The queue is a linked list of fixed-size ring segments, indexed like atomic_spsc_queue:
+///
+/// - head_ and tail_ are free-running 64-bit counters; item i lives in slot i & mask of the
+///   segment that covers it. Segments hold std::bit_ceil(segment_capacity) items.
+/// - The producer owns the tail segment. When it is full, the producer links a new segment
+///   (next is released before tail_, so a consumer that sees the item also sees the link).
+/// - The consumer owns the head segment. Once it is drained, the consumer moves on to next and
+///   hands the old segment back to the producer through a small atomic_spsc_queue of spare
+///   segments. Segments that do not fit there are freed.
+/// - The producer takes spare segments before allocating, so once the spares cover the usual
+///   backlog, pushing and popping allocate nothing. Memory follows the actual backlog: a burst
+///   allocates as many segments as it needs, and draining it frees all but the spares.
+///
+/// try_push()/push() only fail once the queue is closed; they throw (without pushing) if a new
+/// segment cannot be allocated. The consumer keeps a cached copy of tail_ as in atomic_spsc_queue;
+/// the producer needs none, since it never checks for free space.
+///
+/// @note The queue is non-copyable and non-movable. Users must stop and join producer and
+/// consumer threads before destroying the queue.
+/// @warning This queue is NOT thread-safe for multiple producers or consumers.
+
+template <class T, class WaitPolicy = spin_yield_wait, class Allocator = std::allocator<T>>
+    requires std::movable<T> && wait_policy<WaitPolicy> && std::same_as<typename Allocator::value_type, T>
+class unbounded_spsc_queue
+{
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+
+    // segment_capacity is rounded up to a power of two. Up to spare_segments drained segments
+    // are kept for reuse.
+    explicit unbounded_spsc_queue(std::size_t segment_capacity, std::size_t spare_segments = 2,
+                                  const Allocator &alloc = Allocator())
+        : segment_size_(checked_segment_size(segment_capacity)), mask_(segment_size_ - 1),
+          spares_(checked_spare_count(spare_segments)), alloc_(alloc)
+    {
+        head_segment_ = tail_segment_ = allocate_segment();
+        head_end_ = tail_end_ = segment_size_;
+    }
+
+    // Non-blocking push. Returns false only if queue is closed.
+    template <typename U>
+        requires std::constructible_from<T, U &&>
+    bool try_push(U &&item)
+    {
+        return try_emplace(std::forward<U>(item));
+    }
+
+    // Push constructing the item directly in its slot from args. Returns false only if queue is closed.
+    template <typename... Args>
+        requires std::constructible_from<T, Args &&...>
+    bool try_emplace(Args &&...args)
+    {
+        if (closed_.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        const std::uint64_t t = tail_.load(std::memory_order_relaxed);
+
+        std::construct_at(producer_slot(t), std::forward<Args>(args)...);
+
+        publish_tail(t + 1);
+        return true;
+    }
+
+    // Same as try_push(): the queue is never full, so there is nothing to wait for.
+    template <typename U>
+        requires std::constructible_from<T, U &&>
+    bool push(U &&item)
+    {
+        return try_push(std::forward<U>(item));
+    }
+
+    // Non-blocking pop. Returns nullopt if queue is empty.
+    std::optional<T> try_pop()
+    {
+        T *item = front();
+        if (item == nullptr)
+        {
+            return std::nullopt;
+        }
+
+        T value = std::move(*item);
+        pop_front();
+        return value;
+    }
+
+    // Non-blocking in-place consume. Invokes f on the oldest item while it is still in its slot,
+    // then releases the slot. Returns false (without invoking f) if queue is empty.
+    // If f throws, the item stays in the queue.
+    template <typename F>
+        requires std::invocable<F, T &>
+    bool try_consume(F &&f)
+    {
+        T *item = front();
+        if (item == nullptr)
+        {
+            return false;
+        }
+
+        std::invoke(std::forward<F>(f), *item);
+        pop_front();
+        return true;
+    }
+
+    // Consumer-side access to the oldest item without removing it. Returns nullptr if queue is empty.
+    // The pointer stays valid until the item is removed by pop_front(), try_pop() or try_consume().
+    T *front()
+    {
+        const std::uint64_t h = head_.load(std::memory_order_relaxed);
+
+        // Empty if head catches tail. Refresh the cached tail only when it says empty.
+        if (h == tail_cache_)
+        {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (h == tail_cache_)
+            {
+                return nullptr;
+            }
+        }
+
+        return consumer_slot(h);
+    }
+
+    // Removes the oldest item. Must only be called after front() returned a non-null pointer.
+    void pop_front()
+    {
+        const std::uint64_t h = head_.load(std::memory_order_relaxed);
+        std::destroy_at(head_segment_->slots + (h & mask_));
+
+        head_.store(h + 1, std::memory_order_release);
+    }
+
+    // Blocking pop. Returns nullopt if queue is closed and empty.
+    std::optional<T> pop()
+    {
+        return pop_until_deadline(no_deadline);
+    }
+
+    // Timed blocking pop. Returns nullopt if queue is closed and empty, or the deadline passes while waiting.
+    template <class Clock, class Duration>
+    std::optional<T> pop_until(const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        return pop_until_deadline(to_steady_deadline(deadline));
+    }
+
+    // Timed blocking pop. Returns nullopt if queue is closed and empty, or timeout expires while waiting.
+    template <class Rep, class Period>
+    std::optional<T> pop_for(const std::chrono::duration<Rep, Period> &timeout)
+    {
+        return pop_until_deadline(deadline_after(timeout));
+    }
+
+    // Bulk push. Pushes all items from [first, last), linking segments as needed, and publishes
+    // tail_ once. Returns the number of items pushed (0 if queue is closed). If constructing an
+    // item or allocating a segment throws, the items pushed so far are still published.
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+        requires std::constructible_from<T, std::iter_reference_t<InputIt>>
+    std::size_t try_push_n(InputIt first, Sentinel last)
+    {
+        if (closed_.load(std::memory_order_acquire) || first == last)
+        {
+            return 0;
+        }
+        const std::uint64_t t = tail_.load(std::memory_order_relaxed);
+
+        std::size_t pushed = 0;
+        try
+        {
+            for (; first != last; ++pushed, ++first)
+            {
+                std::construct_at(producer_slot(t + pushed), *first);
+            }
+        }
+        catch (...)
+        {
+            publish_tail(t + pushed);
+            throw;
+        }
+
+        publish_tail(t + pushed);
+        return pushed;
+    }
+
+    // Same as try_push_n(): the queue is never full, so there is nothing to wait for.
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+        requires std::constructible_from<T, std::iter_reference_t<InputIt>>
+    std::size_t push_n(InputIt first, Sentinel last)
+    {
+        return try_push_n(std::move(first), std::move(last));
+    }
+
+    // Non-blocking bulk pop. Moves up to max items into out and publishes head_ once.
+    // Returns the number of items popped (0 if queue is empty).
+    template <typename OutputIt>
+        requires std::output_iterator<OutputIt, T &&>
+    std::size_t try_pop_n(OutputIt out, std::size_t max)
+    {
+        return pop_batch(out, max);
+    }
+
+    // Blocking bulk pop. Waits until at least one item is available, then moves up to max items into out.
+    // Returns the number of items popped; 0 only if queue is closed and empty (or max is 0).
+    template <typename OutputIt>
+        requires std::output_iterator<OutputIt, T &&>
+    std::size_t pop_n(OutputIt out, std::size_t max)
+    {
+        for (std::size_t spin = 0; max != 0;)
+        {
+            const std::size_t n = pop_batch(out, max);
+            if (n != 0)
+            {
+                return n;
+            }
+
+            if (done())
+            {
+                return 0;
+            }
+
+            wait_.wait_for_items(spin, [this]
+                                 { return items_or_closed(); }, no_deadline);
+        }
+        return 0;
+    }
+
+    // Number of queued items. Exact when called from the producer or the consumer thread.
+    std::size_t size() const
+    {
+        const std::uint64_t h = head_.load(std::memory_order_acquire);
+        return static_cast<std::size_t>(tail_.load(std::memory_order_acquire) - h);
+    }
+
+    // Monitoring variant of size() for any thread: relaxed loads, clamped at 0.
+    std::size_t approx_size() const
+    {
+        const std::uint64_t h = head_.load(std::memory_order_relaxed);
+        const std::uint64_t t = tail_.load(std::memory_order_relaxed);
+        return t <= h ? 0 : static_cast<std::size_t>(t - h);
+    }
+
+    // Items per segment (segment_capacity rounded up to a power of two).
+    std::size_t segment_capacity() const
+    {
+        return segment_size_;
+    }
+
+    // Segments currently allocated: the linked ones plus the spares. Readable from any thread.
+    std::size_t allocated_segments() const
+    {
+        return allocated_.load(std::memory_order_relaxed);
+    }
+
+    allocator_type get_allocator() const
+    {
+        return alloc_;
+    }
+
+    bool closed() const
+    {
+        return closed_.load(std::memory_order_acquire);
+    }
+
+    // True only when producer has called close() and all queued items are drained.
+    bool done() const
+    {
+        if (!closed_.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        const std::uint64_t h = head_.load(std::memory_order_relaxed);
+        return h == tail_.load(std::memory_order_acquire);
+    }
+
+    void close()
+    {
+        // Blocked operations poll this flag and exit.
+        closed_.store(true, std::memory_order_release);
+        wait_.notify_close();
+    }
+
+    // Items that were never popped are destroyed and every segment is freed here. Producer and
+    // consumer threads must be stopped before destroying the queue.
+    ~unbounded_spsc_queue()
+    {
+        close();
+
+        const std::uint64_t t = tail_.load(std::memory_order_acquire);
+        for (std::uint64_t h = head_.load(std::memory_order_relaxed); h != t; ++h)
+        {
+            std::destroy_at(consumer_slot(h));
+        }
+
+        for (segment *s = head_segment_; s != nullptr;)
+        {
+            segment *next = s->next.load(std::memory_order_relaxed);
+            deallocate_segment(s);
+            s = next;
+        }
+        while (std::optional<segment *> s = spares_.try_pop())
+        {
+            deallocate_segment(*s);
+        }
+    }
+
+    // Let's not allow copying or moving the queue
+    unbounded_spsc_queue(const unbounded_spsc_queue &) = delete;
+    unbounded_spsc_queue &operator=(const unbounded_spsc_queue &) = delete;
+    unbounded_spsc_queue(unbounded_spsc_queue &&) = delete;
+    unbounded_spsc_queue &operator=(unbounded_spsc_queue &&) = delete;
+
+private:
+    static constexpr std::size_t cacheline_size = 64;
+
+    struct segment
+    {
+        std::atomic<segment *> next = nullptr;
+        T *slots = nullptr;
+    };
+
+    using alloc_traits = std::allocator_traits<Allocator>;
+    using segment_alloc_traits = typename alloc_traits::template rebind_traits<segment>;
+
+    static std::size_t checked_segment_size(std::size_t segment_capacity)
+    {
+        if (segment_capacity == 0 || segment_capacity > std::numeric_limits<std::size_t>::max() / 2 + 1)
+        {
+            throw std::invalid_argument("Invalid segment capacity: " + std::to_string(segment_capacity));
+        }
+        return std::bit_ceil(segment_capacity);
+    }
+
+    static std::size_t checked_spare_count(std::size_t spare_segments)
+    {
+        if (spare_segments == 0)
+        {
+            throw std::invalid_argument("Invalid spare segment count: " + std::to_string(spare_segments));
+        }
+        return spare_segments;
+    }
+
+    segment *allocate_segment()
+    {
+        typename segment_alloc_traits::allocator_type segment_alloc(alloc_);
+        segment *s = segment_alloc_traits::allocate(segment_alloc, 1);
+        try
+        {
+            s = std::construct_at(s);
+            s->slots = alloc_traits::allocate(alloc_, segment_size_);
+        }
+        catch (...)
+        {
+            segment_alloc_traits::deallocate(segment_alloc, s, 1);
+            throw;
+        }
+        allocated_.fetch_add(1, std::memory_order_relaxed);
+        return s;
+    }
+
+    void deallocate_segment(segment *s)
+    {
+        alloc_traits::deallocate(alloc_, s->slots, segment_size_);
+        typename segment_alloc_traits::allocator_type segment_alloc(alloc_);
+        std::destroy_at(s);
+        segment_alloc_traits::deallocate(segment_alloc, s, 1);
+        allocated_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Producer: slot for counter t, linking a new tail segment if the current one is full.
+    // The link is published by the next publish_tail().
+    T *producer_slot(std::uint64_t t)
+    {
+        if (t == tail_end_)
+        {
+            segment *s = nullptr;
+            if (std::optional<segment *> spare = spares_.try_pop())
+            {
+                s = *spare;
+                s->next.store(nullptr, std::memory_order_relaxed);
+            }
+            else
+            {
+                s = allocate_segment();
+            }
+            tail_segment_->next.store(s, std::memory_order_release);
+            tail_segment_ = s;
+            tail_end_ += segment_size_;
+        }
+        return tail_segment_->slots + (t & mask_);
+    }
+
+    // Consumer: slot of the published item h. Moves on to the next segment once the head segment
+    // is drained; the producer linked it before publishing h.
+    T *consumer_slot(std::uint64_t h)
+    {
+        if (h == head_end_)
+        {
+            segment *drained = head_segment_;
+            head_segment_ = drained->next.load(std::memory_order_acquire);
+            head_end_ += segment_size_;
+            recycle(drained);
+        }
+        return head_segment_->slots + (h & mask_);
+    }
+
+    // Consumer: hands a drained segment back to the producer, or frees it if enough are spare.
+    void recycle(segment *s)
+    {
+        if (!spares_.try_push(s))
+        {
+            deallocate_segment(s);
+        }
+    }
+
+    std::optional<T> pop_until_deadline(std::chrono::steady_clock::time_point deadline)
+    {
+        for (std::size_t spin = 0;;)
+        {
+            auto item = try_pop();
+            if (item.has_value())
+            {
+                return item;
+            }
+
+            if (done())
+            {
+                return std::nullopt;
+            }
+
+            if (!wait_.wait_for_items(spin, [this]
+                                      { return items_or_closed(); }, deadline))
+            {
+                return std::nullopt;
+            }
+        }
+    }
+
+    // Publishes tail_ and lets the wait policy wake a parked consumer.
+    void publish_tail(std::uint64_t t)
+    {
+        tail_.store(t, std::memory_order_release);
+        wait_.notify_items();
+    }
+
+    // Wake-up predicate of a blocked consumer.
+    bool items_or_closed() const
+    {
+        return closed() || head_.load(std::memory_order_relaxed) != tail_.load(std::memory_order_acquire);
+    }
+
+    // Moves up to max items into out. head_ is published once. If writing to out throws, the
+    // items moved so far are still released.
+    template <typename OutputIt>
+    std::size_t pop_batch(OutputIt &out, std::size_t max)
+    {
+        const std::uint64_t h = head_.load(std::memory_order_relaxed);
+
+        // Refresh the cached tail only if it does not cover the whole batch.
+        std::size_t available = static_cast<std::size_t>(tail_cache_ - h);
+        if (available < max)
+        {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            available = static_cast<std::size_t>(tail_cache_ - h);
+        }
+
+        const std::size_t n = std::min(available, max);
+        std::size_t popped = 0;
+        try
+        {
+            for (; popped < n; ++popped, ++out)
+            {
+                T *item = consumer_slot(h + popped);
+                *out = std::move(*item);
+                std::destroy_at(item);
+            }
+        }
+        catch (...)
+        {
+            head_.store(h + popped, std::memory_order_release);
+            throw;
+        }
+
+        if (n != 0)
+        {
+            head_.store(h + n, std::memory_order_release);
+        }
+        return n;
+    }
+
+    const std::size_t segment_size_;
+    const std::size_t mask_;
+    // Drained segments on their way back to the producer.
+    atomic_spsc_queue<segment *, pow2_index_policy> spares_;
+    [[no_unique_address]] Allocator alloc_;
+    // Consumer-owned line: head_, the cached tail_ and the head segment.
+    alignas(cacheline_size)
+        std::atomic<std::uint64_t> head_ = 0;
+    std::uint64_t tail_cache_ = 0;
+    segment *head_segment_ = nullptr;
+    std::uint64_t head_end_ = 0;
+    // Producer-owned line: tail_ and the tail segment.
+    alignas(cacheline_size)
+        std::atomic<std::uint64_t> tail_ = 0;
+    segment *tail_segment_ = nullptr;
+    std::uint64_t tail_end_ = 0;
+    alignas(cacheline_size)
+        std::atomic<bool> closed_ = false;
+    std::atomic<std::size_t> allocated_ = 0;
+    [[no_unique_address]] WaitPolicy wait_;
+};
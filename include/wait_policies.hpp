@@ -0,0 +1,529 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/// @brief Wait policies for the blocking operations of atomic_spsc_queue.
+///
+/// After every failed attempt a blocked producer calls wait_for_space() and a blocked
+/// consumer calls wait_for_items(), passing its spin counter (0 at the start of the blocking
+/// call), a predicate that tells whether retrying makes sense (space/items available or
+/// queue closed) and a steady_clock deadline (no_deadline for untimed operations). The wait
+/// returns false once the deadline has passed, true if the caller should retry. The queue
+/// calls notify_space() after releasing slots, notify_items() after publishing items and
+/// notify_close() from close().
+///
+/// The policy is a template parameter of the queue, so the choice compiles away: policies
+/// whose notifications are no-ops leave the push/pop hot path unchanged.
+///
+/// - busy_spin_wait: spin with a CPU pause hint, never give up the core. Lowest wake-up latency.
+/// - spin_yield_wait (default): spin, yield() every 1024 failed attempts.
+/// - backoff_wait<MaxPauses>: exponential backoff, doubling the pause hints per failed attempt
+///   up to MaxPauses, then yield() on every further attempt.
+/// - yield_wait: yield() after every failed attempt.
+/// - sleep_wait<Micros>: sleep for Micros microseconds after every failed attempt.
+/// - park_wait<SpinBudget>: spin with pause hints for SpinBudget failed attempts, then park on a
+///   futex word. Each side advertises that it is parked with a flag, and the notifying side only
+///   bumps the word and issues a wake syscall when it sees that flag. The price is a seq_cst
+///   fence per publish so the flag check cannot miss a waiter that is about to park.
+/// - condvar_wait<SpinBudget>: same scheme as park_wait, but a side that runs out of spins sleeps
+///   on a condition variable. The mutex and condition variable are touched only by a side that is
+///   about to sleep and by a notifier that sees its waiting flag, so a queue that never runs
+///   full or empty never takes the lock. Portable, and timed waits use wait_until().
+///
+/// Deadlines: spinning policies read the clock only every deadline_check_interval failed attempts,
+/// so the check does not dominate a spin iteration. Policies that give up the core check it on
+/// every attempt and never sleep or park past it.
+
+inline constexpr std::chrono::steady_clock::time_point no_deadline = std::chrono::steady_clock::time_point::max();
+inline constexpr std::size_t deadline_check_interval = 64;
+
+template <class P>
+concept wait_policy = std::default_initializable<P> &&
+                      requires(P p, std::size_t &spin, bool (*ready)(), std::chrono::steady_clock::time_point deadline) {
+                          { p.wait_for_space(spin, ready, deadline) } -> std::same_as<bool>;
+                          { p.wait_for_items(spin, ready, deadline) } -> std::same_as<bool>;
+                          p.notify_space();
+                          p.notify_items();
+                          p.notify_close();
+                      };
+
+// Tells the CPU that we are in a spin loop (PAUSE on x86, YIELD on ARM).
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+}
+
+// Converts a deadline on any clock into a steady_clock deadline.
+template <class Clock, class Duration>
+std::chrono::steady_clock::time_point to_steady_deadline(const std::chrono::time_point<Clock, Duration> &deadline)
+{
+    if constexpr (std::is_same_v<Clock, std::chrono::steady_clock>)
+    {
+        return std::chrono::time_point_cast<std::chrono::steady_clock::duration>(deadline);
+    }
+    else
+    {
+        return std::chrono::steady_clock::now() +
+               std::chrono::ceil<std::chrono::steady_clock::duration>(deadline - Clock::now());
+    }
+}
+
+// steady_clock deadline timeout from now. Timeouts too large to represent map to no_deadline.
+template <class Rep, class Period>
+std::chrono::steady_clock::time_point deadline_after(const std::chrono::duration<Rep, Period> &timeout)
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (timeout >= no_deadline - now)
+    {
+        return no_deadline;
+    }
+    return now + std::chrono::ceil<std::chrono::steady_clock::duration>(timeout);
+}
+
+// True if deadline has passed. Cheap for untimed operations, which never read the clock.
+inline bool deadline_passed(std::chrono::steady_clock::time_point deadline)
+{
+    return deadline != no_deadline && std::chrono::steady_clock::now() >= deadline;
+}
+
+// Same as deadline_passed(), but reads the clock only on every deadline_check_interval-th spin.
+inline bool spin_deadline_passed(std::size_t spin, std::chrono::steady_clock::time_point deadline)
+{
+    return deadline != no_deadline && spin % deadline_check_interval == 0 && std::chrono::steady_clock::now() >= deadline;
+}
+
+namespace detail
+{
+    // Blocks while word == expected, until futex_wake() or until timeout passes (forever if timeout is null).
+    // May return spuriously; callers re-check their condition.
+    inline void futex_wait(std::atomic<std::uint32_t> &word, std::uint32_t expected, const std::chrono::nanoseconds *timeout)
+    {
+#if defined(__linux__)
+        timespec ts{};
+        if (timeout != nullptr)
+        {
+            ts.tv_sec = static_cast<time_t>(timeout->count() / 1000000000);
+            ts.tv_nsec = static_cast<long>(timeout->count() % 1000000000);
+        }
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAIT_PRIVATE, expected,
+                timeout != nullptr ? &ts : nullptr, nullptr, 0);
+#else
+        if (timeout == nullptr)
+        {
+            word.wait(expected, std::memory_order_acquire);
+        }
+        else
+        {
+            // std::atomic::wait has no timeout; nap in short slices and let the caller re-check.
+            std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(*timeout, std::chrono::microseconds(100)));
+        }
+#endif
+    }
+
+    inline void futex_wake(std::atomic<std::uint32_t> &word, bool all)
+    {
+#if defined(__linux__)
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1,
+                nullptr, nullptr, 0);
+#else
+        all ? word.notify_all() : word.notify_one();
+#endif
+    }
+} // namespace detail
+
+// Base for policies that only react to their own failed attempts and need no notifications.
+struct no_notify_wait
+{
+    void notify_space() {}
+    void notify_items() {}
+    void notify_close() {}
+};
+
+struct busy_spin_wait : no_notify_wait
+{
+    template <typename Ready>
+    bool wait_for_space(std::size_t &spin, Ready &&, std::chrono::steady_clock::time_point deadline)
+    {
+        return spin_once(spin, deadline);
+    }
+
+    template <typename Ready>
+    bool wait_for_items(std::size_t &spin, Ready &&, std::chrono::steady_clock::time_point deadline)
+    {
+        return spin_once(spin, deadline);
+    }
+
+private:
+    static bool spin_once(std::size_t &spin, std::chrono::steady_clock::time_point deadline)
+    {
+        if (spin_deadline_passed(++spin, deadline))
+        {
+            return false;
+        }
+        cpu_relax();
+        return true;
+    }
+};
+
+struct spin_yield_wait : no_notify_wait
+{
+    static constexpr std::size_t yield_after = 1024;
+
+    template <typename Ready>
+    bool wait_for_space(std::size_t &spin, Ready &&, std::chrono::steady_clock::time_point deadline)
+    {
+        return backoff(spin, deadline);
+    }
+
+    template <typename Ready>
+    bool wait_for_items(std::size_t &spin, Ready &&, std::chrono::steady_clock::time_point deadline)
+    {
+        return backoff(spin, deadline);
+    }
+
+private:
+    static bool backoff(std::size_t &spin, std::chrono::steady_clock::time_point deadline)
+    {
+        if (spin_deadline_passed(++spin, deadline))
+        {
+            return false;
+        }
+        if (spin >= yield_after)
+        {
+            std::this_thread::yield();
+            spin = 0;
+        }
+        return true;
+    }
+};
+
+template <std::size_t MaxPauses = 1024>
+struct backoff_wait : no_notify_wait
+{
+    template <typename Ready>
+    bool wait_for_space(std::size_t &spin, Ready &&, std::chrono::steady_clock::time_point deadline)
+    {
+        return backoff(spin, deadline);
+    }
+
+    template <typename Ready>
+    bool wait_for_items(std::size_t &spin, Ready &&, std::chrono::steady_clock::time_point deadline)
+    {
+        return backoff(spin, deadline);
+    }
+
+private:
+    // spin holds the number of pause hints issued on the previous attempt. The early attempts
+    // are short, so the clock is read only once the pauses have grown to deadline_check_interval,
+    // or to MaxPauses if the pauses stop growing before that.
+    static constexpr std::size_t deadline_check_from = std::min(MaxPauses, deadline_check_interval);
+
+    static bool backoff(std::size_t &spin, std::chrono::steady_clock::time_point deadline)
+    {
+        if (spin >= deadline_check_from && deadline_passed(deadline))
+        {
+            return false;
+        }
+        if (spin >= MaxPauses)
+        {
+            std::this_thread::yield();
+            return true;
+        }
+
+        spin = spin == 0 ? 1 : spin * 2;
+        for (std::size_t i = 0; i < spin; ++i)
+        {
+            cpu_relax();
+        }
+        return true;
+    }
+};
+
+struct yield_wait : no_notify_wait
+{
+    template <typename Ready>
+    bool wait_for_space(std::size_t &, Ready &&, std::chrono::steady_clock::time_point deadline)
+    {
+        return yield_once(deadline);
+    }
+
+    template <typename Ready>
+    bool wait_for_items(std::size_t &, Ready &&, std::chrono::steady_clock::time_point deadline)
+    {
+        return yield_once(deadline);
+    }
+
+private:
+    static bool yield_once(std::chrono::steady_clock::time_point deadline)
+    {
+        if (deadline_passed(deadline))
+        {
+            return false;
+        }
+        std::this_thread::yield();
+        return true;
+    }
+};
+
+template <std::size_t Micros = 50>
+struct sleep_wait : no_notify_wait
+{
+    template <typename Ready>
+    bool wait_for_space(std::size_t &, Ready &&, std::chrono::steady_clock::time_point deadline)
+    {
+        return nap(deadline);
+    }
+
+    template <typename Ready>
+    bool wait_for_items(std::size_t &, Ready &&, std::chrono::steady_clock::time_point deadline)
+    {
+        return nap(deadline);
+    }
+
+private:
+    static bool nap(std::chrono::steady_clock::time_point deadline)
+    {
+        constexpr auto interval = std::chrono::microseconds(Micros);
+        if (deadline == no_deadline)
+        {
+            std::this_thread::sleep_for(interval);
+            return true;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(interval, deadline - now));
+        return true;
+    }
+};
+
+template <std::size_t SpinBudget = 4096>
+class park_wait
+{
+public:
+    template <typename Ready>
+    bool wait_for_space(std::size_t &spin, Ready &&ready, std::chrono::steady_clock::time_point deadline)
+    {
+        return park(producer_, spin, ready, deadline);
+    }
+
+    template <typename Ready>
+    bool wait_for_items(std::size_t &spin, Ready &&ready, std::chrono::steady_clock::time_point deadline)
+    {
+        return park(consumer_, spin, ready, deadline);
+    }
+
+    void notify_space()
+    {
+        wake(producer_);
+    }
+
+    void notify_items()
+    {
+        wake(consumer_);
+    }
+
+    void notify_close()
+    {
+        // close() is rare, so wake unconditionally and let waiters re-check the closed flag.
+        for (side *s : {&producer_, &consumer_})
+        {
+            s->epoch.fetch_add(1, std::memory_order_release);
+            detail::futex_wake(s->epoch, true);
+        }
+    }
+
+private:
+    static constexpr std::size_t cacheline_size = 64;
+
+    // Parking state of one side. epoch is the futex word, parked tells the other side to wake it.
+    struct alignas(cacheline_size) side
+    {
+        std::atomic<std::uint32_t> epoch = 0;
+        std::atomic<bool> parked = false;
+    };
+
+    template <typename Ready>
+    static bool park(side &s, std::size_t &spin, Ready &ready, std::chrono::steady_clock::time_point deadline)
+    {
+        if (++spin < SpinBudget)
+        {
+            if (spin_deadline_passed(spin, deadline))
+            {
+                return false;
+            }
+            cpu_relax();
+            return true;
+        }
+        spin = 0;
+
+        std::chrono::nanoseconds timeout{};
+        if (deadline != no_deadline)
+        {
+            timeout = deadline - std::chrono::steady_clock::now();
+            if (timeout <= std::chrono::nanoseconds::zero())
+            {
+                return false;
+            }
+        }
+
+        // Read the epoch before advertising, so a wake between the check and futex_wait() is not lost.
+        const std::uint32_t epoch = s.epoch.load(std::memory_order_acquire);
+        s.parked.store(true, std::memory_order_relaxed);
+        // Pairs with the fence in wake(): either we see the new state or the notifier sees parked.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!ready())
+        {
+            detail::futex_wait(s.epoch, epoch, deadline != no_deadline ? &timeout : nullptr);
+        }
+        s.parked.store(false, std::memory_order_relaxed);
+        return true;
+    }
+
+    static void wake(side &s)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (s.parked.load(std::memory_order_relaxed))
+        {
+            s.epoch.fetch_add(1, std::memory_order_release);
+            detail::futex_wake(s.epoch, false);
+        }
+    }
+
+    side producer_;
+    side consumer_;
+};
+
+template <std::size_t SpinBudget = 256>
+class condvar_wait
+{
+public:
+    template <typename Ready>
+    bool wait_for_space(std::size_t &spin, Ready &&ready, std::chrono::steady_clock::time_point deadline)
+    {
+        return sleep(producer_, spin, ready, deadline);
+    }
+
+    template <typename Ready>
+    bool wait_for_items(std::size_t &spin, Ready &&ready, std::chrono::steady_clock::time_point deadline)
+    {
+        return sleep(consumer_, spin, ready, deadline);
+    }
+
+    void notify_space()
+    {
+        wake(producer_);
+    }
+
+    void notify_items()
+    {
+        wake(consumer_);
+    }
+
+    void notify_close()
+    {
+        // close() is rare, so wake unconditionally and let waiters re-check the closed flag.
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+        }
+        producer_.cv.notify_all();
+        consumer_.cv.notify_all();
+    }
+
+private:
+    static constexpr std::size_t cacheline_size = 64;
+
+    // Sleeping state of one side. waiting tells the other side to take the mutex and notify cv.
+    struct alignas(cacheline_size) side
+    {
+        std::atomic<bool> waiting = false;
+        std::condition_variable cv;
+    };
+
+    template <typename Ready>
+    bool sleep(side &s, std::size_t &spin, Ready &ready, std::chrono::steady_clock::time_point deadline)
+    {
+        if (++spin < SpinBudget)
+        {
+            if (spin_deadline_passed(spin, deadline))
+            {
+                return false;
+            }
+            cpu_relax();
+            return true;
+        }
+        spin = 0;
+
+        if (deadline_passed(deadline))
+        {
+            return false;
+        }
+
+        // The flag is set and the state re-checked under the mutex, and cv.wait() releases it
+        // atomically, so a notifier that sees the flag cannot notify before we sleep.
+        std::unique_lock<std::mutex> lock(mtx_);
+        s.waiting.store(true, std::memory_order_relaxed);
+        // Pairs with the fence in wake(): either we see the new state or the notifier sees waiting.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!ready())
+        {
+            if (deadline == no_deadline)
+            {
+                s.cv.wait(lock);
+            }
+            else
+            {
+                s.cv.wait_until(lock, deadline);
+            }
+        }
+        s.waiting.store(false, std::memory_order_relaxed);
+        return true;
+    }
+
+    void wake(side &s)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (s.waiting.load(std::memory_order_relaxed))
+        {
+            // Taking the mutex waits until the sleeper is inside cv.wait().
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+            }
+            s.cv.notify_one();
+        }
+    }
+
+    // Shared by both sides; only taken by a side about to sleep and by a notifier that saw it waiting.
+    std::mutex mtx_;
+    side producer_;
+    side consumer_;
+};
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/// @brief Thread pinning helpers for the benchmark.
+///
+/// - CpuInfo / read_cpu_topology(): online CPUs with their core and package (socket) ids,
+///   read from /sys/devices/system/cpu. Two CPUs with the same package and core id are SMT
+///   siblings of one physical core.
+/// - PinPreset / cpus_for(): picks a producer/consumer CPU pair for a placement preset.
+/// - pin_current_thread(): restricts the calling thread to one CPU.
+///
+/// Everything degrades to "no pinning" on non-Linux platforms.
+
+struct CpuInfo
+{
+    int cpu = 0;
+    int core = 0;
+    int package = 0;
+};
+
+enum class PinPreset
+{
+    none,
+    same_core,
+    same_socket,
+    cross_socket
+};
+
+struct CpuPair
+{
+    int producer = -1;
+    int consumer = -1;
+};
+
+namespace cpu_affinity_detail
+{
+#if defined(__linux__)
+    inline std::optional<int> read_int(const std::string &path)
+    {
+        std::ifstream in(path);
+        int value = 0;
+        if (!(in >> value))
+        {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    // Parses a sysfs CPU list such as "0-3,8,10-11".
+    inline std::vector<int> parse_cpu_list(const std::string &list)
+    {
+        std::vector<int> out;
+        std::stringstream ss(list);
+        std::string range;
+        while (std::getline(ss, range, ','))
+        {
+            const auto dash = range.find('-');
+            const int first = std::stoi(range.substr(0, dash));
+            const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu)
+            {
+                out.push_back(cpu);
+            }
+        }
+        return out;
+    }
+#endif
+} // namespace cpu_affinity_detail
+
+inline std::vector<CpuInfo> read_cpu_topology()
+{
+    std::vector<CpuInfo> out;
+#if defined(__linux__)
+    std::ifstream online("/sys/devices/system/cpu/online");
+    std::string list;
+    if (!std::getline(online, list))
+    {
+        return out;
+    }
+
+    for (int cpu : cpu_affinity_detail::parse_cpu_list(list))
+    {
+        const std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+        const auto core = cpu_affinity_detail::read_int(base + "core_id");
+        const auto package = cpu_affinity_detail::read_int(base + "physical_package_id");
+        if (core.has_value() && package.has_value())
+        {
+            out.push_back(CpuInfo{cpu, *core, *package});
+        }
+    }
+#endif
+    return out;
+}
+
+// Producer gets the first online CPU, the consumer a CPU that matches the preset relative to it.
+// Returns nullopt if the machine has no such pair (e.g. cross_socket on a single-socket box).
+inline std::optional<CpuPair> cpus_for(PinPreset preset, const std::vector<CpuInfo> &topology)
+{
+    if (preset == PinPreset::none)
+    {
+        return CpuPair{};
+    }
+    if (topology.empty())
+    {
+        return std::nullopt;
+    }
+
+    const CpuInfo &producer = topology.front();
+    const auto matches = [&](const CpuInfo &c)
+    {
+        if (c.cpu == producer.cpu)
+        {
+            return false;
+        }
+        switch (preset)
+        {
+        case PinPreset::same_core:
+            return c.package == producer.package && c.core == producer.core;
+        case PinPreset::same_socket:
+            return c.package == producer.package && c.core != producer.core;
+        case PinPreset::cross_socket:
+            return c.package != producer.package;
+        case PinPreset::none:
+            break;
+        }
+        return false;
+    };
+
+    const auto consumer = std::find_if(topology.begin(), topology.end(), matches);
+    if (consumer == topology.end())
+    {
+        return std::nullopt;
+    }
+    return CpuPair{producer.cpu, consumer->cpu};
+}
+
+// Pins the calling thread to cpu. A negative cpu leaves the thread unpinned.
+// Returns false if the OS rejected the affinity mask.
+inline bool pin_current_thread(int cpu)
+{
+    if (cpu < 0)
+    {
+        return true;
+    }
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/// @class LatencyHistogram
+/// @brief Log-bucketed (HDR-style) histogram of latencies in nanoseconds.
+///
+/// @details
+/// - Values below 2^sub_bits are counted exactly.
+/// - Above that, every power of two is split into 2^(sub_bits - 1) linear sub-buckets,
+///   so a reported percentile is within 2^-(sub_bits - 1) (~1.6%) of the recorded value.
+/// - Values above 2^max_bits ns (~18 minutes) are clamped into the last bucket.
+/// - Storage is a fixed std::array, so record() never allocates and can be called on the
+///   measured thread without perturbing the run.
+
+class LatencyHistogram
+{
+public:
+    void record(std::uint64_t ns)
+    {
+        ns = std::min(ns, max_value);
+        ++counts_[index_of(ns)];
+        ++total_;
+        max_ = std::max(max_, ns);
+    }
+
+    std::uint64_t count() const
+    {
+        return total_;
+    }
+
+    std::uint64_t max() const
+    {
+        return max_;
+    }
+
+    // Highest value equivalent to the bucket holding the q-quantile (q in [0, 1]).
+    std::uint64_t percentile(double q) const
+    {
+        if (total_ == 0)
+        {
+            return 0;
+        }
+
+        const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(total_))));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < bucket_count; ++i)
+        {
+            seen += counts_[i];
+            if (seen >= rank)
+            {
+                return std::min(highest_equivalent(i), max_);
+            }
+        }
+        return max_;
+    }
+
+private:
+    static constexpr unsigned sub_bits = 7;
+    static constexpr unsigned max_bits = 40;
+    static constexpr std::uint64_t sub_count = std::uint64_t{1} << sub_bits;
+    static constexpr std::uint64_t half_count = sub_count / 2;
+    static constexpr std::uint64_t max_value = (std::uint64_t{1} << max_bits) - 1;
+    static constexpr std::size_t bucket_count = sub_count + (max_bits - sub_bits) * half_count;
+
+    static std::size_t index_of(std::uint64_t v)
+    {
+        if (v < sub_count)
+        {
+            return static_cast<std::size_t>(v);
+        }
+
+        // v >> shift keeps the top sub_bits bits of v, i.e. a value in [half_count, sub_count).
+        const unsigned shift = static_cast<unsigned>(std::bit_width(v)) - sub_bits;
+        return static_cast<std::size_t>(sub_count + (shift - 1) * half_count + ((v >> shift) - half_count));
+    }
+
+    static std::uint64_t highest_equivalent(std::size_t i)
+    {
+        if (i < sub_count)
+        {
+            return i;
+        }
+
+        const std::uint64_t k = i - sub_count;
+        const unsigned shift = static_cast<unsigned>(k / half_count) + 1;
+        const std::uint64_t mantissa = k % half_count + half_count;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    std::array<std::uint64_t, bucket_count> counts_{};
+    std::uint64_t total_ = 0;
+    std::uint64_t max_ = 0;
+};
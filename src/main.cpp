@@ -1,14 +1,32 @@
 #include "atomic_spsc_queue.hpp"
+#include "broadcast_queue.hpp"
+#include "message_pool.hpp"
+#include "mmap_allocator.hpp"
+#include "mpmc_queue.hpp"
 #include "simple_spsc_queue.hpp"
+#include "slot_spsc_queue.hpp"
+#include "unbounded_spsc_queue.hpp"
+#include "cpu_affinity.hpp"
+#include "latency_histogram.hpp"
+#include "thread_probe.hpp"
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <cassert>
 #include <chrono>
 #include <cmath>
+#include <concepts>
 #include <cstdint>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <type_traits>
 #include <vector>
@@ -17,22 +35,171 @@
 namespace
 {
 
-    constexpr std::size_t item_count = 1000000;
-    constexpr std::size_t repeat_count = 20;
     constexpr std::size_t default_capacity = 1024;
     constexpr std::array<std::size_t, 3> standard_capacities{64, 1024, 8192};
-    constexpr std::size_t heavy_cycles = 128;
+    constexpr std::array<std::size_t, 7> payload_sizes{16, 32, 64, 128, 256, 512, 1024};
+    // Payload sizes and batch size of the bulk-copy scenario.
+    constexpr std::array<std::size_t, 3> bulk_copy_payload_sizes{64, 256, 1024};
+    constexpr std::size_t bulk_copy_batch = 64;
+    // Ring size of the first-lap scenario: 16MB of LatencyPayload slots.
+    constexpr std::size_t large_capacity = std::size_t{1} << 20;
+
+    // All atomic rows allocate their ring through mmap_allocator so --numa-node and
+    // --first-touch apply to them. With default options it is a plain anonymous mapping.
+    template <class T, class IndexPolicy = modulo_index_policy, class WaitPolicy = spin_yield_wait>
+    using bench_atomic_queue = atomic_spsc_queue<T, IndexPolicy, WaitPolicy, mmap_allocator<T>>;
+
+    template <class T>
+    using atomic_pow2_spsc_queue = bench_atomic_queue<T, pow2_index_policy>;
+
+    // mmap_allocator as a distinct type, so make_queue() can give the atomic-huge rings
+    // prefaulted 2MB pages without a command-line switch.
+    template <class T>
+    struct huge_page_allocator : mmap_allocator<T>
+    {
+        using mmap_allocator<T>::mmap_allocator;
+    };
+
+    template <class T>
+    using atomic_huge_queue = atomic_spsc_queue<T, modulo_index_policy, spin_yield_wait, huge_page_allocator<T>>;
+
+    // The atomic ring with non-temporal stores for bulk pushes of contiguous trivially copyable items.
+    template <class T>
+    struct atomic_stream_queue : bench_atomic_queue<T>
+    {
+        using bench_atomic_queue<T>::bench_atomic_queue;
+
+        template <class It>
+        std::size_t push_n(It first, It last)
+        {
+            if constexpr (contiguous_source_of<It, T>)
+            {
+                return bench_atomic_queue<T>::push_n(first, last, streaming_copy);
+            }
+            else
+            {
+                return bench_atomic_queue<T>::push_n(first, last);
+            }
+        }
+    };
+
+    template <class Queue>
+    concept mmap_backed = std::derived_from<typename Queue::allocator_type, mmap_allocator<typename Queue::value_type>>;
+
+    template <class WaitPolicy>
+    struct atomic_wait_queue
+    {
+        template <class T>
+        using type = bench_atomic_queue<T, modulo_index_policy, WaitPolicy>;
+    };
+
+    // Both sides publish their index once every K operations; the atomic row is K = 1.
+    template <std::size_t K>
+    struct atomic_lazy_queue
+    {
+        template <class T>
+        using type = atomic_spsc_queue<T, modulo_index_policy, spin_yield_wait, mmap_allocator<T>, no_stats, lazy_publish<K>>;
+    };
+
+    // Per-slot full flags instead of shared indices; one cache line per slot, or packed slots.
+    template <class T>
+    using bench_slot_queue = slot_spsc_queue<T>;
+
+    template <class T>
+    using slot_packed_queue = slot_spsc_queue<T, spin_yield_wait, alignof(T)>;
+
+    // Linked ring segments; the capacity column is the segment size.
+    template <class T>
+    using bench_unbounded_queue = unbounded_spsc_queue<T>;
+
+    template <class T>
+    using bench_mpsc_queue = mpsc_queue<T>;
+
+    template <class T>
+    using bench_mpmc_queue = mpmc_queue<T>;
+
+    // One ring read by every reader; the fan-out scenario gives every other queue one instance per reader.
+    template <class T>
+    using bench_broadcast_queue = broadcast_queue<T>;
+
+    template <class Queue>
+    constexpr bool broadcasting = false;
+
+    template <class T, class WaitPolicy>
+    constexpr bool broadcasting<broadcast_queue<T, WaitPolicy>> = true;
+
+    // Queues that several producers may share. The fan-in scenario gives every other queue one
+    // instance per producer.
+    template <class Queue>
+    constexpr bool multi_producer = false;
+
+    template <class T, class WaitPolicy, bool MultiConsumer>
+    constexpr bool multi_producer<mp_queue<T, WaitPolicy, MultiConsumer>> = true;
+
+    // Where the producer/consumer threads run and where the atomic rings live.
+    // Set once from the command line before any benchmark thread starts.
+    struct Placement
+    {
+        PinPreset preset = PinPreset::none;
+        CpuPair cpus{};
+        int numa_node = -1;
+        bool consumer_first_touch = false;
+    };
+
+    Placement placement;
 
     enum class QueueKind
     {
         simple,
         atomic,
+        atomic_pow2,
+        atomic_busy_spin,
+        atomic_backoff,
+        atomic_yield,
+        atomic_sleep,
+        atomic_park,
+        atomic_condvar,
+        atomic_huge,
+        atomic_stream,
+        atomic_lazy_4,
+        atomic_lazy_16,
+        atomic_lazy_64,
+        slot,
+        slot_packed,
+        unbounded,
+        mpsc,
+        mpmc,
+        broadcast,
+    };
+
+    constexpr std::array<QueueKind, 20> all_queue_kinds{
+        QueueKind::simple,
+        QueueKind::atomic,
+        QueueKind::atomic_pow2,
+        QueueKind::atomic_busy_spin,
+        QueueKind::atomic_backoff,
+        QueueKind::atomic_yield,
+        QueueKind::atomic_sleep,
+        QueueKind::atomic_park,
+        QueueKind::atomic_condvar,
+        QueueKind::atomic_huge,
+        QueueKind::atomic_stream,
+        QueueKind::atomic_lazy_4,
+        QueueKind::atomic_lazy_16,
+        QueueKind::atomic_lazy_64,
+        QueueKind::slot,
+        QueueKind::slot_packed,
+        QueueKind::unbounded,
+        QueueKind::mpsc,
+        QueueKind::mpmc,
+        QueueKind::broadcast,
     };
 
     enum class Mode
     {
         blocking,
-        nonblocking
+        nonblocking,
+        batched
     };
 
     enum class Scenario
@@ -41,35 +208,246 @@ namespace
         nonblocking_standard,
         big_payload,
         producer_heavy,
-        consumer_heavy
+        consumer_heavy,
+        batched,
+        latency,
+        fan_in,
+        vector_payload,
+        pooled_payload,
+        first_lap,
+        bulk_copy,
+        pipeline,
+        ping_pong,
+        fan_out
+    };
+
+    constexpr std::array<Scenario, 15> all_scenarios{
+        Scenario::blocking_standard,
+        Scenario::nonblocking_standard,
+        Scenario::big_payload,
+        Scenario::producer_heavy,
+        Scenario::consumer_heavy,
+        Scenario::batched,
+        Scenario::latency,
+        Scenario::fan_in,
+        Scenario::vector_payload,
+        Scenario::pooled_payload,
+        Scenario::first_lap,
+        Scenario::bulk_copy,
+        Scenario::pipeline,
+        Scenario::ping_pong,
+        Scenario::fan_out,
+    };
+
+    enum class OutputFormat
+    {
+        table,
+        json,
+        csv
+    };
+
+    // Benchmark parameters. The defaults run the full matrix; the command line narrows or
+    // resizes it. Set once before any benchmark thread starts.
+    struct BenchConfig
+    {
+        std::size_t items = 1000000;
+        std::size_t repeats = 20;
+        std::vector<QueueKind> queues{all_queue_kinds.begin(), all_queue_kinds.end()};
+        // Empty: every queue runs its default scenario set (see default_scenarios()).
+        std::vector<Scenario> scenarios;
+        // Empty: standard and latency scenarios run at standard_capacities, the rest at default_capacity.
+        std::vector<std::size_t> capacities;
+        std::vector<std::size_t> batch_sizes{8, 64, 512};
+        std::vector<std::size_t> producer_counts{1, 2, 4, 8, 16};
+        // Threads in the chain of the pipeline scenario, source and sink included.
+        std::vector<std::size_t> stage_counts{2, 4, 6};
+        // Reader threads of the fan-out scenario.
+        std::vector<std::size_t> reader_counts{1, 3, 5};
+        std::size_t payload_size = 64;
+        std::size_t producer_cycles = 128;
+        std::size_t consumer_cycles = 128;
+        // Raw perf event code counted as HITM, see ThreadProbe.
+        std::optional<std::uint64_t> hitm_event;
+        OutputFormat format = OutputFormat::table;
+        // Empty: results go to stdout.
+        std::string output;
+    };
+
+    BenchConfig config;
+
+    // Payload of the big-payload scenario, Bytes in size. Only seq is checked by the consumer.
+    template <std::size_t Bytes>
+    struct SizedPayload
+    {
+        static_assert(Bytes >= sizeof(std::uint64_t) && Bytes % sizeof(std::uint64_t) == 0);
+
+        std::uint64_t seq = 0;
+        std::array<std::uint64_t, Bytes / sizeof(std::uint64_t) - 1> data{};
+    };
+
+    // Payload of the fan-in scenario: which producer sent it and its position in that producer's stream.
+    struct FanInPayload
+    {
+        std::uint64_t producer = 0;
+        std::uint64_t seq = 0;
     };
 
-    struct BigPayload
+    // Payload stamped by the producer right before push().
+    struct LatencyPayload
     {
         std::uint64_t seq = 0;
-        std::uint64_t a = 1;
-        std::uint64_t b = 2;
-        std::uint64_t c = 3;
-        std::uint64_t d = 4;
-        std::uint64_t e = 5;
-        std::uint64_t f = 6;
-        std::uint64_t g = 7;
+        std::int64_t stamp_ns = 0;
     };
 
     struct BenchCase
     {
         Scenario scenario = Scenario::blocking_standard;
         std::size_t capacity = default_capacity;
+        std::size_t batch = 1;
+        std::size_t producers = 1;
+        // Threads from the first push to the last pop; more than 2 only in the pipeline scenario.
+        std::size_t stages = 2;
+        // Threads that each read every item; more than 1 only in the fan-out scenario.
+        std::size_t readers = 1;
+        // Payload size in bytes of the bulk-copy scenario; the other scenarios imply theirs.
+        std::size_t payload = 0;
+    };
+
+    // One run: wall time plus what each thread's ThreadProbe measured. With several producers
+    // (fan-in), producer holds the sum over all producer threads; with several readers (fan-out),
+    // consumer holds the sum over all reader threads.
+    struct RunResult
+    {
+        double elapsed_ms = 0.0;
+        ThreadCounters producer{};
+        ThreadCounters consumer{};
     };
 
     struct Aggregate
     {
         QueueKind queue = QueueKind::simple;
         BenchCase bench_case{};
+        std::size_t items = 0;
+        std::size_t payload_bytes = 0;
         double avg_elapsed_ms = 0.0;
         double stdev_elapsed_ms = 0.0;
+        // Averages per run.
+        double producer_cpu_ms = 0.0;
+        double consumer_cpu_ms = 0.0;
+        double context_switches = 0.0;
+        // Averages per run, summed over both threads; nullopt if the counter was unavailable.
+        std::optional<double> cycles;
+        std::optional<double> instructions;
+        std::optional<double> cache_misses;
+        std::optional<double> hitm;
+    };
+
+    struct LatencyAggregate
+    {
+        QueueKind queue = QueueKind::simple;
+        Scenario scenario = Scenario::latency;
+        std::size_t capacity = default_capacity;
+        // Items per run.
+        std::size_t items = 0;
+        std::uint64_t samples = 0;
+        std::uint64_t p50_ns = 0;
+        std::uint64_t p90_ns = 0;
+        std::uint64_t p99_ns = 0;
+        std::uint64_t p999_ns = 0;
+        std::uint64_t max_ns = 0;
+    };
+
+    struct Results
+    {
+        std::vector<Aggregate> throughput;
+        std::vector<LatencyAggregate> latency;
     };
 
+    double ns_per_item(const Aggregate &r)
+    {
+        return r.avg_elapsed_ms * 1e6 / static_cast<double>(r.items);
+    }
+
+    // Millions of items per second.
+    double mops(const Aggregate &r)
+    {
+        return static_cast<double>(r.items) / (r.avg_elapsed_ms * 1e3);
+    }
+
+    // Payload bytes moved through the queue per second, in 10^9 bytes.
+    double gbps(const Aggregate &r)
+    {
+        return static_cast<double>(r.items * r.payload_bytes) / (r.avg_elapsed_ms * 1e6);
+    }
+
+    // CPU time of all threads over wall time: 2.0 means two threads' worth of cores were busy all the time.
+    double cpu_utilization(const Aggregate &r)
+    {
+        return (r.producer_cpu_ms + r.consumer_cpu_ms) / r.avg_elapsed_ms;
+    }
+
+    std::optional<double> per_item(const Aggregate &r, std::optional<double> total)
+    {
+        if (!total.has_value())
+        {
+            return std::nullopt;
+        }
+        return *total / static_cast<double>(r.items);
+    }
+
+    // Mean over runs of a counter summed over both threads; nullopt if any thread lacked it.
+    std::optional<double> mean_counter(const std::vector<RunResult> &runs, std::optional<std::uint64_t> ThreadCounters::*counter)
+    {
+        double total = 0.0;
+        for (const RunResult &run : runs)
+        {
+            if (!(run.producer.*counter).has_value() || !(run.consumer.*counter).has_value())
+            {
+                return std::nullopt;
+            }
+            total += static_cast<double>(*(run.producer.*counter) + *(run.consumer.*counter));
+        }
+        return total / static_cast<double>(runs.size());
+    }
+
+    // Renders an optional value for JSON ("null") or CSV (empty).
+    std::string format_optional(std::optional<double> v, const char *missing)
+    {
+        return v.has_value() ? std::format("{}", *v) : std::string(missing);
+    }
+
+    // Sums the counters of several threads. A hardware counter is nullopt if any thread lacked it.
+    ThreadCounters sum_counters(const std::vector<ThreadCounters> &threads)
+    {
+        ThreadCounters out;
+        const auto add = [](std::optional<std::uint64_t> &into, std::optional<std::uint64_t> v, bool first)
+        {
+            if (first || into.has_value())
+            {
+                into = v.has_value() ? std::optional<std::uint64_t>(into.value_or(0) + *v) : std::nullopt;
+            }
+        };
+
+        for (std::size_t i = 0; i < threads.size(); ++i)
+        {
+            const ThreadCounters &t = threads[i];
+            out.cpu_ms += t.cpu_ms;
+            out.context_switches += t.context_switches;
+            add(out.cycles, t.cycles, i == 0);
+            add(out.instructions, t.instructions, i == 0);
+            add(out.cache_misses, t.cache_misses, i == 0);
+            add(out.hitm, t.hitm, i == 0);
+        }
+        return out;
+    }
+
+    std::int64_t now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
     void busy_cycles(std::size_t cycles)
     {
         for (std::size_t i = 0; i < cycles; ++i)
@@ -86,13 +464,58 @@ namespace
             return "simple";
         case QueueKind::atomic:
             return "atomic";
+        case QueueKind::atomic_pow2:
+            return "atomic-pow2";
+        case QueueKind::atomic_busy_spin:
+            return "atomic-spin";
+        case QueueKind::atomic_backoff:
+            return "atomic-backoff";
+        case QueueKind::atomic_yield:
+            return "atomic-yield";
+        case QueueKind::atomic_sleep:
+            return "atomic-sleep";
+        case QueueKind::atomic_park:
+            return "atomic-park";
+        case QueueKind::atomic_condvar:
+            return "atomic-condvar";
+        case QueueKind::atomic_huge:
+            return "atomic-huge";
+        case QueueKind::atomic_stream:
+            return "atomic-stream";
+        case QueueKind::atomic_lazy_4:
+            return "atomic-lazy4";
+        case QueueKind::atomic_lazy_16:
+            return "atomic-lazy16";
+        case QueueKind::atomic_lazy_64:
+            return "atomic-lazy64";
+        case QueueKind::slot:
+            return "slot";
+        case QueueKind::slot_packed:
+            return "slot-packed";
+        case QueueKind::unbounded:
+            return "unbounded";
+        case QueueKind::mpsc:
+            return "mpsc";
+        case QueueKind::mpmc:
+            return "mpmc";
+        case QueueKind::broadcast:
+            return "broadcast";
         }
         return "unknown";
     }
 
     const char *to_string(Mode v)
     {
-        return v == Mode::blocking ? "blocking" : "nonblocking";
+        switch (v)
+        {
+        case Mode::blocking:
+            return "blocking";
+        case Mode::nonblocking:
+            return "nonblocking";
+        case Mode::batched:
+            return "batched";
+        }
+        return "unknown";
     }
 
     const char *to_string(Scenario v)
@@ -109,32 +532,265 @@ namespace
             return "producer-heavy";
         case Scenario::consumer_heavy:
             return "consumer-heavy";
+        case Scenario::batched:
+            return "batched";
+        case Scenario::latency:
+            return "latency";
+        case Scenario::fan_in:
+            return "fan-in";
+        case Scenario::vector_payload:
+            return "vector-payload";
+        case Scenario::pooled_payload:
+            return "pooled-payload";
+        case Scenario::first_lap:
+            return "first-lap";
+        case Scenario::bulk_copy:
+            return "bulk-copy";
+        case Scenario::pipeline:
+            return "pipeline";
+        case Scenario::ping_pong:
+            return "ping-pong";
+        case Scenario::fan_out:
+            return "fan-out";
+        }
+        return "unknown";
+    }
+
+    // Name accepted by --scenario. Unlike to_string() it tells the two standard scenarios apart.
+    const char *option_name(Scenario v)
+    {
+        switch (v)
+        {
+        case Scenario::blocking_standard:
+            return "blocking";
+        case Scenario::nonblocking_standard:
+            return "nonblocking";
+        default:
+            return to_string(v);
+        }
+    }
+
+    const char *to_string(PinPreset v)
+    {
+        switch (v)
+        {
+        case PinPreset::none:
+            return "none";
+        case PinPreset::same_core:
+            return "same-core";
+        case PinPreset::same_socket:
+            return "same-socket";
+        case PinPreset::cross_socket:
+            return "cross-socket";
         }
         return "unknown";
     }
 
     Mode mode_for(Scenario s)
     {
-        return s == Scenario::nonblocking_standard ? Mode::nonblocking : Mode::blocking;
+        switch (s)
+        {
+        case Scenario::nonblocking_standard:
+            return Mode::nonblocking;
+        case Scenario::batched:
+        case Scenario::bulk_copy:
+            return Mode::batched;
+        default:
+            return Mode::blocking;
+        }
+    }
+
+    std::size_t payload_bytes(const BenchCase &bc)
+    {
+        switch (bc.scenario)
+        {
+        case Scenario::bulk_copy:
+            return bc.payload;
+        case Scenario::big_payload:
+        case Scenario::vector_payload:
+        case Scenario::pooled_payload:
+            return config.payload_size;
+        case Scenario::latency:
+        case Scenario::first_lap:
+        case Scenario::ping_pong:
+            return sizeof(LatencyPayload);
+        case Scenario::fan_in:
+            return sizeof(FanInPayload);
+        default:
+            return sizeof(int);
+        }
+    }
+
+    // Scenarios a queue runs when --scenario is not given.
+    std::vector<Scenario> default_scenarios(QueueKind kind)
+    {
+        switch (kind)
+        {
+        case QueueKind::simple:
+        case QueueKind::atomic:
+            return {all_scenarios.begin(), all_scenarios.end()};
+        case QueueKind::atomic_pow2:
+            // Power-of-two indexing only changes the slot math, so compare it on the standard rows only.
+            return {Scenario::blocking_standard, Scenario::nonblocking_standard};
+        case QueueKind::atomic_park:
+        case QueueKind::atomic_condvar:
+            return {Scenario::blocking_standard, Scenario::producer_heavy, Scenario::consumer_heavy, Scenario::latency};
+        case QueueKind::atomic_huge:
+            // Huge pages only pay off on large rings; first-lap compares them with the plain atomic ring.
+            return {Scenario::first_lap};
+        case QueueKind::atomic_stream:
+            // Non-temporal stores only change bulk pushes of trivially copyable items.
+            return {Scenario::bulk_copy};
+        case QueueKind::atomic_lazy_4:
+        case QueueKind::atomic_lazy_16:
+        case QueueKind::atomic_lazy_64:
+            // Throughput against the atomic row (K = 1) for single-item calls; batched calls and
+            // latency are not what lazy publication is for.
+            return {Scenario::blocking_standard, Scenario::nonblocking_standard};
+        case QueueKind::slot:
+        case QueueKind::slot_packed:
+            // Same surface as atomic; compare throughput and hand-off latency on the standard rows.
+            return {Scenario::blocking_standard, Scenario::nonblocking_standard, Scenario::latency};
+        case QueueKind::unbounded:
+            // The producer never waits, so only the consumer side and segment turnover show up.
+            return {Scenario::blocking_standard, Scenario::nonblocking_standard};
+        case QueueKind::mpsc:
+        case QueueKind::mpmc:
+            // Standard rows show the cost of the CAS and slot sequences with one producer;
+            // fan-in shows where sharing one queue overtakes one SPSC queue per producer.
+            return {Scenario::blocking_standard, Scenario::nonblocking_standard, Scenario::fan_in};
+        case QueueKind::broadcast:
+            // Readers replace pop(), so the broadcast ring only runs fan-out.
+            return {Scenario::fan_out};
+        default:
+            // Wait policies only affect blocking operations, so compare them on the blocking rows only.
+            return {Scenario::blocking_standard, Scenario::producer_heavy, Scenario::consumer_heavy};
+        }
     }
 
-    std::vector<BenchCase> make_cases()
+    std::vector<BenchCase> make_cases(QueueKind kind)
     {
+        const std::vector<Scenario> scenarios = config.scenarios.empty() ? default_scenarios(kind) : config.scenarios;
         std::vector<BenchCase> out;
 
-        for (std::size_t cap : standard_capacities)
+        for (Scenario s : scenarios)
         {
-            out.push_back(BenchCase{Scenario::blocking_standard, cap});
-            out.push_back(BenchCase{Scenario::nonblocking_standard, cap});
-        }
+            if (kind == QueueKind::broadcast && s != Scenario::fan_out)
+            {
+                continue;
+            }
+
+            std::vector<std::size_t> capacities = config.capacities;
+            if (capacities.empty())
+            {
+                const bool standard = s == Scenario::blocking_standard || s == Scenario::nonblocking_standard ||
+                                      s == Scenario::latency || s == Scenario::ping_pong;
+                if (standard)
+                {
+                    capacities.assign(standard_capacities.begin(), standard_capacities.end());
+                }
+                else
+                {
+                    capacities = {s == Scenario::first_lap ? large_capacity : default_capacity};
+                }
+            }
 
-        out.push_back(BenchCase{Scenario::big_payload, default_capacity});
-        out.push_back(BenchCase{Scenario::producer_heavy, default_capacity});
-        out.push_back(BenchCase{Scenario::consumer_heavy, default_capacity});
+            for (std::size_t cap : capacities)
+            {
+                if (s == Scenario::batched)
+                {
+                    for (std::size_t batch : config.batch_sizes)
+                    {
+                        out.push_back(BenchCase{s, cap, batch});
+                    }
+                }
+                else if (s == Scenario::bulk_copy)
+                {
+                    for (std::size_t bytes : bulk_copy_payload_sizes)
+                    {
+                        out.push_back(BenchCase{.scenario = s, .capacity = cap, .batch = bulk_copy_batch, .payload = bytes});
+                    }
+                }
+                else if (s == Scenario::pipeline)
+                {
+                    for (std::size_t stages : config.stage_counts)
+                    {
+                        out.push_back(BenchCase{.scenario = s, .capacity = cap, .stages = stages});
+                    }
+                }
+                else if (s == Scenario::fan_out)
+                {
+                    for (std::size_t readers : config.reader_counts)
+                    {
+                        out.push_back(BenchCase{.scenario = s, .capacity = cap, .readers = readers});
+                    }
+                }
+                else if (s == Scenario::fan_in)
+                {
+                    for (std::size_t producers : config.producer_counts)
+                    {
+                        out.push_back(BenchCase{s, cap, 1, producers});
+                    }
+                }
+                else
+                {
+                    out.push_back(BenchCase{s, cap});
+                }
+            }
+        }
 
         return out;
     }
 
+    // Constructs the queue under test. Rings of mmap_allocator queues are bound to --numa-node,
+    // or, with --first-touch consumer, prefaulted by a helper thread pinned to the consumer CPU
+    // so the kernel places the pages on the consumer's node. atomic-huge rings are always
+    // prefaulted and ask for 2MB pages.
+    template <typename Queue>
+    std::unique_ptr<Queue> make_queue(std::size_t capacity)
+    {
+        if constexpr (mmap_backed<Queue>)
+        {
+            using Allocator = typename Queue::allocator_type;
+
+            mmap_options options{placement.numa_node, placement.consumer_first_touch};
+            if constexpr (std::is_same_v<Allocator, huge_page_allocator<typename Queue::value_type>>)
+            {
+                options.prefault = true;
+                options.huge_pages = mmap_huge_pages::huge_2mb;
+            }
+            const auto construct = [&]
+            { return std::make_unique<Queue>(capacity, Allocator(options)); };
+
+            if (placement.consumer_first_touch)
+            {
+                std::unique_ptr<Queue> q;
+                std::jthread([&]
+                             {
+                    pin_current_thread(placement.cpus.consumer);
+                    q = construct(); })
+                    .join();
+                return q;
+            }
+            return construct();
+        }
+        else
+        {
+            return std::make_unique<Queue>(capacity);
+        }
+    }
+
+    // Makes pushed items visible now. Lazy-publish queues otherwise hold them back until a whole
+    // batch is pending, which never happens when the producer waits for a reply to each item.
+    template <typename Queue>
+    void publish_pushes(Queue &q)
+    {
+        if constexpr (requires { q.flush(); })
+        {
+            q.flush();
+        }
+    }
+
     template <typename Payload>
     Payload make_payload(std::size_t seq)
     {
@@ -164,16 +820,20 @@ namespace
     }
 
     template <typename Queue, typename Payload>
-    double run_benchmark(std::size_t capacity, Mode mode, std::size_t producer_cycles, std::size_t consumer_cycles, std::size_t items)
+    RunResult run_benchmark(std::size_t capacity, Mode mode, std::size_t producer_cycles, std::size_t consumer_cycles, std::size_t items, std::size_t batch = 1)
     {
-        Queue q(capacity);
+        const auto queue = make_queue<Queue>(capacity);
+        Queue &q = *queue;
         std::size_t consumed = 0;
+        RunResult result;
 
         const auto start = std::chrono::steady_clock::now();
 
         if (mode == Mode::blocking)
         {
             std::jthread producer ([&]{
+                pin_current_thread(placement.cpus.producer);
+                ThreadProbe probe(config.hitm_event);
                 for (std::size_t i = 0; i < items; ++i)
                 {
                     busy_cycles(producer_cycles);
@@ -181,9 +841,12 @@ namespace
                     assert(pushed);
                 }
                 q.close();
+                result.producer = probe.stop();
             });
-            
+
             std::jthread consumer([&]{
+                pin_current_thread(placement.cpus.consumer);
+                ThreadProbe probe(config.hitm_event);
                 std::uint64_t expected = 0;
                 while (true)
                 {
@@ -198,18 +861,65 @@ namespace
                     ++expected;
                     ++consumed;
                 }
+                result.consumer = probe.stop();
+            });
+        } else if (mode == Mode::batched) {
+            std::jthread producer ([&]{
+                pin_current_thread(placement.cpus.producer);
+                ThreadProbe probe(config.hitm_event);
+                std::vector<Payload> chunk(batch);
+                for (std::size_t i = 0; i < items; i += batch)
+                {
+                    const std::size_t n = std::min(batch, items - i);
+                    for (std::size_t j = 0; j < n; ++j)
+                    {
+                        chunk[j] = make_payload<Payload>(i + j);
+                    }
+                    const std::size_t pushed = q.push_n(chunk.begin(), chunk.begin() + n);
+                    assert(pushed == n);
+                }
+                q.close();
+                result.producer = probe.stop();
+            });
+
+            std::jthread consumer([&]{
+                pin_current_thread(placement.cpus.consumer);
+                ThreadProbe probe(config.hitm_event);
+                std::vector<Payload> chunk(batch);
+                std::uint64_t expected = 0;
+                while (true)
+                {
+                    const std::size_t n = q.pop_n(chunk.begin(), batch);
+                    if (n == 0)
+                    {
+                        break;
+                    }
+
+                    for (std::size_t j = 0; j < n; ++j)
+                    {
+                        assert (payload_seq<Payload>(chunk[j]) == expected);
+                        ++expected;
+                        ++consumed;
+                    }
+                }
+                result.consumer = probe.stop();
             });
         } else {
             std::jthread producer ([&]{
+                pin_current_thread(placement.cpus.producer);
+                ThreadProbe probe(config.hitm_event);
                 for (std::size_t i = 0; i < items; ++i)
                 {
                     busy_cycles(producer_cycles);
                     while (!q.try_push(make_payload<Payload>(i))) {}
                 }
                 q.close();
+                result.producer = probe.stop();
             });
-            
+
             std::jthread consumer([&]{
+                pin_current_thread(placement.cpus.consumer);
+                ThreadProbe probe(config.hitm_event);
                 std::uint64_t expected = 0;
                 while (true)
                 {
@@ -228,6 +938,7 @@ namespace
                     ++expected;
                     ++consumed;
                 }
+                result.consumer = probe.stop();
             });
         }
 
@@ -235,102 +946,1270 @@ namespace
 
         const auto end = std::chrono::steady_clock::now();
 
-        return std::chrono::duration<double, std::milli>(end - start).count();
+        result.elapsed_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        return result;
     }
 
-    template <template <class> class QueueTemplate>
-    double run_case(const BenchCase &bc, std::size_t items)
+    // Fan-in: producers threads push items between them, one consumer pops them all. Queues that
+    // accept several producers are shared; any other queue is instantiated once per producer and
+    // the consumer polls the instances round-robin with try_pop(). Only the consumer is pinned,
+    // since the producers outnumber the CPUs of a placement pair.
+    template <typename Queue>
+    RunResult run_fan_in_benchmark(std::size_t capacity, std::size_t producers, std::size_t items)
     {
-        switch (bc.scenario)
-        {
-        case Scenario::blocking_standard:
-            return run_benchmark<QueueTemplate<int>, int>(bc.capacity, Mode::blocking, 0, 0, items);
-        case Scenario::nonblocking_standard:
-            return run_benchmark<QueueTemplate<int>, int>(bc.capacity, Mode::nonblocking, 0, 0, items);
-        case Scenario::big_payload:
-            return run_benchmark<QueueTemplate<BigPayload>, BigPayload>(bc.capacity, Mode::blocking, 0, 0, items);
-        case Scenario::producer_heavy:
-            return run_benchmark<QueueTemplate<int>, int>(bc.capacity, Mode::blocking, heavy_cycles, 0, items);
-        case Scenario::consumer_heavy:
-            return run_benchmark<QueueTemplate<int>, int>(bc.capacity, Mode::blocking, 0, heavy_cycles, items);
-        }
-        std::abort();
-    }
+        constexpr bool shared = multi_producer<Queue>;
 
-    template <template <class> class QueueTemplate>
-    void run_for_queue(QueueKind queue, const std::vector<BenchCase> &cases, std::vector<Aggregate> &aggregates)
-    {
-        for (const BenchCase &bc : cases)
+        std::vector<std::unique_ptr<Queue>> queues;
+        for (std::size_t i = 0; i < (shared ? 1 : producers); ++i)
         {
-            std::cout << std::format("[{}] Running {} {} cap={}\n",
-                                     to_string(queue),
-                                     to_string(mode_for(bc.scenario)),
-                                     to_string(bc.scenario),
-                                     bc.capacity);
-
-            std::vector<double> runs;
-            runs.reserve(repeat_count);
-            for (std::size_t i = 0; i < repeat_count; ++i)
-            {
-                runs.push_back(run_case<QueueTemplate>(bc, item_count));
-            }
-
-            Aggregate out;
-            out.queue = queue;
-            out.bench_case = bc;
-
-            std::vector<double> elapsed;
-            elapsed.reserve(runs.size());
-
-            for (const auto r : runs)
-            {
-                out.avg_elapsed_ms += r;
-                elapsed.push_back(r);
-            }
+            queues.push_back(make_queue<Queue>(capacity));
+        }
 
-            out.avg_elapsed_ms /= static_cast<double>(runs.size());
+        std::vector<ThreadCounters> producer_counters(producers);
+        std::atomic<std::size_t> running = producers;
+        std::size_t consumed = 0;
+        RunResult result;
 
-            double elapsed_var = 0.0;
-            for (double v : elapsed)
+        const auto start = std::chrono::steady_clock::now();
+        {
+            std::vector<std::jthread> threads;
+            for (std::size_t p = 0; p < producers; ++p)
             {
-                const double d = v - out.avg_elapsed_ms;
-                elapsed_var += d * d;
+                threads.emplace_back([&, p]{
+                    ThreadProbe probe(config.hitm_event);
+                    Queue &q = *queues[shared ? 0 : p];
+                    const std::size_t count = items / producers + (p < items % producers ? 1 : 0);
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        const bool pushed = q.push(FanInPayload{p, i});
+                        assert(pushed);
+                    }
+                    // A shared queue is closed by the last producer to finish.
+                    if (!shared || running.fetch_sub(1) == 1)
+                    {
+                        q.close();
+                    }
+                    producer_counters[p] = probe.stop();
+                });
             }
-            out.stdev_elapsed_ms = std::sqrt(elapsed_var / static_cast<double>(elapsed.size()));
 
-            aggregates.push_back(out);
-        }
-    }
+            threads.emplace_back([&]{
+                pin_current_thread(placement.cpus.consumer);
+                ThreadProbe probe(config.hitm_event);
+                std::vector<std::uint64_t> expected(producers, 0);
+                const auto check = [&](const FanInPayload &v)
+                {
+                    assert(v.seq == expected[v.producer]);
+                    ++expected[v.producer];
+                    ++consumed;
+                };
 
-    void print_table(const std::vector<Aggregate> &rows)
+                if constexpr (shared)
+                {
+                    for (auto value = queues.front()->pop(); value.has_value(); value = queues.front()->pop())
+                    {
+                        check(*value);
+                    }
+                }
+                else
+                {
+                    // A pass that finds nothing backs off like a blocked pop() with the default policy.
+                    spin_yield_wait wait;
+                    std::size_t spin = 0;
+                    for (bool open = true; open;)
+                    {
+                        open = false;
+                        bool found = false;
+                        for (const auto &q : queues)
+                        {
+                            if (q->done())
+                            {
+                                continue;
+                            }
+                            open = true;
+                            if (auto value = q->try_pop(); value.has_value())
+                            {
+                                check(*value);
+                                found = true;
+                            }
+                        }
+                        if (found)
+                        {
+                            spin = 0;
+                        }
+                        else if (open)
+                        {
+                            wait.wait_for_items(spin, [] { return true; }, no_deadline);
+                        }
+                    }
+                }
+                result.consumer = probe.stop();
+            });
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        assert(consumed == items);
+        result.producer = sum_counters(producer_counters);
+        result.elapsed_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        return result;
+    }
+
+    // Pipeline: stages threads chained by stages - 1 queues. The source pushes the items, every
+    // middle stage pops them from its upstream queue and pushes them to its downstream queue, and
+    // the sink checks them; a middle stage closes downstream once upstream is done. Elapsed time
+    // runs from the first push to the last pop, so it shows the throughput of the whole chain.
+    // The source is pinned like a producer and the sink like a consumer; middle stages are not
+    // pinned. producer holds the source's counters, consumer the sum over all other stages.
+    template <typename Queue>
+    RunResult run_pipeline_benchmark(std::size_t capacity, std::size_t stages, std::size_t items)
+    {
+        std::vector<std::unique_ptr<Queue>> queues;
+        for (std::size_t i = 0; i + 1 < stages; ++i)
+        {
+            queues.push_back(make_queue<Queue>(capacity));
+        }
+
+        std::vector<ThreadCounters> stage_counters(stages);
+        std::size_t consumed = 0;
+        RunResult result;
+
+        const auto start = std::chrono::steady_clock::now();
+        {
+            std::vector<std::jthread> threads;
+            threads.emplace_back([&]{
+                pin_current_thread(placement.cpus.producer);
+                ThreadProbe probe(config.hitm_event);
+                Queue &out = *queues.front();
+                for (std::size_t i = 0; i < items; ++i)
+                {
+                    const bool pushed = out.push(static_cast<int>(i));
+                    assert(pushed);
+                }
+                out.close();
+                stage_counters.front() = probe.stop();
+            });
+
+            for (std::size_t stage = 1; stage + 1 < stages; ++stage)
+            {
+                threads.emplace_back([&, stage]{
+                    ThreadProbe probe(config.hitm_event);
+                    Queue &in = *queues[stage - 1];
+                    Queue &out = *queues[stage];
+                    for (auto value = in.pop(); value.has_value(); value = in.pop())
+                    {
+                        const bool pushed = out.push(*value);
+                        assert(pushed);
+                    }
+                    out.close();
+                    stage_counters[stage] = probe.stop();
+                });
+            }
+
+            threads.emplace_back([&]{
+                pin_current_thread(placement.cpus.consumer);
+                ThreadProbe probe(config.hitm_event);
+                Queue &in = *queues.back();
+                std::uint64_t expected = 0;
+                for (auto value = in.pop(); value.has_value(); value = in.pop())
+                {
+                    assert(static_cast<std::uint64_t>(*value) == expected);
+                    ++expected;
+                    ++consumed;
+                }
+                stage_counters.back() = probe.stop();
+            });
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        assert(consumed == items);
+        result.producer = stage_counters.front();
+        result.consumer = sum_counters({stage_counters.begin() + 1, stage_counters.end()});
+        result.elapsed_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        return result;
+    }
+
+    // Fan-out: one producer hands every item to readers threads, each of which checks all of them.
+    // A broadcast ring is written once and read by every reader; any other queue is instantiated
+    // once per reader and the producer pushes a copy of every item to each instance in turn. Only
+    // the producer is pinned, since the readers outnumber the CPUs of a placement pair.
+    template <typename Queue>
+    RunResult run_fan_out_benchmark(std::size_t capacity, std::size_t readers, std::size_t items)
     {
-        std::cout << std::format("{:<8}{:<15}{:<15}{:<15}{:<15}{:<15}\n",
-                                 "queue", "mode", "scenario", "cap",
-                                 "avg ms", "stdev ms");
+        constexpr bool shared = broadcasting<Queue>;
+
+        std::vector<std::unique_ptr<Queue>> queues;
+        if constexpr (shared)
+        {
+            queues.push_back(std::make_unique<Queue>(capacity, readers));
+        }
+        else
+        {
+            for (std::size_t i = 0; i < readers; ++i)
+            {
+                queues.push_back(make_queue<Queue>(capacity));
+            }
+        }
+
+        std::vector<ThreadCounters> reader_counters(readers);
+        std::vector<std::size_t> consumed(readers, 0);
+        RunResult result;
+
+        const auto start = std::chrono::steady_clock::now();
+        {
+            std::vector<std::jthread> threads;
+            threads.emplace_back([&]{
+                pin_current_thread(placement.cpus.producer);
+                ThreadProbe probe(config.hitm_event);
+                for (std::size_t i = 0; i < items; ++i)
+                {
+                    for (const auto &q : queues)
+                    {
+                        const bool pushed = q->push(static_cast<int>(i));
+                        assert(pushed);
+                    }
+                }
+                for (const auto &q : queues)
+                {
+                    q->close();
+                }
+                result.producer = probe.stop();
+            });
+
+            for (std::size_t r = 0; r < readers; ++r)
+            {
+                threads.emplace_back([&, r]{
+                    ThreadProbe probe(config.hitm_event);
+                    std::uint64_t expected = 0;
+                    const auto drain = [&](auto &in)
+                    {
+                        for (auto value = in.pop(); value.has_value(); value = in.pop())
+                        {
+                            assert(static_cast<std::uint64_t>(*value) == expected);
+                            ++expected;
+                        }
+                    };
+
+                    if constexpr (shared)
+                    {
+                        auto reader = queues.front()->get_reader(r);
+                        drain(reader);
+                    }
+                    else
+                    {
+                        drain(*queues[r]);
+                    }
+                    consumed[r] = expected;
+                    reader_counters[r] = probe.stop();
+                });
+            }
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        assert(std::ranges::all_of(consumed, [&](std::size_t n)
+                                   { return n == items; }));
+        result.consumer = sum_counters(reader_counters);
+        result.elapsed_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        return result;
+    }
+
+    // Heap payloads: std::vector<int> of config.payload_size bytes, first element = seq. Without
+    // the pool, the producer allocates every item and the consumer frees it. With it, the queue
+    // carries message_pool handles and the buffers cycle back to the producer through the
+    // pool's reverse queue, so neither thread touches the allocator while running.
+    template <template <class> class QueueTemplate, bool Pooled>
+    RunResult run_vector_payload_benchmark(std::size_t capacity, std::size_t items)
+    {
+        using Pool = message_pool<std::vector<int>>;
+        using Queue = QueueTemplate<std::conditional_t<Pooled, Pool::handle, std::vector<int>>>;
+
+        const std::size_t length = config.payload_size / sizeof(int);
+        const auto queue = make_queue<Queue>(capacity);
+        Queue &q = *queue;
+        // In flight: capacity items in the queue plus one buffer held by each side.
+        std::unique_ptr<Pool> pool;
+        if constexpr (Pooled)
+        {
+            pool = std::make_unique<Pool>(capacity + 2, [&]
+                                          { return std::vector<int>(length); });
+        }
+        std::size_t consumed = 0;
+        RunResult result;
+
+        const auto start = std::chrono::steady_clock::now();
+        {
+            std::jthread producer([&]{
+                pin_current_thread(placement.cpus.producer);
+                ThreadProbe probe(config.hitm_event);
+                for (std::size_t i = 0; i < items; ++i)
+                {
+                    if constexpr (Pooled)
+                    {
+                        const std::optional<Pool::handle> h = pool->acquire();
+                        assert(h.has_value());
+                        (*pool)[*h][0] = static_cast<int>(i);
+                        const bool pushed = q.push(*h);
+                        assert(pushed);
+                    }
+                    else
+                    {
+                        std::vector<int> v(length);
+                        v[0] = static_cast<int>(i);
+                        const bool pushed = q.push(std::move(v));
+                        assert(pushed);
+                    }
+                }
+                q.close();
+                result.producer = probe.stop();
+            });
+
+            std::jthread consumer([&]{
+                pin_current_thread(placement.cpus.consumer);
+                ThreadProbe probe(config.hitm_event);
+                std::uint64_t expected = 0;
+                for (auto value = q.pop(); value.has_value(); value = q.pop())
+                {
+                    if constexpr (Pooled)
+                    {
+                        assert(static_cast<std::uint64_t>((*pool)[*value][0]) == expected);
+                        pool->release(*value);
+                    }
+                    else
+                    {
+                        assert(static_cast<std::uint64_t>((*value)[0]) == expected);
+                    }
+                    ++expected;
+                    ++consumed;
+                }
+                result.consumer = probe.stop();
+            });
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        assert(consumed == items);
+        result.elapsed_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        return result;
+    }
+
+    template <template <class> class QueueTemplate, std::size_t Bytes>
+    RunResult run_sized_payload(std::size_t capacity, std::size_t items, Mode mode = Mode::blocking, std::size_t batch = 1)
+    {
+        return run_benchmark<QueueTemplate<SizedPayload<Bytes>>, SizedPayload<Bytes>>(capacity, mode, 0, 0, items, batch);
+    }
+
+    // config.payload_size is one of payload_sizes, checked when parsing the command line.
+    template <template <class> class QueueTemplate>
+    RunResult run_big_payload(std::size_t capacity, std::size_t items)
+    {
+        switch (config.payload_size)
+        {
+        case 16:
+            return run_sized_payload<QueueTemplate, 16>(capacity, items);
+        case 32:
+            return run_sized_payload<QueueTemplate, 32>(capacity, items);
+        case 64:
+            return run_sized_payload<QueueTemplate, 64>(capacity, items);
+        case 128:
+            return run_sized_payload<QueueTemplate, 128>(capacity, items);
+        case 256:
+            return run_sized_payload<QueueTemplate, 256>(capacity, items);
+        case 512:
+            return run_sized_payload<QueueTemplate, 512>(capacity, items);
+        case 1024:
+            return run_sized_payload<QueueTemplate, 1024>(capacity, items);
+        }
+        std::abort();
+    }
+
+    // Batched push_n()/pop_n() of trivially copyable payloads between contiguous chunks, which
+    // the atomic queues copy with memcpy per ring run. bc.payload is one of bulk_copy_payload_sizes.
+    template <template <class> class QueueTemplate>
+    RunResult run_bulk_copy(const BenchCase &bc, std::size_t items)
+    {
+        switch (bc.payload)
+        {
+        case 64:
+            return run_sized_payload<QueueTemplate, 64>(bc.capacity, items, Mode::batched, bc.batch);
+        case 256:
+            return run_sized_payload<QueueTemplate, 256>(bc.capacity, items, Mode::batched, bc.batch);
+        case 1024:
+            return run_sized_payload<QueueTemplate, 1024>(bc.capacity, items, Mode::batched, bc.batch);
+        }
+        std::abort();
+    }
+
+    template <template <class> class QueueTemplate>
+    RunResult run_case(const BenchCase &bc, std::size_t items)
+    {
+        // Broadcast rings have readers instead of pop(); make_cases() gives them fan-out only.
+        if constexpr (broadcasting<QueueTemplate<int>>)
+        {
+            assert(bc.scenario == Scenario::fan_out);
+            return run_fan_out_benchmark<QueueTemplate<int>>(bc.capacity, bc.readers, items);
+        }
+        else
+        {
+            switch (bc.scenario)
+            {
+            case Scenario::blocking_standard:
+                return run_benchmark<QueueTemplate<int>, int>(bc.capacity, Mode::blocking, 0, 0, items);
+            case Scenario::nonblocking_standard:
+                return run_benchmark<QueueTemplate<int>, int>(bc.capacity, Mode::nonblocking, 0, 0, items);
+            case Scenario::big_payload:
+                return run_big_payload<QueueTemplate>(bc.capacity, items);
+            case Scenario::producer_heavy:
+                return run_benchmark<QueueTemplate<int>, int>(bc.capacity, Mode::blocking, config.producer_cycles, 0, items);
+            case Scenario::consumer_heavy:
+                return run_benchmark<QueueTemplate<int>, int>(bc.capacity, Mode::blocking, 0, config.consumer_cycles, items);
+            case Scenario::batched:
+                return run_benchmark<QueueTemplate<int>, int>(bc.capacity, Mode::batched, 0, 0, items, bc.batch);
+            case Scenario::fan_in:
+                return run_fan_in_benchmark<QueueTemplate<FanInPayload>>(bc.capacity, bc.producers, items);
+            case Scenario::vector_payload:
+                return run_vector_payload_benchmark<QueueTemplate, false>(bc.capacity, items);
+            case Scenario::pooled_payload:
+                return run_vector_payload_benchmark<QueueTemplate, true>(bc.capacity, items);
+            case Scenario::bulk_copy:
+                return run_bulk_copy<QueueTemplate>(bc, items);
+            case Scenario::pipeline:
+                return run_pipeline_benchmark<QueueTemplate<int>>(bc.capacity, bc.stages, items);
+            case Scenario::fan_out:
+                return run_fan_out_benchmark<QueueTemplate<int>>(bc.capacity, bc.readers, items);
+            case Scenario::latency:
+            case Scenario::first_lap:
+            case Scenario::ping_pong:
+                break;
+            }
+            std::abort();
+        }
+    }
+
+    template <template <class> class QueueTemplate>
+    Aggregate run_throughput_case(QueueKind queue, const BenchCase &bc)
+    {
+        std::vector<RunResult> runs;
+        runs.reserve(config.repeats);
+        for (std::size_t i = 0; i < config.repeats; ++i)
+        {
+            runs.push_back(run_case<QueueTemplate>(bc, config.items));
+        }
+
+        Aggregate out;
+        out.queue = queue;
+        out.bench_case = bc;
+        out.items = config.items;
+        out.payload_bytes = payload_bytes(bc);
+
+        std::vector<double> elapsed;
+        elapsed.reserve(runs.size());
+
+        for (const RunResult &r : runs)
+        {
+            out.avg_elapsed_ms += r.elapsed_ms;
+            elapsed.push_back(r.elapsed_ms);
+            out.producer_cpu_ms += r.producer.cpu_ms;
+            out.consumer_cpu_ms += r.consumer.cpu_ms;
+            out.context_switches += static_cast<double>(r.producer.context_switches + r.consumer.context_switches);
+        }
+
+        const double run_count = static_cast<double>(runs.size());
+        out.avg_elapsed_ms /= run_count;
+        out.producer_cpu_ms /= run_count;
+        out.consumer_cpu_ms /= run_count;
+        out.context_switches /= run_count;
+        out.cycles = mean_counter(runs, &ThreadCounters::cycles);
+        out.instructions = mean_counter(runs, &ThreadCounters::instructions);
+        out.cache_misses = mean_counter(runs, &ThreadCounters::cache_misses);
+        out.hitm = mean_counter(runs, &ThreadCounters::hitm);
+
+        double elapsed_var = 0.0;
+        for (double v : elapsed)
+        {
+            const double d = v - out.avg_elapsed_ms;
+            elapsed_var += d * d;
+        }
+        out.stdev_elapsed_ms = std::sqrt(elapsed_var / static_cast<double>(elapsed.size()));
+
+        return out;
+    }
+
+    // Enqueue-to-dequeue latency: the producer stamps each item right before push(), the consumer
+    // records now - stamp right after pop(). The producer is paced with producer_cycles of work per
+    // item so the queue mostly runs near empty and the histogram shows the hand-off latency rather
+    // than the time items spend waiting behind a full ring.
+    template <typename Queue>
+    void run_latency_benchmark(std::size_t capacity, std::size_t items, std::size_t producer_cycles, LatencyHistogram &histogram)
+    {
+        const auto queue = make_queue<Queue>(capacity);
+        Queue &q = *queue;
+
+        std::jthread producer([&]{
+            pin_current_thread(placement.cpus.producer);
+            for (std::size_t i = 0; i < items; ++i)
+            {
+                busy_cycles(producer_cycles);
+                const bool pushed = q.push(LatencyPayload{i, now_ns()});
+                assert(pushed);
+            }
+            q.close();
+        });
+
+        std::jthread consumer([&]{
+            pin_current_thread(placement.cpus.consumer);
+            std::uint64_t expected = 0;
+            while (true)
+            {
+                auto value = q.pop();
+                if (!value.has_value())
+                {
+                    break;
+                }
+
+                const std::int64_t delta = now_ns() - value->stamp_ns;
+                assert(value->seq == expected);
+                histogram.record(static_cast<std::uint64_t>(std::max<std::int64_t>(delta, 0)));
+                ++expected;
+            }
+        });
+    }
+
+    // Round trip: the initiator stamps an item and pushes it to the echo thread, which pushes it
+    // back on a second queue; the initiator records now - stamp once it pops the item. One item is
+    // in flight at a time, so each sample is two hand-offs plus the wake-ups of both sides.
+    template <typename Queue>
+    void run_ping_pong_benchmark(std::size_t capacity, std::size_t items, LatencyHistogram &histogram)
+    {
+        const auto ping = make_queue<Queue>(capacity);
+        const auto pong = make_queue<Queue>(capacity);
+
+        std::jthread echo([&]{
+            pin_current_thread(placement.cpus.consumer);
+            for (auto value = ping->pop(); value.has_value(); value = ping->pop())
+            {
+                const bool pushed = pong->push(*value);
+                assert(pushed);
+                publish_pushes(*pong);
+            }
+            pong->close();
+        });
+
+        std::jthread initiator([&]{
+            pin_current_thread(placement.cpus.producer);
+            for (std::size_t i = 0; i < items; ++i)
+            {
+                const bool pushed = ping->push(LatencyPayload{i, now_ns()});
+                assert(pushed);
+                publish_pushes(*ping);
+
+                const auto value = pong->pop();
+                assert(value.has_value() && value->seq == i);
+                const std::int64_t delta = now_ns() - value->stamp_ns;
+                histogram.record(static_cast<std::uint64_t>(std::max<std::int64_t>(delta, 0)));
+            }
+            ping->close();
+        });
+    }
+
+    // latency: config.items per run. first-lap: exactly one lap of a fresh ring per run, so every
+    // slot is written for the first time and page faults (or their absence) show in the tail.
+    // ping-pong: config.items round trips per run.
+    template <template <class> class QueueTemplate>
+    LatencyAggregate run_latency_case(QueueKind queue, const BenchCase &bc)
+    {
+        const std::size_t items = bc.scenario == Scenario::first_lap ? bc.capacity : config.items;
+
+        // One histogram for all repeats, allocated before any thread starts.
+        auto histogram = std::make_unique<LatencyHistogram>();
+        for (std::size_t i = 0; i < config.repeats; ++i)
+        {
+            if (bc.scenario == Scenario::ping_pong)
+            {
+                run_ping_pong_benchmark<QueueTemplate<LatencyPayload>>(bc.capacity, items, *histogram);
+            }
+            else
+            {
+                run_latency_benchmark<QueueTemplate<LatencyPayload>>(bc.capacity, items, config.producer_cycles, *histogram);
+            }
+        }
+
+        LatencyAggregate out;
+        out.queue = queue;
+        out.scenario = bc.scenario;
+        out.capacity = bc.capacity;
+        out.items = items;
+        out.samples = histogram->count();
+        out.p50_ns = histogram->percentile(0.50);
+        out.p90_ns = histogram->percentile(0.90);
+        out.p99_ns = histogram->percentile(0.99);
+        out.p999_ns = histogram->percentile(0.999);
+        out.max_ns = histogram->max();
+        return out;
+    }
+
+    template <template <class> class QueueTemplate>
+    void run_for_queue(QueueKind queue, Results &results)
+    {
+        for (const BenchCase &bc : make_cases(queue))
+        {
+            // Progress goes to stderr so stdout carries only the results.
+            std::cerr << std::format("[{}] Running {} {} cap={} batch={} producers={} stages={} readers={}\n",
+                                     to_string(queue),
+                                     to_string(mode_for(bc.scenario)),
+                                     to_string(bc.scenario),
+                                     bc.capacity,
+                                     bc.batch,
+                                     bc.producers,
+                                     bc.stages,
+                                     bc.readers);
+
+            if (bc.scenario == Scenario::latency || bc.scenario == Scenario::first_lap || bc.scenario == Scenario::ping_pong)
+            {
+                if constexpr (!broadcasting<QueueTemplate<LatencyPayload>>)
+                {
+                    results.latency.push_back(run_latency_case<QueueTemplate>(queue, bc));
+                }
+            }
+            else
+            {
+                results.throughput.push_back(run_throughput_case<QueueTemplate>(queue, bc));
+            }
+        }
+    }
+
+    void run_queue(QueueKind queue, Results &results)
+    {
+        switch (queue)
+        {
+        case QueueKind::simple:
+            return run_for_queue<simple_spsc_queue>(queue, results);
+        case QueueKind::atomic:
+            return run_for_queue<bench_atomic_queue>(queue, results);
+        case QueueKind::atomic_pow2:
+            return run_for_queue<atomic_pow2_spsc_queue>(queue, results);
+        case QueueKind::atomic_busy_spin:
+            return run_for_queue<atomic_wait_queue<busy_spin_wait>::type>(queue, results);
+        case QueueKind::atomic_backoff:
+            return run_for_queue<atomic_wait_queue<backoff_wait<>>::type>(queue, results);
+        case QueueKind::atomic_yield:
+            return run_for_queue<atomic_wait_queue<yield_wait>::type>(queue, results);
+        case QueueKind::atomic_sleep:
+            return run_for_queue<atomic_wait_queue<sleep_wait<>>::type>(queue, results);
+        case QueueKind::atomic_park:
+            return run_for_queue<atomic_wait_queue<park_wait<>>::type>(queue, results);
+        case QueueKind::atomic_condvar:
+            return run_for_queue<atomic_wait_queue<condvar_wait<>>::type>(queue, results);
+        case QueueKind::atomic_huge:
+            return run_for_queue<atomic_huge_queue>(queue, results);
+        case QueueKind::atomic_stream:
+            return run_for_queue<atomic_stream_queue>(queue, results);
+        case QueueKind::atomic_lazy_4:
+            return run_for_queue<atomic_lazy_queue<4>::type>(queue, results);
+        case QueueKind::atomic_lazy_16:
+            return run_for_queue<atomic_lazy_queue<16>::type>(queue, results);
+        case QueueKind::atomic_lazy_64:
+            return run_for_queue<atomic_lazy_queue<64>::type>(queue, results);
+        case QueueKind::slot:
+            return run_for_queue<bench_slot_queue>(queue, results);
+        case QueueKind::slot_packed:
+            return run_for_queue<slot_packed_queue>(queue, results);
+        case QueueKind::unbounded:
+            return run_for_queue<bench_unbounded_queue>(queue, results);
+        case QueueKind::mpsc:
+            return run_for_queue<bench_mpsc_queue>(queue, results);
+        case QueueKind::mpmc:
+            return run_for_queue<bench_mpmc_queue>(queue, results);
+        case QueueKind::broadcast:
+            return run_for_queue<bench_broadcast_queue>(queue, results);
+        }
+    }
+
+    void print_latency_table(std::ostream &os, const std::vector<LatencyAggregate> &rows)
+    {
+        os << std::format("{:<15}{:<15}{:<10}{:<12}{:<12}{:<12}{:<12}{:<12}{:<12}\n",
+                          "queue", "scenario", "cap", "samples", "p50 ns", "p90 ns", "p99 ns", "p99.9 ns", "max ns");
+
+        for (const LatencyAggregate &r : rows)
+        {
+            os << std::format("{:<15}{:<15}{:<10}{:<12}{:<12}{:<12}{:<12}{:<12}{:<12}\n",
+                              to_string(r.queue),
+                              to_string(r.scenario),
+                              r.capacity,
+                              r.samples,
+                              r.p50_ns,
+                              r.p90_ns,
+                              r.p99_ns,
+                              r.p999_ns,
+                              r.max_ns);
+        }
+    }
+
+    void print_table(std::ostream &os, const std::vector<Aggregate> &rows)
+    {
+        os << std::format("{:<15}{:<15}{:<15}{:<8}{:<8}{:<6}{:<8}{:<8}{:<8}{:<15}{:<15}{:<12}{:<12}{:<12}\n",
+                          "queue", "mode", "scenario", "cap", "batch", "prod", "stages", "readers", "bytes",
+                          "avg ms", "stdev ms", "ns/op", "Mops/s", "GB/s");
 
         for (const Aggregate &r : rows)
         {
-            std::cout << std::format("{:<8}{:<15}{:<15}{:<15}{:<13.2f}{:<13.2f}\n",
-                                     to_string(r.queue),
-                                     to_string(mode_for(r.bench_case.scenario)),
-                                     to_string(r.bench_case.scenario),
-                                     r.bench_case.capacity,
-                                     r.avg_elapsed_ms,
-                                     r.stdev_elapsed_ms);
+            os << std::format("{:<15}{:<15}{:<15}{:<8}{:<8}{:<6}{:<8}{:<8}{:<8}{:<15.2f}{:<15.2f}{:<12.2f}{:<12.2f}{:<12.3f}\n",
+                              to_string(r.queue),
+                              to_string(mode_for(r.bench_case.scenario)),
+                              to_string(r.bench_case.scenario),
+                              r.bench_case.capacity,
+                              r.bench_case.batch,
+                              r.bench_case.producers,
+                              r.bench_case.stages,
+                              r.bench_case.readers,
+                              r.payload_bytes,
+                              r.avg_elapsed_ms,
+                              r.stdev_elapsed_ms,
+                              ns_per_item(r),
+                              mops(r),
+                              gbps(r));
+        }
+    }
+
+    std::string table_cell(std::optional<double> v)
+    {
+        return v.has_value() ? std::format("{:.2f}", *v) : "n/a";
+    }
+
+    // CPU cost of the throughput rows: CPU time of each side, CPU utilization (all threads
+    // over wall time), context switches per run and hardware counters per item.
+    void print_cpu_table(std::ostream &os, const std::vector<Aggregate> &rows)
+    {
+        os << std::format("{:<15}{:<15}{:<15}{:<8}{:<8}{:<6}{:<8}{:<8}{:<12}{:<12}{:<10}{:<12}{:<12}{:<12}{:<12}{:<12}\n",
+                          "queue", "mode", "scenario", "cap", "batch", "prod", "stages", "readers",
+                          "prod cpu ms", "cons cpu ms", "cpu/wall", "ctx sw",
+                          "cyc/item", "ins/item", "miss/item", "hitm/item");
+
+        for (const Aggregate &r : rows)
+        {
+            os << std::format("{:<15}{:<15}{:<15}{:<8}{:<8}{:<6}{:<8}{:<8}{:<12.2f}{:<12.2f}{:<10.2f}{:<12.0f}{:<12}{:<12}{:<12}{:<12}\n",
+                              to_string(r.queue),
+                              to_string(mode_for(r.bench_case.scenario)),
+                              to_string(r.bench_case.scenario),
+                              r.bench_case.capacity,
+                              r.bench_case.batch,
+                              r.bench_case.producers,
+                              r.bench_case.stages,
+                              r.bench_case.readers,
+                              r.producer_cpu_ms,
+                              r.consumer_cpu_ms,
+                              cpu_utilization(r),
+                              r.context_switches,
+                              table_cell(per_item(r, r.cycles)),
+                              table_cell(per_item(r, r.instructions)),
+                              table_cell(per_item(r, r.cache_misses)),
+                              table_cell(per_item(r, r.hitm)));
+        }
+    }
+
+    void write_table(std::ostream &os, const Results &results)
+    {
+        print_table(os, results.throughput);
+        os << "\n";
+        print_cpu_table(os, results.throughput);
+        if (!results.latency.empty())
+        {
+            os << "\n";
+            print_latency_table(os, results.latency);
+        }
+    }
+
+    // All names written below are fixed identifiers, so no JSON string escaping is needed.
+    void write_json(std::ostream &os, const Results &results)
+    {
+        os << "{\n";
+        os << std::format("  \"config\": {{\"items\": {}, \"repeats\": {}, \"payload_size\": {}, "
+                          "\"producer_cycles\": {}, \"consumer_cycles\": {}, \"pin\": \"{}\", "
+                          "\"producer_cpu\": {}, \"consumer_cpu\": {}, \"numa_node\": {}, \"first_touch\": \"{}\"}},\n",
+                          config.items,
+                          config.repeats,
+                          config.payload_size,
+                          config.producer_cycles,
+                          config.consumer_cycles,
+                          to_string(placement.preset),
+                          placement.cpus.producer,
+                          placement.cpus.consumer,
+                          placement.numa_node,
+                          placement.consumer_first_touch ? "consumer" : "default");
+
+        os << "  \"throughput\": [";
+        for (std::size_t i = 0; i < results.throughput.size(); ++i)
+        {
+            const Aggregate &r = results.throughput[i];
+            os << (i == 0 ? "\n" : ",\n");
+            os << std::format("    {{\"queue\": \"{}\", \"mode\": \"{}\", \"scenario\": \"{}\", \"capacity\": {}, "
+                              "\"batch\": {}, \"producers\": {}, \"stages\": {}, \"readers\": {}, \"payload_bytes\": {}, \"items\": {}, \"avg_ms\": {}, \"stdev_ms\": {}, "
+                              "\"ns_per_item\": {}, \"mops\": {}, \"gbps\": {}, \"producer_cpu_ms\": {}, "
+                              "\"consumer_cpu_ms\": {}, \"cpu_utilization\": {}, \"context_switches\": {}, "
+                              "\"cycles_per_item\": {}, \"instructions_per_item\": {}, "
+                              "\"cache_misses_per_item\": {}, \"hitm_per_item\": {}}}",
+                              to_string(r.queue),
+                              to_string(mode_for(r.bench_case.scenario)),
+                              to_string(r.bench_case.scenario),
+                              r.bench_case.capacity,
+                              r.bench_case.batch,
+                              r.bench_case.producers,
+                              r.bench_case.stages,
+                              r.bench_case.readers,
+                              r.payload_bytes,
+                              r.items,
+                              r.avg_elapsed_ms,
+                              r.stdev_elapsed_ms,
+                              ns_per_item(r),
+                              mops(r),
+                              gbps(r),
+                              r.producer_cpu_ms,
+                              r.consumer_cpu_ms,
+                              cpu_utilization(r),
+                              r.context_switches,
+                              format_optional(per_item(r, r.cycles), "null"),
+                              format_optional(per_item(r, r.instructions), "null"),
+                              format_optional(per_item(r, r.cache_misses), "null"),
+                              format_optional(per_item(r, r.hitm), "null"));
+        }
+        os << (results.throughput.empty() ? "],\n" : "\n  ],\n");
+
+        os << "  \"latency\": [";
+        for (std::size_t i = 0; i < results.latency.size(); ++i)
+        {
+            const LatencyAggregate &r = results.latency[i];
+            os << (i == 0 ? "\n" : ",\n");
+            os << std::format("    {{\"queue\": \"{}\", \"scenario\": \"{}\", \"capacity\": {}, \"samples\": {}, \"p50_ns\": {}, "
+                              "\"p90_ns\": {}, \"p99_ns\": {}, \"p999_ns\": {}, \"max_ns\": {}}}",
+                              to_string(r.queue),
+                              to_string(r.scenario),
+                              r.capacity,
+                              r.samples,
+                              r.p50_ns,
+                              r.p90_ns,
+                              r.p99_ns,
+                              r.p999_ns,
+                              r.max_ns);
+        }
+        os << (results.latency.empty() ? "]\n" : "\n  ]\n");
+        os << "}\n";
+    }
+
+    // One table for both kinds of rows; columns that do not apply to a row are left empty.
+    void write_csv(std::ostream &os, const Results &results)
+    {
+        os << "kind,queue,mode,scenario,capacity,batch,producers,stages,readers,payload_bytes,items,repeats,"
+              "avg_ms,stdev_ms,ns_per_item,mops,gbps,producer_cpu_ms,consumer_cpu_ms,cpu_utilization,context_switches,"
+              "cycles_per_item,instructions_per_item,cache_misses_per_item,hitm_per_item,"
+              "samples,p50_ns,p90_ns,p99_ns,p999_ns,max_ns\n";
+
+        for (const Aggregate &r : results.throughput)
+        {
+            os << std::format("throughput,{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},,,,,,\n",
+                              to_string(r.queue),
+                              to_string(mode_for(r.bench_case.scenario)),
+                              to_string(r.bench_case.scenario),
+                              r.bench_case.capacity,
+                              r.bench_case.batch,
+                              r.bench_case.producers,
+                              r.bench_case.stages,
+                              r.bench_case.readers,
+                              r.payload_bytes,
+                              r.items,
+                              config.repeats,
+                              r.avg_elapsed_ms,
+                              r.stdev_elapsed_ms,
+                              ns_per_item(r),
+                              mops(r),
+                              gbps(r),
+                              r.producer_cpu_ms,
+                              r.consumer_cpu_ms,
+                              cpu_utilization(r),
+                              r.context_switches,
+                              format_optional(per_item(r, r.cycles), ""),
+                              format_optional(per_item(r, r.instructions), ""),
+                              format_optional(per_item(r, r.cache_misses), ""),
+                              format_optional(per_item(r, r.hitm), ""));
+        }
+
+        for (const LatencyAggregate &r : results.latency)
+        {
+            os << std::format("latency,{},{},{},{},1,1,2,1,{},{},{},,,,,,,,,,,,,,{},{},{},{},{},{}\n",
+                              to_string(r.queue),
+                              to_string(Mode::blocking),
+                              to_string(r.scenario),
+                              r.capacity,
+                              sizeof(LatencyPayload),
+                              r.items,
+                              config.repeats,
+                              r.samples,
+                              r.p50_ns,
+                              r.p90_ns,
+                              r.p99_ns,
+                              r.p999_ns,
+                              r.max_ns);
+        }
+    }
+
+    constexpr const char *usage =
+        "usage: bench [options]\n"
+        "  --queue LIST            queues to run, comma separated (default: all):\n"
+        "                          simple, atomic, atomic-pow2, atomic-spin, atomic-backoff,\n"
+        "                          atomic-yield, atomic-sleep, atomic-park, atomic-condvar, atomic-huge,\n"
+        "                          atomic-stream, atomic-lazy4, atomic-lazy16, atomic-lazy64, slot, slot-packed,\n"
+        "                          unbounded, mpsc, mpmc, broadcast\n"
+        "  --scenario LIST         scenarios every selected queue runs, comma separated:\n"
+        "                          blocking, nonblocking, big-payload, producer-heavy,\n"
+        "                          consumer-heavy, batched, latency, fan-in,\n"
+        "                          vector-payload, pooled-payload, first-lap, bulk-copy,\n"
+        "                          pipeline, ping-pong, fan-out\n"
+        "                          (default: a per-queue set, see README)\n"
+        "  --capacities LIST       queue capacities for every scenario\n"
+        "                          (default: 64,1024,8192 for standard/latency/ping-pong, 1048576 for first-lap,\n"
+        "                          1024 otherwise)\n"
+        "  --batch-sizes LIST      batch sizes of the batched scenario (default: 8,64,512)\n"
+        "  --producers LIST        producer thread counts of the fan-in scenario (default: 1,2,4,8,16)\n"
+        "  --stages LIST           thread counts of the pipeline scenario, source and sink included\n"
+        "                          (default: 2,4,6)\n"
+        "  --readers LIST          reader thread counts of the fan-out scenario (default: 1,3,5)\n"
+        "  --items N               items per run (default: 1000000)\n"
+        "  --repeats N             runs per row (default: 20)\n"
+        "  --payload-size N        big-, vector- and pooled-payload size in bytes:\n"
+        "                          16, 32, 64, 128, 256, 512, 1024 (default: 64)\n"
+        "  --producer-cycles N     producer busy cycles per item in producer-heavy, latency, first-lap (default: 128)\n"
+        "  --consumer-cycles N     consumer busy cycles per item in consumer-heavy (default: 128)\n"
+        "  --hitm-event CODE       raw perf event counted as HITM, e.g. 0x04d2 on Skylake (default: off)\n"
+        "  --format table|json|csv output format (default: table)\n"
+        "  --output FILE           write results to FILE instead of stdout\n"
+        "  --pin same-core|same-socket|cross-socket\n"
+        "                          pin producer and consumer to a CPU pair picked from the topology:\n"
+        "                          SMT siblings of one core, two cores of one socket, or two sockets\n"
+        "  --producer-cpu N        pin the producer thread to CPU N (overrides --pin)\n"
+        "  --consumer-cpu N        pin the consumer thread to CPU N (overrides --pin)\n"
+        "  --numa-node N           bind the rings of the atomic queues to NUMA node N\n"
+        "  --first-touch consumer  prefault the rings of the atomic queues from the consumer CPU\n"
+        "  --help                  show this message\n";
+
+    std::size_t parse_size(std::string_view option, std::string_view value)
+    {
+        std::size_t parsed = 0;
+        std::size_t n = 0;
+        try
+        {
+            n = std::stoull(std::string(value), &parsed);
+        }
+        catch (const std::exception &)
+        {
+            parsed = 0;
+        }
+        if (parsed == 0 || parsed != value.size() || value.front() == '-')
+        {
+            throw std::invalid_argument("Invalid value for " + std::string(option) + ": " + std::string(value));
+        }
+        return n;
+    }
+
+    std::size_t parse_positive(std::string_view option, std::string_view value)
+    {
+        const std::size_t n = parse_size(option, value);
+        if (n == 0)
+        {
+            throw std::invalid_argument(std::string(option) + " must be positive");
+        }
+        return n;
+    }
+
+    std::vector<std::string_view> split_list(std::string_view list)
+    {
+        std::vector<std::string_view> out;
+        while (true)
+        {
+            const auto comma = list.find(',');
+            out.push_back(list.substr(0, comma));
+            if (comma == std::string_view::npos)
+            {
+                return out;
+            }
+            list.remove_prefix(comma + 1);
+        }
+    }
+
+    std::vector<std::size_t> parse_size_list(std::string_view option, std::string_view list)
+    {
+        std::vector<std::size_t> out;
+        for (std::string_view value : split_list(list))
+        {
+            out.push_back(parse_positive(option, value));
+        }
+        return out;
+    }
+
+    // Parses a comma-separated list of names, each equal to name_of(v) for one v in all.
+    template <typename T, std::size_t N, typename NameOf>
+    std::vector<T> parse_name_list(std::string_view option, std::string_view list, const std::array<T, N> &all, NameOf name_of)
+    {
+        std::vector<T> out;
+        for (std::string_view value : split_list(list))
+        {
+            const auto it = std::find_if(all.begin(), all.end(), [&](T v)
+                                         { return value == name_of(v); });
+            if (it == all.end())
+            {
+                throw std::invalid_argument("Unknown value for " + std::string(option) + ": " + std::string(value));
+            }
+            out.push_back(*it);
+        }
+        return out;
+    }
+
+    int parse_cpu(std::string_view value, const std::vector<CpuInfo> &topology)
+    {
+        const int cpu = static_cast<int>(parse_size("CPU", value));
+        const bool online = std::any_of(topology.begin(), topology.end(), [&](const CpuInfo &c)
+                                        { return c.cpu == cpu; });
+        if (!online)
+        {
+            throw std::invalid_argument("CPU " + std::to_string(cpu) + " is not online");
+        }
+        return cpu;
+    }
+
+    PinPreset parse_preset(std::string_view value)
+    {
+        for (PinPreset preset : {PinPreset::same_core, PinPreset::same_socket, PinPreset::cross_socket})
+        {
+            if (value == to_string(preset))
+            {
+                return preset;
+            }
+        }
+        throw std::invalid_argument("Unknown --pin preset: " + std::string(value));
+    }
+
+    OutputFormat parse_format(std::string_view value)
+    {
+        if (value == "table")
+        {
+            return OutputFormat::table;
+        }
+        if (value == "json")
+        {
+            return OutputFormat::json;
+        }
+        if (value == "csv")
+        {
+            return OutputFormat::csv;
         }
+        throw std::invalid_argument("Unknown --format: " + std::string(value));
+    }
+
+    // Parses the command line into config and placement. Throws std::invalid_argument on bad input.
+    // Returns false if only the usage was requested.
+    bool parse_options(int argc, char **argv)
+    {
+        const std::vector<CpuInfo> topology = read_cpu_topology();
+        std::optional<int> producer_cpu;
+        std::optional<int> consumer_cpu;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string_view arg = argv[i];
+            if (arg == "--help")
+            {
+                return false;
+            }
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("Missing value for " + std::string(arg));
+            }
+            const std::string_view value = argv[++i];
+
+            if (arg == "--queue")
+            {
+                config.queues = parse_name_list(arg, value, all_queue_kinds, [](QueueKind v)
+                                                { return to_string(v); });
+            }
+            else if (arg == "--scenario")
+            {
+                config.scenarios = parse_name_list(arg, value, all_scenarios, option_name);
+            }
+            else if (arg == "--capacities")
+            {
+                config.capacities = parse_size_list(arg, value);
+            }
+            else if (arg == "--batch-sizes")
+            {
+                config.batch_sizes = parse_size_list(arg, value);
+            }
+            else if (arg == "--producers")
+            {
+                config.producer_counts = parse_size_list(arg, value);
+            }
+            else if (arg == "--readers")
+            {
+                config.reader_counts = parse_size_list(arg, value);
+            }
+            else if (arg == "--stages")
+            {
+                config.stage_counts = parse_size_list(arg, value);
+                if (std::ranges::any_of(config.stage_counts, [](std::size_t n)
+                                        { return n < 2; }))
+                {
+                    throw std::invalid_argument(std::string(arg) + " values must be at least 2");
+                }
+            }
+            else if (arg == "--items")
+            {
+                config.items = parse_positive(arg, value);
+            }
+            else if (arg == "--repeats")
+            {
+                config.repeats = parse_positive(arg, value);
+            }
+            else if (arg == "--payload-size")
+            {
+                config.payload_size = parse_size(arg, value);
+                if (std::find(payload_sizes.begin(), payload_sizes.end(), config.payload_size) == payload_sizes.end())
+                {
+                    throw std::invalid_argument("Unsupported --payload-size: " + std::string(value));
+                }
+            }
+            else if (arg == "--producer-cycles")
+            {
+                config.producer_cycles = parse_size(arg, value);
+            }
+            else if (arg == "--consumer-cycles")
+            {
+                config.consumer_cycles = parse_size(arg, value);
+            }
+            else if (arg == "--hitm-event")
+            {
+                std::size_t parsed = 0;
+                try
+                {
+                    config.hitm_event = std::stoull(std::string(value), &parsed, 0);
+                }
+                catch (const std::exception &)
+                {
+                    parsed = 0;
+                }
+                if (parsed == 0 || parsed != value.size())
+                {
+                    throw std::invalid_argument("Invalid value for --hitm-event: " + std::string(value));
+                }
+            }
+            else if (arg == "--format")
+            {
+                config.format = parse_format(value);
+            }
+            else if (arg == "--output")
+            {
+                config.output = std::string(value);
+            }
+            else if (arg == "--pin")
+            {
+                placement.preset = parse_preset(value);
+            }
+            else if (arg == "--producer-cpu")
+            {
+                producer_cpu = parse_cpu(value, topology);
+            }
+            else if (arg == "--consumer-cpu")
+            {
+                consumer_cpu = parse_cpu(value, topology);
+            }
+            else if (arg == "--numa-node")
+            {
+                placement.numa_node = static_cast<int>(parse_size(arg, value));
+                if (!std::filesystem::exists("/sys/devices/system/node/node" + std::to_string(placement.numa_node)))
+                {
+                    throw std::invalid_argument("NUMA node " + std::string(value) + " does not exist");
+                }
+            }
+            else if (arg == "--first-touch")
+            {
+                if (value != "consumer")
+                {
+                    throw std::invalid_argument("Unknown --first-touch value: " + std::string(value));
+                }
+                placement.consumer_first_touch = true;
+            }
+            else
+            {
+                throw std::invalid_argument("Unknown option: " + std::string(arg));
+            }
+        }
+
+        const std::optional<CpuPair> pair = cpus_for(placement.preset, topology);
+        if (!pair.has_value())
+        {
+            throw std::invalid_argument(std::string("No CPU pair for --pin ") + to_string(placement.preset));
+        }
+        placement.cpus = *pair;
+        placement.cpus.producer = producer_cpu.value_or(placement.cpus.producer);
+        placement.cpus.consumer = consumer_cpu.value_or(placement.cpus.consumer);
+
+        if (placement.consumer_first_touch && placement.cpus.consumer < 0)
+        {
+            throw std::invalid_argument("--first-touch consumer needs a pinned consumer");
+        }
+        if (placement.consumer_first_touch && placement.numa_node >= 0)
+        {
+            throw std::invalid_argument("--first-touch and --numa-node are mutually exclusive");
+        }
+        return true;
     }
 
 } // namespace
 
 int main(int argc, char **argv)
 {
-    std::cout << std::format("Starting benchmark for items={} repeats={}\n", item_count, repeat_count);
+    std::ofstream file;
+    try
+    {
+        if (!parse_options(argc, argv))
+        {
+            std::cout << usage;
+            return 0;
+        }
+        if (!config.output.empty())
+        {
+            file.open(config.output);
+            if (!file)
+            {
+                throw std::invalid_argument("Cannot open " + config.output);
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "bench: " << e.what() << "\n" << usage;
+        return 1;
+    }
+    std::ostream &out = config.output.empty() ? std::cout : file;
+
+    std::cerr << std::format("Starting benchmark for items={} repeats={}\n", config.items, config.repeats);
+    std::cerr << std::format("Placement: pin={} producer-cpu={} consumer-cpu={} numa-node={} first-touch={}\n",
+                             to_string(placement.preset),
+                             placement.cpus.producer,
+                             placement.cpus.consumer,
+                             placement.numa_node,
+                             placement.consumer_first_touch ? "consumer" : "default");
 
-    const std::vector<BenchCase> cases = make_cases();
-    std::vector<Aggregate> aggregates;
-    run_for_queue<simple_spsc_queue>(QueueKind::simple, cases, aggregates);
-    run_for_queue<atomic_spsc_queue>(QueueKind::atomic, cases, aggregates);
+    Results results;
+    for (QueueKind queue : config.queues)
+    {
+        run_queue(queue, results);
+    }
 
-    print_table(aggregates);
+    switch (config.format)
+    {
+    case OutputFormat::table:
+        write_table(out, results);
+        break;
+    case OutputFormat::json:
+        write_json(out, results);
+        break;
+    case OutputFormat::csv:
+        write_csv(out, results);
+        break;
+    }
     return 0;
 }
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/// @brief What ThreadProbe measured on one thread.
+///
+/// Hardware counters are nullopt where perf_event_open() is unavailable (non-Linux, VMs
+/// without a PMU, perf_event_paranoid too strict) or the event is not supported.
+
+struct ThreadCounters
+{
+    double cpu_ms = 0.0;
+    std::uint64_t context_switches = 0;
+    std::optional<std::uint64_t> cycles;
+    std::optional<std::uint64_t> instructions;
+    std::optional<std::uint64_t> cache_misses;
+    std::optional<std::uint64_t> hitm;
+};
+
+/// @class ThreadProbe
+/// @brief Per-thread CPU time and hardware counters, started on construction and read by stop().
+///
+/// @details
+/// Must be constructed and stopped on the measured thread.
+///
+/// - CPU time comes from clock_gettime(CLOCK_THREAD_CPUTIME_ID), context switches (voluntary
+///   and involuntary) from getrusage(RUSAGE_THREAD).
+/// - cycles, instructions and cache misses are the generic perf hardware events, counted in
+///   user space only, so they work with the default perf_event_paranoid setting.
+/// - There is no generic perf event for HITM (loads that hit a line modified in another
+///   core's cache) or remote-LLC snoops, so it is a raw, model-specific event code passed
+///   by the caller, e.g. 0x04d2 (MEM_LOAD_L3_HIT_RETIRED.XSNP_HITM on Skylake).
+/// - The events are opened as one group so they are scheduled together. If the PMU
+///   multiplexes them, values are scaled by time enabled / time running.
+
+class ThreadProbe
+{
+public:
+    explicit ThreadProbe(std::optional<std::uint64_t> hitm_event = std::nullopt)
+    {
+#if defined(__linux__)
+        open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, cycles_slot);
+        open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, instructions_slot);
+        open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, cache_misses_slot);
+        if (hitm_event.has_value())
+        {
+            open(PERF_TYPE_RAW, *hitm_event, hitm_slot);
+        }
+
+        context_switches_start_ = context_switches();
+        cpu_start_ns_ = thread_cpu_ns();
+        if (leader() >= 0)
+        {
+            ::ioctl(leader(), PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ::ioctl(leader(), PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#else
+        (void)hitm_event;
+#endif
+    }
+
+    ThreadCounters stop()
+    {
+        ThreadCounters out;
+#if defined(__linux__)
+        if (leader() >= 0)
+        {
+            ::ioctl(leader(), PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        }
+        out.cpu_ms = static_cast<double>(thread_cpu_ns() - cpu_start_ns_) / 1e6;
+        out.context_switches = context_switches() - context_switches_start_;
+
+        // read_format GROUP | TOTAL_TIME_ENABLED | TOTAL_TIME_RUNNING:
+        // { nr, time_enabled, time_running, value[nr] }, values in the order the events were opened.
+        std::array<std::uint64_t, 3 + slot_count> buffer{};
+        if (leader() >= 0 && ::read(leader(), buffer.data(), sizeof(buffer)) > 0 && buffer[2] != 0)
+        {
+            const double scale = static_cast<double>(buffer[1]) / static_cast<double>(buffer[2]);
+            std::size_t next = 3;
+            std::array<std::optional<std::uint64_t>, slot_count> values{};
+            for (std::size_t slot = 0; slot < slot_count; ++slot)
+            {
+                if (fds_[slot] >= 0)
+                {
+                    values[slot] = static_cast<std::uint64_t>(static_cast<double>(buffer[next++]) * scale);
+                }
+            }
+            out.cycles = values[cycles_slot];
+            out.instructions = values[instructions_slot];
+            out.cache_misses = values[cache_misses_slot];
+            out.hitm = values[hitm_slot];
+        }
+#endif
+        return out;
+    }
+
+    ~ThreadProbe()
+    {
+#if defined(__linux__)
+        for (int fd : fds_)
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+#endif
+    }
+
+    ThreadProbe(const ThreadProbe &) = delete;
+    ThreadProbe &operator=(const ThreadProbe &) = delete;
+
+private:
+    static constexpr std::size_t cycles_slot = 0;
+    static constexpr std::size_t instructions_slot = 1;
+    static constexpr std::size_t cache_misses_slot = 2;
+    static constexpr std::size_t hitm_slot = 3;
+    static constexpr std::size_t slot_count = 4;
+
+#if defined(__linux__)
+    int leader() const
+    {
+        return fds_[cycles_slot];
+    }
+
+    // Opens one event of the group on the calling thread. The first event (cycles) leads the
+    // group; if it cannot be opened, no other event is opened either.
+    void open(std::uint32_t type, std::uint64_t config, std::size_t slot)
+    {
+        if (slot != cycles_slot && leader() < 0)
+        {
+            return;
+        }
+
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = slot == cycles_slot ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        // pid 0, cpu -1: the calling thread on any CPU.
+        const long fd = ::syscall(SYS_perf_event_open, &attr, 0, -1, slot == cycles_slot ? -1 : leader(), PERF_FLAG_FD_CLOEXEC);
+        fds_[slot] = static_cast<int>(fd);
+    }
+
+    static std::int64_t thread_cpu_ns()
+    {
+        timespec ts{};
+        ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    static std::uint64_t context_switches()
+    {
+        rusage usage{};
+        ::getrusage(RUSAGE_THREAD, &usage);
+        return static_cast<std::uint64_t>(usage.ru_nvcsw + usage.ru_nivcsw);
+    }
+
+    std::array<int, slot_count> fds_{-1, -1, -1, -1};
+    std::int64_t cpu_start_ns_ = 0;
+    std::uint64_t context_switches_start_ = 0;
+#endif
+};
@@ -0,0 +1,368 @@
+#include "atomic_spsc_queue.hpp"
+#include "queue_awaitables.hpp"
+#include "simple_spsc_queue.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+    // Fire-and-forget coroutine: runs eagerly and frees its frame when it finishes.
+    // Note: ASSERT_* cannot be used inside coroutines, they expand to a plain return.
+    struct detached_task
+    {
+        struct promise_type
+        {
+            detached_task get_return_object()
+            {
+                return {};
+            }
+            std::suspend_never initial_suspend() noexcept
+            {
+                return {};
+            }
+            std::suspend_never final_suspend() noexcept
+            {
+                return {};
+            }
+            void return_void() {}
+            void unhandled_exception()
+            {
+                std::terminate();
+            }
+        };
+    };
+
+    // Single-threaded executor: post() queues a coroutine, run_pending() resumes what is queued.
+    struct manual_executor
+    {
+        std::deque<std::coroutine_handle<>> ready;
+
+        auto poster()
+        {
+            return [this](std::coroutine_handle<> h)
+            { ready.push_back(h); };
+        }
+
+        std::size_t run_pending()
+        {
+            std::size_t resumed = 0;
+            while (!ready.empty())
+            {
+                std::coroutine_handle<> h = ready.front();
+                ready.pop_front();
+                h.resume();
+                ++resumed;
+            }
+            return resumed;
+        }
+    };
+
+    // Thread-safe executor: other threads post(), the owning thread run()s until stop().
+    class event_loop
+    {
+    public:
+        auto poster()
+        {
+            return [this](std::coroutine_handle<> h)
+            { post(h); };
+        }
+
+        void post(std::coroutine_handle<> h)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                ready_.push_back(h);
+            }
+            cv_.notify_one();
+        }
+
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                stopped_ = true;
+            }
+            cv_.notify_one();
+        }
+
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            for (;;)
+            {
+                cv_.wait(lock, [this]
+                         { return stopped_ || !ready_.empty(); });
+                if (ready_.empty())
+                {
+                    return;
+                }
+                std::coroutine_handle<> h = ready_.front();
+                ready_.pop_front();
+                lock.unlock();
+                h.resume();
+                lock.lock();
+            }
+        }
+
+    private:
+        std::mutex mtx_;
+        std::condition_variable cv_;
+        std::deque<std::coroutine_handle<>> ready_;
+        bool stopped_ = false;
+    };
+
+    template <class Queue>
+    detached_task pop_into(Queue &q, std::vector<std::optional<int>> &out)
+    {
+        out.push_back(co_await q.async_pop());
+    }
+
+    template <class Queue>
+    detached_task push_from(Queue &q, int value, std::vector<bool> &out)
+    {
+        out.push_back(co_await q.async_push(value));
+    }
+
+    template <typename Q>
+    class AsyncQueueTest : public ::testing::Test
+    {
+    };
+
+    using AsyncQueueImplementations = ::testing::Types<
+        simple_spsc_queue<int>,
+        atomic_spsc_queue<int, modulo_index_policy, async_wait>,
+        atomic_spsc_queue<int, pow2_index_policy, async_wait>>;
+
+    TYPED_TEST_SUITE(AsyncQueueTest, AsyncQueueImplementations);
+
+    TYPED_TEST(AsyncQueueTest, CompletesWithoutSuspendingWhenReady)
+    {
+        TypeParam q(2);
+        std::vector<bool> pushed;
+        std::vector<std::optional<int>> popped;
+
+        push_from(q, 7, pushed);
+        ASSERT_EQ(pushed, std::vector<bool>{true});
+
+        pop_into(q, popped);
+        ASSERT_EQ(popped.size(), 1U);
+        EXPECT_EQ(popped[0], 7);
+    }
+
+    TYPED_TEST(AsyncQueueTest, PopSuspendsUntilPush)
+    {
+        TypeParam q(2);
+        std::vector<std::optional<int>> popped;
+
+        pop_into(q, popped);
+        EXPECT_TRUE(popped.empty());
+
+        ASSERT_TRUE(q.try_push(42));
+        ASSERT_EQ(popped.size(), 1U);
+        EXPECT_EQ(popped[0], 42);
+        EXPECT_FALSE(q.try_pop().has_value());
+    }
+
+    TYPED_TEST(AsyncQueueTest, PushSuspendsWhileFullAndResumesOnPop)
+    {
+        TypeParam q(1);
+        std::vector<bool> pushed;
+
+        ASSERT_TRUE(q.try_push(1));
+        push_from(q, 2, pushed);
+        EXPECT_TRUE(pushed.empty());
+
+        EXPECT_EQ(q.try_pop(), 1);
+        ASSERT_EQ(pushed, std::vector<bool>{true});
+        EXPECT_EQ(q.try_pop(), 2);
+    }
+
+    TYPED_TEST(AsyncQueueTest, BlockingAndBatchOperationsResumeWaiters)
+    {
+        TypeParam q(2);
+        std::vector<std::optional<int>> popped;
+
+        pop_into(q, popped);
+        const std::vector<int> batch{5, 6};
+        ASSERT_EQ(q.try_push_n(batch.begin(), batch.end()), 2U);
+        ASSERT_EQ(popped.size(), 1U);
+        EXPECT_EQ(popped[0], 5);
+
+        std::vector<bool> pushed;
+        ASSERT_TRUE(q.try_push(7));
+        push_from(q, 8, pushed);
+        EXPECT_TRUE(pushed.empty());
+
+        std::vector<int> out(2);
+        ASSERT_EQ(q.try_pop_n(out.begin(), out.size()), 2U);
+        EXPECT_EQ(out, (std::vector<int>{6, 7}));
+        ASSERT_EQ(pushed, std::vector<bool>{true});
+        EXPECT_EQ(q.pop(), 8);
+    }
+
+    TYPED_TEST(AsyncQueueTest, CloseResumesPopWithNullopt)
+    {
+        TypeParam q(2);
+        std::vector<std::optional<int>> popped;
+
+        pop_into(q, popped);
+        EXPECT_TRUE(popped.empty());
+
+        q.close();
+        ASSERT_EQ(popped.size(), 1U);
+        EXPECT_FALSE(popped[0].has_value());
+    }
+
+    TYPED_TEST(AsyncQueueTest, CloseResumesPushWithFalse)
+    {
+        TypeParam q(1);
+        std::vector<bool> pushed;
+
+        ASSERT_TRUE(q.try_push(1));
+        push_from(q, 2, pushed);
+        EXPECT_TRUE(pushed.empty());
+
+        q.close();
+        ASSERT_EQ(pushed, std::vector<bool>{false});
+        EXPECT_EQ(q.try_pop(), 1);
+        EXPECT_FALSE(q.try_pop().has_value());
+    }
+
+    TYPED_TEST(AsyncQueueTest, ClosedQueueStillDrainsBeforeNullopt)
+    {
+        TypeParam q(2);
+        ASSERT_TRUE(q.try_push(3));
+        q.close();
+
+        std::vector<std::optional<int>> popped;
+        pop_into(q, popped);
+        pop_into(q, popped);
+        ASSERT_EQ(popped.size(), 2U);
+        EXPECT_EQ(popped[0], 3);
+        EXPECT_FALSE(popped[1].has_value());
+
+        std::vector<bool> pushed;
+        push_from(q, 4, pushed);
+        EXPECT_EQ(pushed, std::vector<bool>{false});
+    }
+
+    TYPED_TEST(AsyncQueueTest, ExecutorPostDefersResumption)
+    {
+        TypeParam q(2);
+        manual_executor executor;
+        std::optional<int> popped;
+
+        [](TypeParam &q, manual_executor &executor, std::optional<int> &popped) -> detached_task
+        {
+            popped = co_await q.async_pop(executor.poster());
+        }(q, executor, popped);
+
+        ASSERT_TRUE(q.try_push(9));
+        // The push only queued the consumer on its executor.
+        EXPECT_FALSE(popped.has_value());
+        EXPECT_EQ(executor.ready.size(), 1U);
+
+        EXPECT_EQ(executor.run_pending(), 1U);
+        EXPECT_EQ(popped, 9);
+    }
+
+    TYPED_TEST(AsyncQueueTest, ManyQueuesMultiplexedOnOneThread)
+    {
+        constexpr std::size_t pairs = 16;
+        constexpr int items = 200;
+
+        std::vector<std::unique_ptr<TypeParam>> queues;
+        std::vector<int> sums(pairs, 0);
+        std::vector<int> counts(pairs, 0);
+        manual_executor executor;
+
+        for (std::size_t i = 0; i < pairs; ++i)
+        {
+            queues.push_back(std::make_unique<TypeParam>(2));
+            [](TypeParam &q, manual_executor &executor, int &sum, int &count) -> detached_task
+            {
+                while (std::optional<int> item = co_await q.async_pop(executor.poster()))
+                {
+                    sum += *item;
+                    ++count;
+                }
+            }(*queues.back(), executor, sums[i], counts[i]);
+            [](TypeParam &q, manual_executor &executor) -> detached_task
+            {
+                for (int v = 1; v <= items; ++v)
+                {
+                    if (!co_await q.async_push(v, executor.poster()))
+                    {
+                        co_return;
+                    }
+                }
+                q.close();
+            }(*queues.back(), executor);
+        }
+
+        while (executor.run_pending() != 0)
+        {
+        }
+
+        for (std::size_t i = 0; i < pairs; ++i)
+        {
+            EXPECT_EQ(counts[i], items);
+            EXPECT_EQ(sums[i], items * (items + 1) / 2);
+            EXPECT_TRUE(queues[i]->done());
+        }
+    }
+
+    TYPED_TEST(AsyncQueueTest, CrossThreadFunctionalTestWithEventLoops)
+    {
+        constexpr int items = 50000;
+
+        TypeParam q(8);
+        event_loop producer_loop;
+        event_loop consumer_loop;
+        int expected = 0;
+        bool in_order = true;
+
+        std::jthread producer([&]
+                              {
+            [](TypeParam &q, event_loop &loop) -> detached_task
+            {
+                for (int i = 0; i < items; ++i)
+                {
+                    if (!co_await q.async_push(i, loop.poster()))
+                    {
+                        break;
+                    }
+                }
+                q.close();
+                loop.stop();
+            }(q, producer_loop);
+            producer_loop.run(); });
+
+        [](TypeParam &q, event_loop &loop, int &expected, bool &in_order) -> detached_task
+        {
+            while (std::optional<int> item = co_await q.async_pop(loop.poster()))
+            {
+                in_order = in_order && *item == expected;
+                ++expected;
+            }
+            loop.stop();
+        }(q, consumer_loop, expected, in_order);
+        consumer_loop.run();
+        producer.join();
+
+        EXPECT_TRUE(in_order);
+        EXPECT_EQ(expected, items);
+    }
+} // namespace
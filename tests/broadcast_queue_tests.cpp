@@ -0,0 +1,343 @@
+#include "broadcast_queue.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr auto timeout = std::chrono::seconds(2);
+
+    // Throws from its constructor when built from a negative value.
+    struct Fragile
+    {
+        explicit Fragile(int v) : value(std::make_shared<int>(v))
+        {
+            if (v < 0)
+            {
+                throw std::runtime_error("negative");
+            }
+        }
+
+        std::shared_ptr<int> value;
+    };
+
+    TEST(BroadcastQueueTest, CapacityAndReaderCountMustBePositive)
+    {
+        EXPECT_THROW(broadcast_queue<int>(0, 1), std::invalid_argument);
+        EXPECT_THROW(broadcast_queue<int>(4, 0), std::invalid_argument);
+
+        broadcast_queue<int> q(4, 2);
+        EXPECT_EQ(q.capacity(), 4U);
+        EXPECT_EQ(q.readers(), 2U);
+        EXPECT_THROW(q.get_reader(2), std::invalid_argument);
+    }
+
+    TEST(BroadcastQueueTest, EveryReaderSeesEveryItemInOrder)
+    {
+        broadcast_queue<std::string> q(8, 3);
+        for (int i = 0; i < 5; ++i)
+        {
+            ASSERT_TRUE(q.try_push(std::to_string(i)));
+        }
+
+        for (std::size_t r = 0; r < q.readers(); ++r)
+        {
+            auto reader = q.get_reader(r);
+            EXPECT_EQ(reader.size(), 5U);
+            for (int i = 0; i < 5; ++i)
+            {
+                EXPECT_EQ(reader.try_pop(), std::to_string(i));
+            }
+            EXPECT_FALSE(reader.try_pop().has_value());
+            EXPECT_EQ(reader.size(), 0U);
+        }
+        EXPECT_EQ(q.size(), 0U);
+    }
+
+    TEST(BroadcastQueueTest, SlowestReaderBoundsTheProducer)
+    {
+        broadcast_queue<int> q(3, 2);
+        auto fast = q.get_reader(0);
+        auto slow = q.get_reader(1);
+
+        for (int i = 0; i < 3; ++i)
+        {
+            ASSERT_TRUE(q.try_push(i));
+        }
+        EXPECT_FALSE(q.try_push(3));
+
+        // The fast reader catching up frees nothing while the slow one has not moved.
+        for (int i = 0; i < 3; ++i)
+        {
+            ASSERT_EQ(fast.try_pop(), i);
+        }
+        EXPECT_FALSE(q.try_push(3));
+        EXPECT_EQ(q.size(), 3U);
+
+        ASSERT_EQ(slow.try_pop(), 0);
+        EXPECT_TRUE(q.try_push(3));
+        EXPECT_FALSE(q.try_push(4));
+        EXPECT_EQ(fast.try_pop(), 3);
+        EXPECT_EQ(slow.size(), 3U);
+    }
+
+    TEST(BroadcastQueueTest, FrontAndTryConsumeReadInPlace)
+    {
+        broadcast_queue<std::vector<int>> q(4, 2);
+        auto a = q.get_reader(0);
+        auto b = q.get_reader(1);
+        EXPECT_EQ(a.front(), nullptr);
+        ASSERT_TRUE(q.try_emplace(3, 7));
+
+        const std::vector<int> *seen_by_a = a.front();
+        ASSERT_NE(seen_by_a, nullptr);
+        EXPECT_EQ(*seen_by_a, (std::vector<int>{7, 7, 7}));
+        a.pop_front();
+        EXPECT_EQ(a.front(), nullptr);
+
+        // Both readers read the same slot; nothing is copied.
+        EXPECT_TRUE(b.try_consume([&](const std::vector<int> &v)
+                                  { EXPECT_EQ(&v, seen_by_a); }));
+        EXPECT_FALSE(b.try_consume([](const std::vector<int> &) {}));
+    }
+
+    TEST(BroadcastQueueTest, BulkPushPopWrapAroundTheRing)
+    {
+        broadcast_queue<int> q(4, 2);
+        auto a = q.get_reader(0);
+        auto b = q.get_reader(1);
+
+        std::vector<int> in{0, 1, 2, 3, 4, 5};
+        std::vector<int> out_a;
+        std::vector<int> out_b;
+        for (int lap = 0; lap < 3; ++lap)
+        {
+            EXPECT_EQ(q.try_push_n(in.begin(), in.end()), 4U);
+            EXPECT_EQ(a.try_pop_n(std::back_inserter(out_a), 3), 3U);
+            EXPECT_EQ(q.try_push_n(in.begin(), in.end()), 0U);
+            EXPECT_EQ(b.pop_n(std::back_inserter(out_b), 10), 4U);
+            EXPECT_EQ(a.pop_n(std::back_inserter(out_a), 10), 1U);
+        }
+        EXPECT_EQ(out_a, (std::vector<int>{0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3}));
+        EXPECT_EQ(out_b, out_a);
+    }
+
+    TEST(BroadcastQueueTest, CloseLetsEachReaderDrainIndependently)
+    {
+        broadcast_queue<int> q(4, 2);
+        auto a = q.get_reader(0);
+        auto b = q.get_reader(1);
+        ASSERT_TRUE(q.push(1));
+        ASSERT_TRUE(q.push(2));
+        q.close();
+
+        EXPECT_TRUE(q.closed());
+        EXPECT_FALSE(q.try_push(3));
+        EXPECT_FALSE(q.push(3));
+        const int more[] = {3, 4};
+        EXPECT_EQ(q.push_n(std::begin(more), std::end(more)), 0U);
+
+        EXPECT_EQ(a.pop(), 1);
+        EXPECT_EQ(a.pop(), 2);
+        EXPECT_TRUE(a.done());
+        EXPECT_FALSE(a.pop().has_value());
+
+        EXPECT_FALSE(b.done());
+        EXPECT_EQ(b.pop(), 1);
+        EXPECT_FALSE(b.done());
+        EXPECT_EQ(b.pop(), 2);
+        EXPECT_TRUE(b.done());
+        std::vector<int> out;
+        EXPECT_EQ(b.pop_n(std::back_inserter(out), 4), 0U);
+    }
+
+    TEST(BroadcastQueueTest, TimedOperationsTimeOut)
+    {
+        broadcast_queue<int> q(1, 2);
+        auto reader = q.get_reader(1);
+        auto start = std::chrono::steady_clock::now();
+        EXPECT_FALSE(reader.pop_for(std::chrono::milliseconds(20)).has_value());
+        EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+
+        ASSERT_TRUE(q.push(1));
+        start = std::chrono::steady_clock::now();
+        EXPECT_FALSE(q.push_for(2, std::chrono::milliseconds(20)));
+        EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+        EXPECT_FALSE(q.push_until(2, std::chrono::steady_clock::now() + std::chrono::milliseconds(5)));
+    }
+
+    TEST(BroadcastQueueTest, ParkedReadersAreAllWokenByPushAndClose)
+    {
+        broadcast_queue<int, park_wait<>> q(4, 3);
+
+        std::vector<std::future<std::optional<int>>> readers;
+        for (std::size_t r = 0; r < q.readers(); ++r)
+        {
+            readers.push_back(std::async(std::launch::async, [reader = q.get_reader(r)]() mutable
+                                         { return reader.pop(); }));
+        }
+        EXPECT_EQ(readers[0].wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+        ASSERT_TRUE(q.push(7));
+        for (auto &reader : readers)
+        {
+            ASSERT_EQ(reader.wait_for(timeout), std::future_status::ready);
+            EXPECT_EQ(reader.get(), 7);
+        }
+
+        readers.clear();
+        for (std::size_t r = 0; r < q.readers(); ++r)
+        {
+            readers.push_back(std::async(std::launch::async, [reader = q.get_reader(r)]() mutable
+                                         { return reader.pop(); }));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        q.close();
+        for (auto &reader : readers)
+        {
+            ASSERT_EQ(reader.wait_for(timeout), std::future_status::ready);
+            EXPECT_FALSE(reader.get().has_value());
+        }
+    }
+
+    TEST(BroadcastQueueTest, ParkedProducerIsWokenBySlowestReader)
+    {
+        broadcast_queue<int, park_wait<>> q(1, 2);
+        auto a = q.get_reader(0);
+        auto b = q.get_reader(1);
+        ASSERT_TRUE(q.push(1));
+
+        auto producer = std::async(std::launch::async, [&]
+                                   { return q.push(2); });
+        ASSERT_EQ(a.try_pop(), 1);
+        EXPECT_EQ(producer.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+        ASSERT_EQ(b.try_pop(), 1);
+        ASSERT_EQ(producer.wait_for(timeout), std::future_status::ready);
+        EXPECT_TRUE(producer.get());
+        EXPECT_EQ(a.try_pop(), 2);
+        EXPECT_EQ(b.try_pop(), 2);
+    }
+
+    TEST(BroadcastQueueTest, ItemsAreDestroyedOnReuseAndDestruction)
+    {
+        auto tracked = std::make_shared<int>(0);
+        {
+            broadcast_queue<std::shared_ptr<int>> q(2, 2);
+            auto a = q.get_reader(0);
+            auto b = q.get_reader(1);
+
+            // Read items stay in their slots until the producer comes back to them.
+            for (int i = 0; i < 2; ++i)
+            {
+                ASSERT_TRUE(q.try_push(tracked));
+                ASSERT_TRUE(a.try_pop().has_value());
+                ASSERT_TRUE(b.try_pop().has_value());
+            }
+            EXPECT_EQ(tracked.use_count(), 3);
+
+            ASSERT_TRUE(q.try_push(std::make_shared<int>(1)));
+            EXPECT_EQ(tracked.use_count(), 2);
+        }
+        EXPECT_EQ(tracked.use_count(), 1);
+    }
+
+    TEST(BroadcastQueueTest, ThrowingConstructorLeavesQueueUsable)
+    {
+        broadcast_queue<Fragile> q(2, 1);
+        auto reader = q.get_reader(0);
+        for (int i = 0; i < 2; ++i)
+        {
+            ASSERT_TRUE(q.try_emplace(i));
+            ASSERT_TRUE(reader.try_pop().has_value());
+        }
+
+        // The old item in the slot is already gone when the constructor throws.
+        EXPECT_THROW(q.try_emplace(-1), std::runtime_error);
+        EXPECT_EQ(q.size(), 0U);
+        ASSERT_TRUE(q.try_emplace(5));
+        ASSERT_TRUE(q.try_emplace(6));
+        EXPECT_EQ(*reader.try_pop()->value, 5);
+        EXPECT_EQ(*reader.try_pop()->value, 6);
+    }
+
+    template <class Queue>
+    void run_broadcast(std::size_t capacity, std::size_t reader_count)
+    {
+        constexpr int items = 100000;
+        Queue q(capacity, reader_count);
+
+        std::vector<std::future<int>> readers;
+        for (std::size_t r = 0; r < reader_count; ++r)
+        {
+            readers.push_back(std::async(std::launch::async, [reader = q.get_reader(r), r]() mutable
+                                         {
+                int expected = 0;
+                std::vector<int> out;
+                while (true)
+                {
+                    // Mix single reads and batches across readers.
+                    if (r % 2 == 0)
+                    {
+                        auto item = reader.pop();
+                        if (!item.has_value())
+                        {
+                            break;
+                        }
+                        EXPECT_EQ(*item, expected++);
+                        continue;
+                    }
+                    out.clear();
+                    if (reader.pop_n(std::back_inserter(out), 29) == 0)
+                    {
+                        break;
+                    }
+                    for (int v : out)
+                    {
+                        EXPECT_EQ(v, expected++);
+                    }
+                }
+                return expected; }));
+        }
+
+        std::vector<int> batch;
+        for (int i = 0; i < items;)
+        {
+            if (i % 1000 < 500)
+            {
+                ASSERT_TRUE(q.push(i++));
+                continue;
+            }
+            batch.clear();
+            for (int j = 0; j < 64 && i < items; ++j)
+            {
+                batch.push_back(i++);
+            }
+            ASSERT_EQ(q.push_n(batch.begin(), batch.end()), batch.size());
+        }
+        q.close();
+
+        for (auto &reader : readers)
+        {
+            EXPECT_EQ(reader.get(), items);
+        }
+    }
+
+    TEST(BroadcastQueueTest, ProducerReadersFunctionalTest)
+    {
+        run_broadcast<broadcast_queue<int>>(64, 3);
+    }
+
+    TEST(BroadcastQueueTest, ProducerReadersFunctionalTestWithParking)
+    {
+        run_broadcast<broadcast_queue<int, park_wait<>>>(4, 4);
+    }
+} // namespace
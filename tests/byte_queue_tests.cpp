@@ -0,0 +1,204 @@
+#include "atomic_spsc_byte_queue.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr auto timeout = std::chrono::seconds(2);
+
+    // A helper function to create a record of the given size with content derived from seed.
+    std::vector<std::byte> make_record(std::size_t size, int seed)
+    {
+        std::vector<std::byte> record(size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            record[i] = static_cast<std::byte>(seed + static_cast<int>(i));
+        }
+        return record;
+    }
+
+    std::vector<std::byte> to_vector(std::span<const std::byte> record)
+    {
+        return {record.begin(), record.end()};
+    }
+
+    TEST(AtomicSpscByteQueueTest, CapacityMustBePositive)
+    {
+        EXPECT_THROW(atomic_spsc_byte_queue(0), std::invalid_argument);
+    }
+
+    TEST(AtomicSpscByteQueueTest, CapacityIsRoundedUpToPowerOfTwo)
+    {
+        atomic_spsc_byte_queue q(100);
+        EXPECT_EQ(q.capacity(), 128U);
+        EXPECT_EQ(q.max_record_size(), 56U);
+    }
+
+    TEST(AtomicSpscByteQueueTest, ReserveThrowsForOversizedRecord)
+    {
+        atomic_spsc_byte_queue q(64);
+        EXPECT_THROW(q.reserve(q.max_record_size() + 1), std::invalid_argument);
+    }
+
+    TEST(AtomicSpscByteQueueTest, ReadableIsEmptyWhenQueueIsEmpty)
+    {
+        atomic_spsc_byte_queue q(64);
+        EXPECT_EQ(q.readable().data(), nullptr);
+    }
+
+    TEST(AtomicSpscByteQueueTest, ReserveCommitReadableRelease)
+    {
+        atomic_spsc_byte_queue q(64);
+
+        auto out = q.reserve(10);
+        ASSERT_EQ(out.size(), 10U);
+        const auto expected = make_record(6, 1);
+        std::copy(expected.begin(), expected.end(), out.begin());
+
+        // Nothing is visible before commit(); the record may end up shorter than reserved.
+        EXPECT_EQ(q.readable().data(), nullptr);
+        q.commit(expected.size());
+
+        auto in = q.readable();
+        ASSERT_NE(in.data(), nullptr);
+        EXPECT_EQ(to_vector(in), expected);
+        q.release();
+
+        EXPECT_EQ(q.readable().data(), nullptr);
+    }
+
+    TEST(AtomicSpscByteQueueTest, PreservesVariableLengthRecordsInOrder)
+    {
+        atomic_spsc_byte_queue q(256);
+
+        const std::vector<std::size_t> sizes{0, 1, 7, 8, 9, 31};
+        for (std::size_t i = 0; i < sizes.size(); ++i)
+        {
+            ASSERT_TRUE(q.try_push(make_record(sizes[i], static_cast<int>(i))));
+        }
+
+        for (std::size_t i = 0; i < sizes.size(); ++i)
+        {
+            EXPECT_TRUE(q.try_consume([&](std::span<const std::byte> record)
+                                      { EXPECT_EQ(to_vector(record), make_record(sizes[i], static_cast<int>(i))); }));
+        }
+        EXPECT_FALSE(q.try_consume([](std::span<const std::byte>) {}));
+    }
+
+    TEST(AtomicSpscByteQueueTest, TryPushReturnsFalseWhenFull)
+    {
+        atomic_spsc_byte_queue q(64);
+
+        // Each 24-byte payload takes 32 bytes with its header.
+        EXPECT_TRUE(q.try_push(make_record(24, 1)));
+        EXPECT_TRUE(q.try_push(make_record(24, 2)));
+        EXPECT_FALSE(q.try_push(make_record(1, 3)));
+    }
+
+    TEST(AtomicSpscByteQueueTest, RecordThatDoesNotFitBeforeEndWrapsToStart)
+    {
+        atomic_spsc_byte_queue q(64);
+
+        ASSERT_TRUE(q.try_push(make_record(16, 1)));
+        ASSERT_TRUE(q.try_push(make_record(16, 2)));
+        ASSERT_TRUE(q.try_consume([](std::span<const std::byte>) {}));
+        ASSERT_TRUE(q.try_consume([](std::span<const std::byte>) {}));
+
+        // 16 bytes are left before the end of the ring, so a 24-byte payload is placed at the start.
+        ASSERT_TRUE(q.try_push(make_record(24, 3)));
+        ASSERT_TRUE(q.try_push(make_record(8, 4)));
+
+        auto first = q.readable();
+        EXPECT_EQ(to_vector(first), make_record(24, 3));
+        q.release();
+
+        auto second = q.readable();
+        EXPECT_EQ(to_vector(second), make_record(8, 4));
+        q.release();
+
+        EXPECT_EQ(q.readable().data(), nullptr);
+    }
+
+    TEST(AtomicSpscByteQueueTest, CloseStopsProducerAndDoneReportsDrained)
+    {
+        atomic_spsc_byte_queue q(64);
+
+        ASSERT_TRUE(q.try_push(make_record(4, 1)));
+        q.close();
+
+        EXPECT_TRUE(q.closed());
+        EXPECT_EQ(q.reserve(4).data(), nullptr);
+        EXPECT_FALSE(q.push(make_record(4, 2)));
+        EXPECT_FALSE(q.done());
+
+        EXPECT_TRUE(q.consume([](std::span<const std::byte>) {}));
+        EXPECT_TRUE(q.done());
+        EXPECT_FALSE(q.consume([](std::span<const std::byte>) {}));
+    }
+
+    TEST(AtomicSpscByteQueueTest, BlockingConsumeReturnsFalseAfterCloseDuringWait)
+    {
+        atomic_spsc_byte_queue q(64);
+
+        std::promise<void> started;
+        auto started_future = started.get_future();
+        auto consumer = std::async(std::launch::async, [&]
+                                   {
+            started.set_value();
+            return q.consume([](std::span<const std::byte>) {}); });
+
+        ASSERT_EQ(started_future.wait_for(timeout), std::future_status::ready);
+        q.close();
+
+        ASSERT_EQ(consumer.wait_for(timeout), std::future_status::ready);
+        EXPECT_FALSE(consumer.get());
+    }
+
+    TEST(AtomicSpscByteQueueTest, ProducerConsumerFunctionalTest)
+    {
+        constexpr int item_count = 1000;
+
+        atomic_spsc_byte_queue q(256);
+        std::atomic<bool> producer_ok{true};
+        std::vector<std::vector<std::byte>> consumed;
+        consumed.reserve(item_count);
+
+        std::jthread producer([&]
+                              {
+            for (int i = 0; i < item_count; ++i)
+            {
+                if (!q.push(make_record(static_cast<std::size_t>(i % 61), i)))
+                {
+                    producer_ok.store(false, std::memory_order_relaxed);
+                    break;
+                }
+            }
+            q.close(); });
+
+        std::jthread consumer([&]
+                              {
+            while (q.consume([&](std::span<const std::byte> record)
+                             { consumed.push_back(to_vector(record)); })) {} });
+
+        producer.join();
+        consumer.join();
+
+        ASSERT_TRUE(producer_ok.load(std::memory_order_relaxed));
+        ASSERT_EQ(static_cast<int>(consumed.size()), item_count);
+
+        for (int i = 0; i < item_count; ++i)
+        {
+            EXPECT_EQ(consumed[i], make_record(static_cast<std::size_t>(i % 61), i));
+        }
+    }
+} // namespace
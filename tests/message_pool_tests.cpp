@@ -0,0 +1,152 @@
+#include "atomic_spsc_queue.hpp"
+#include "message_pool.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr auto timeout = std::chrono::seconds(2);
+
+    using vector_pool = message_pool<std::vector<int>>;
+
+    TEST(MessagePoolTest, CountMustBePositive)
+    {
+        EXPECT_THROW(vector_pool(0), std::invalid_argument);
+    }
+
+    TEST(MessagePoolTest, EveryBufferIsAvailableAfterConstruction)
+    {
+        vector_pool pool(4);
+        EXPECT_EQ(pool.size(), 4U);
+        EXPECT_EQ(pool.available(), 4U);
+    }
+
+    TEST(MessagePoolTest, FactoryCreatesEveryBuffer)
+    {
+        int calls = 0;
+        vector_pool pool(3, [&]
+                         {
+            ++calls;
+            std::vector<int> v;
+            v.reserve(16);
+            return v; });
+
+        EXPECT_EQ(calls, 3);
+        for (vector_pool::handle h = 0; h < 3; ++h)
+        {
+            EXPECT_GE(pool[h].capacity(), 16U);
+        }
+    }
+
+    TEST(MessagePoolTest, AcquireHandsOutDistinctBuffersUntilExhausted)
+    {
+        vector_pool pool(3);
+        std::set<vector_pool::handle> handles;
+        for (int i = 0; i < 3; ++i)
+        {
+            const std::optional<vector_pool::handle> h = pool.try_acquire();
+            ASSERT_TRUE(h.has_value());
+            handles.insert(*h);
+        }
+
+        EXPECT_EQ(handles.size(), 3U);
+        EXPECT_FALSE(pool.try_acquire().has_value());
+        EXPECT_EQ(pool.available(), 0U);
+    }
+
+    TEST(MessagePoolTest, ReleasedBufferIsReusedWithItsContents)
+    {
+        vector_pool pool(1);
+        const std::optional<vector_pool::handle> h = pool.try_acquire();
+        ASSERT_TRUE(h.has_value());
+        pool[*h].assign({1, 2, 3});
+        const int *data = pool[*h].data();
+
+        pool.release(*h);
+        const std::optional<vector_pool::handle> again = pool.try_acquire();
+        ASSERT_TRUE(again.has_value());
+        EXPECT_EQ(*again, *h);
+        EXPECT_EQ(pool[*again].data(), data);
+        EXPECT_EQ(pool[*again], (std::vector<int>{1, 2, 3}));
+    }
+
+    TEST(MessagePoolTest, BlockingAcquireWaitsForRelease)
+    {
+        vector_pool pool(1);
+        const std::optional<vector_pool::handle> h = pool.try_acquire();
+        ASSERT_TRUE(h.has_value());
+
+        auto producer = std::async(std::launch::async, [&]
+                                   { return pool.acquire(); });
+        EXPECT_EQ(producer.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+
+        pool.release(*h);
+        ASSERT_EQ(producer.wait_for(timeout), std::future_status::ready);
+        EXPECT_EQ(producer.get(), h);
+    }
+
+    TEST(MessagePoolTest, CloseWakesBlockedAcquire)
+    {
+        vector_pool pool(1);
+        ASSERT_TRUE(pool.try_acquire().has_value());
+
+        auto producer = std::async(std::launch::async, [&]
+                                   { return pool.acquire(); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        pool.close();
+
+        ASSERT_EQ(producer.wait_for(timeout), std::future_status::ready);
+        EXPECT_FALSE(producer.get().has_value());
+        EXPECT_TRUE(pool.closed());
+    }
+
+    TEST(MessagePoolTest, FunctionalTestPassesHandlesThroughQueue)
+    {
+        constexpr std::size_t capacity = 8;
+        constexpr int items = 20000;
+        constexpr std::size_t length = 16;
+
+        vector_pool pool(capacity + 2, [&]
+                         { return std::vector<int>(length); });
+        atomic_spsc_queue<vector_pool::handle> q(capacity);
+
+        std::jthread producer([&]
+                              {
+            for (int i = 0; i < items; ++i)
+            {
+                const std::optional<vector_pool::handle> h = pool.acquire();
+                ASSERT_TRUE(h.has_value());
+                std::vector<int> &buffer = pool[*h];
+                for (std::size_t j = 0; j < length; ++j)
+                {
+                    buffer[j] = i + static_cast<int>(j);
+                }
+                ASSERT_TRUE(q.push(*h));
+            }
+            q.close(); });
+
+        int expected = 0;
+        while (const std::optional<vector_pool::handle> h = q.pop())
+        {
+            const std::vector<int> &buffer = pool[*h];
+            ASSERT_EQ(buffer.size(), length);
+            for (std::size_t j = 0; j < length; ++j)
+            {
+                ASSERT_EQ(buffer[j], expected + static_cast<int>(j));
+            }
+            pool.release(*h);
+            ++expected;
+        }
+
+        EXPECT_EQ(expected, items);
+    }
+} // namespace
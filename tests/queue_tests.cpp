@@ -1,11 +1,23 @@
 #include "atomic_spsc_queue.hpp"
+#include "mmap_allocator.hpp"
+#include "mpmc_queue.hpp"
+#include "shm_spsc_queue.hpp"
 #include "simple_spsc_queue.hpp"
+#include "slot_spsc_queue.hpp"
+#include "static_spsc_queue.hpp"
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <future>
+#include <iterator>
 #include <optional>
+#include <span>
 #include <stdexcept>
+#include <thread>
 #include <type_traits>
 #include <vector>
 
@@ -33,11 +45,69 @@ namespace
         }
     }
 
+    // A helper function to construct sample values in place from constructor arguments.
+    template <class QueueType>
+    bool emplace_queue_value(QueueType &q, int seed)
+    {
+        using Value = queue_value_t<QueueType>;
+        if constexpr (std::is_same_v<Value, int>)
+        {
+            return q.try_emplace(seed);
+        }
+        else
+        {
+            const int values[] = {seed, seed + 1, seed + 2};
+            return q.try_emplace(std::begin(values), std::end(values));
+        }
+    }
+
     using QueueImplementations = ::testing::Types<
         simple_spsc_queue<int>,
         atomic_spsc_queue<int>,
+        atomic_spsc_queue<int, pow2_index_policy>,
+        atomic_spsc_queue<int, modulo_index_policy, park_wait<>>,
+        atomic_spsc_queue<int, modulo_index_policy, condvar_wait<>>,
+        atomic_spsc_queue<int, modulo_index_policy, busy_spin_wait>,
+        atomic_spsc_queue<int, modulo_index_policy, backoff_wait<>>,
+        // Pauses stop growing below deadline_check_interval, so timed operations must still time out.
+        atomic_spsc_queue<int, modulo_index_policy, backoff_wait<4>>,
+        atomic_spsc_queue<int, modulo_index_policy, yield_wait>,
+        atomic_spsc_queue<int, modulo_index_policy, sleep_wait<>>,
+        atomic_spsc_queue<int, modulo_index_policy, spin_yield_wait, mmap_allocator<int>>,
+        atomic_spsc_queue<int, modulo_index_policy, spin_yield_wait, std::allocator<int>, queue_stats>,
+        mpsc_queue<int>,
+        mpmc_queue<int>,
+        mpmc_queue<int, busy_spin_wait>,
+        shm_spsc_queue<int>,
+        slot_spsc_queue<int>,
+        slot_spsc_queue<int, park_wait<>>,
+        slot_spsc_queue<int, spin_yield_wait, alignof(int)>,
+        // Inline ring with a runtime capacity; static_spsc_queue (fixed capacity) is tested below.
+        atomic_spsc_queue<int, pow2_index_policy, spin_yield_wait, inline_storage<int, 64>>,
+        atomic_spsc_queue<int, pow2_index_policy, park_wait<>, inline_storage<int, 64>>,
         simple_spsc_queue<std::vector<int>>,
-        atomic_spsc_queue<std::vector<int>>>;
+        atomic_spsc_queue<std::vector<int>>,
+        atomic_spsc_queue<std::vector<int>, pow2_index_policy>,
+        atomic_spsc_queue<std::vector<int>, modulo_index_policy, park_wait<>>,
+        atomic_spsc_queue<std::vector<int>, modulo_index_policy, condvar_wait<>>,
+        slot_spsc_queue<std::vector<int>>,
+        atomic_spsc_queue<std::vector<int>, pow2_index_policy, spin_yield_wait, inline_storage<std::vector<int>, 64>>,
+        mpsc_queue<std::vector<int>>,
+        mpmc_queue<std::vector<int>>>;
+
+    // front()/pop_front() need a single consumer, so mpmc_queue does not have them.
+    template <class QueueType>
+    concept has_front = requires(QueueType &q) {
+        q.front();
+        q.pop_front();
+    };
+
+    // Batched in-place consumption, offered by the index-based SPSC queues.
+    template <class QueueType>
+    concept has_consume_all = requires(QueueType &q) {
+        q.consume_all([](queue_value_t<QueueType> &) {});
+        q.consume_up_to(std::size_t{1}, [](queue_value_t<QueueType> &) {});
+    };
 
     template <class QueueType>
     class SpscQueueTest : public ::testing::Test
@@ -65,6 +135,21 @@ namespace
         EXPECT_EQ(q.capacity(), 7U);
     }
 
+    TYPED_TEST(SpscQueueTest, SizeTracksPushesAndPops)
+    {
+        TypeParam q(3);
+        EXPECT_EQ(q.size(), 0U);
+
+        ASSERT_TRUE(q.try_push(make_queue_value<TypeParam>(1)));
+        ASSERT_TRUE(q.try_push(make_queue_value<TypeParam>(2)));
+        EXPECT_EQ(q.size(), 2U);
+        EXPECT_EQ(q.approx_size(), 2U);
+
+        ASSERT_TRUE(q.try_pop().has_value());
+        EXPECT_EQ(q.size(), 1U);
+        EXPECT_EQ(q.approx_size(), 1U);
+    }
+
     TYPED_TEST(SpscQueueTest, TryPushReturnsFalseWhenFull)
     {
         TypeParam q(2);
@@ -154,6 +239,353 @@ namespace
         EXPECT_EQ(*third, make_queue_value<TypeParam>(3));
     }
 
+    TYPED_TEST(SpscQueueTest, TryEmplaceConstructsItemsInOrder)
+    {
+        TypeParam q(2);
+
+        EXPECT_TRUE(emplace_queue_value(q, 1));
+        EXPECT_TRUE(emplace_queue_value(q, 2));
+        EXPECT_FALSE(emplace_queue_value(q, 3));
+
+        auto first = q.try_pop();
+        auto second = q.try_pop();
+
+        ASSERT_TRUE(first.has_value());
+        ASSERT_TRUE(second.has_value());
+        EXPECT_EQ(*first, make_queue_value<TypeParam>(1));
+        EXPECT_EQ(*second, make_queue_value<TypeParam>(2));
+    }
+
+    TYPED_TEST(SpscQueueTest, TryEmplaceReturnsFalseAfterClose)
+    {
+        TypeParam q(1);
+
+        q.close();
+
+        EXPECT_FALSE(emplace_queue_value(q, 42));
+    }
+
+    TYPED_TEST(SpscQueueTest, FrontReturnsNullptrWhenEmpty)
+    {
+        if constexpr (!has_front<TypeParam>)
+        {
+            GTEST_SKIP() << "no front() with several consumers";
+        }
+        else
+        {
+            TypeParam q(2);
+            EXPECT_EQ(q.front(), nullptr);
+        }
+    }
+
+    TYPED_TEST(SpscQueueTest, FrontAndPopFrontConsumeInOrder)
+    {
+        if constexpr (!has_front<TypeParam>)
+        {
+            GTEST_SKIP() << "no front() with several consumers";
+        }
+        else
+        {
+            TypeParam q(2);
+
+            ASSERT_TRUE(q.try_push(make_queue_value<TypeParam>(1)));
+            ASSERT_TRUE(q.try_push(make_queue_value<TypeParam>(2)));
+
+            auto *first = q.front();
+            ASSERT_NE(first, nullptr);
+            EXPECT_EQ(*first, make_queue_value<TypeParam>(1));
+            // front() does not remove the item.
+            EXPECT_EQ(q.front(), first);
+            q.pop_front();
+
+            auto *second = q.front();
+            ASSERT_NE(second, nullptr);
+            EXPECT_EQ(*second, make_queue_value<TypeParam>(2));
+            q.pop_front();
+
+            EXPECT_EQ(q.front(), nullptr);
+        }
+    }
+
+    TYPED_TEST(SpscQueueTest, TryConsumeReturnsFalseWhenEmpty)
+    {
+        TypeParam q(2);
+        bool invoked = false;
+
+        EXPECT_FALSE(q.try_consume([&](auto &)
+                                   { invoked = true; }));
+        EXPECT_FALSE(invoked);
+    }
+
+    TYPED_TEST(SpscQueueTest, TryConsumeReadsItemInPlaceAndFreesSlot)
+    {
+        TypeParam q(1);
+
+        ASSERT_TRUE(q.try_push(make_queue_value<TypeParam>(1)));
+        EXPECT_FALSE(q.try_push(make_queue_value<TypeParam>(2)));
+
+        const queue_value_t<TypeParam> *slot = nullptr;
+        if constexpr (has_front<TypeParam>)
+        {
+            slot = q.front();
+        }
+        EXPECT_TRUE(q.try_consume([&](auto &item)
+                                  {
+            if (slot != nullptr)
+            {
+                EXPECT_EQ(&item, slot);
+            }
+            EXPECT_EQ(item, make_queue_value<TypeParam>(1)); }));
+
+        EXPECT_TRUE(q.try_push(make_queue_value<TypeParam>(2)));
+        auto second = q.try_pop();
+        ASSERT_TRUE(second.has_value());
+        EXPECT_EQ(*second, make_queue_value<TypeParam>(2));
+    }
+
+    TYPED_TEST(SpscQueueTest, ConsumeAllDrainsItemsInPlaceInOrder)
+    {
+        if constexpr (!has_consume_all<TypeParam>)
+        {
+            GTEST_SKIP() << "no consume_all()";
+        }
+        else
+        {
+            using Value = queue_value_t<TypeParam>;
+            TypeParam q(4);
+            for (int i = 1; i <= 3; ++i)
+            {
+                ASSERT_TRUE(q.try_push(make_queue_value<TypeParam>(i)));
+            }
+
+            const Value *slot = nullptr;
+            if constexpr (has_front<TypeParam>)
+            {
+                slot = q.front();
+            }
+            std::vector<Value> seen;
+            EXPECT_EQ(q.consume_all([&](Value &item)
+                                    {
+                if (seen.empty() && slot != nullptr)
+                {
+                    EXPECT_EQ(&item, slot);
+                }
+                seen.push_back(item); }),
+                      3U);
+
+            ASSERT_EQ(seen.size(), 3U);
+            for (int i = 0; i < 3; ++i)
+            {
+                EXPECT_EQ(seen[i], make_queue_value<TypeParam>(i + 1));
+            }
+            EXPECT_EQ(q.size(), 0U);
+            EXPECT_EQ(q.consume_all([](Value &)
+                                    { ADD_FAILURE() << "invoked on an empty queue"; }),
+                      0U);
+        }
+    }
+
+    TYPED_TEST(SpscQueueTest, ConsumeUpToStopsAtMaxAndHandlesWrapAround)
+    {
+        if constexpr (!has_consume_all<TypeParam>)
+        {
+            GTEST_SKIP() << "no consume_up_to()";
+        }
+        else
+        {
+            using Value = queue_value_t<TypeParam>;
+            TypeParam q(4);
+            std::vector<Value> seen;
+            const auto collect = [&](Value &item)
+            { seen.push_back(item); };
+
+            for (int i = 1; i <= 3; ++i)
+            {
+                ASSERT_TRUE(q.try_push(make_queue_value<TypeParam>(i)));
+            }
+            EXPECT_EQ(q.consume_up_to(2, collect), 2U);
+            EXPECT_EQ(q.size(), 1U);
+
+            // The next batch wraps around the end of the ring.
+            for (int i = 4; i <= 6; ++i)
+            {
+                ASSERT_TRUE(q.try_push(make_queue_value<TypeParam>(i)));
+            }
+            EXPECT_EQ(q.consume_up_to(0, collect), 0U);
+            EXPECT_EQ(q.consume_up_to(10, collect), 4U);
+
+            ASSERT_EQ(seen.size(), 6U);
+            for (int i = 0; i < 6; ++i)
+            {
+                EXPECT_EQ(seen[i], make_queue_value<TypeParam>(i + 1));
+            }
+        }
+    }
+
+    TYPED_TEST(SpscQueueTest, ConsumeAllKeepsItemWhoseCallbackThrows)
+    {
+        if constexpr (!has_consume_all<TypeParam>)
+        {
+            GTEST_SKIP() << "no consume_all()";
+        }
+        else
+        {
+            using Value = queue_value_t<TypeParam>;
+            TypeParam q(4);
+            for (int i = 1; i <= 3; ++i)
+            {
+                ASSERT_TRUE(q.try_push(make_queue_value<TypeParam>(i)));
+            }
+
+            int calls = 0;
+            EXPECT_THROW(q.consume_all([&](Value &)
+                                       {
+                if (++calls == 2)
+                {
+                    throw std::runtime_error("consumer failed");
+                } }),
+                         std::runtime_error);
+
+            // The first item is released; the one whose callback threw is still at the head.
+            EXPECT_EQ(q.size(), 2U);
+            EXPECT_TRUE(q.try_push(make_queue_value<TypeParam>(4)));
+            EXPECT_TRUE(q.try_push(make_queue_value<TypeParam>(5)));
+            for (int i = 2; i <= 5; ++i)
+            {
+                auto value = q.try_pop();
+                ASSERT_TRUE(value.has_value());
+                EXPECT_EQ(*value, make_queue_value<TypeParam>(i));
+            }
+        }
+    }
+
+    TYPED_TEST(SpscQueueTest, TryPushNPushesOnlyWhatFits)
+    {
+        using Value = queue_value_t<TypeParam>;
+        TypeParam q(3);
+
+        std::vector<Value> items;
+        for (int i = 1; i <= 5; ++i)
+        {
+            items.push_back(make_queue_value<TypeParam>(i));
+        }
+
+        EXPECT_EQ(q.try_push_n(items.begin(), items.end()), 3U);
+        EXPECT_EQ(q.try_push_n(items.begin(), items.end()), 0U);
+
+        for (int i = 1; i <= 3; ++i)
+        {
+            auto value = q.try_pop();
+            ASSERT_TRUE(value.has_value());
+            EXPECT_EQ(*value, make_queue_value<TypeParam>(i));
+        }
+        EXPECT_FALSE(q.try_pop().has_value());
+    }
+
+    TYPED_TEST(SpscQueueTest, TryPushNReturnsZeroAfterClose)
+    {
+        using Value = queue_value_t<TypeParam>;
+        TypeParam q(2);
+        std::vector<Value> items{make_queue_value<TypeParam>(1)};
+
+        q.close();
+
+        EXPECT_EQ(q.try_push_n(items.begin(), items.end()), 0U);
+    }
+
+    TYPED_TEST(SpscQueueTest, TryPopNPopsUpToMax)
+    {
+        using Value = queue_value_t<TypeParam>;
+        TypeParam q(3);
+
+        for (int i = 1; i <= 3; ++i)
+        {
+            ASSERT_TRUE(q.try_push(make_queue_value<TypeParam>(i)));
+        }
+
+        std::vector<Value> out;
+        EXPECT_EQ(q.try_pop_n(std::back_inserter(out), 2), 2U);
+        EXPECT_EQ(q.try_pop_n(std::back_inserter(out), 2), 1U);
+        EXPECT_EQ(q.try_pop_n(std::back_inserter(out), 2), 0U);
+
+        ASSERT_EQ(out.size(), 3U);
+        for (int i = 0; i < 3; ++i)
+        {
+            EXPECT_EQ(out[i], make_queue_value<TypeParam>(i + 1));
+        }
+    }
+
+    TYPED_TEST(SpscQueueTest, BulkPushPopHandlesWrapAround)
+    {
+        using Value = queue_value_t<TypeParam>;
+        TypeParam q(4);
+
+        std::vector<Value> items;
+        for (int i = 1; i <= 6; ++i)
+        {
+            items.push_back(make_queue_value<TypeParam>(i));
+        }
+
+        // Move the indices close to the end of the ring, then push a batch that wraps around.
+        ASSERT_EQ(q.try_push_n(items.begin(), items.begin() + 3), 3U);
+        std::vector<Value> out;
+        ASSERT_EQ(q.try_pop_n(std::back_inserter(out), 2), 2U);
+        ASSERT_EQ(q.try_push_n(items.begin() + 3, items.end()), 3U);
+        ASSERT_EQ(q.try_pop_n(std::back_inserter(out), 8), 4U);
+
+        EXPECT_EQ(out, items);
+    }
+
+    TYPED_TEST(SpscQueueTest, BlockingPopNWithZeroMaxReturnsAtOnceWhenEmpty)
+    {
+        using Value = queue_value_t<TypeParam>;
+        TypeParam q(1);
+        std::vector<Value> out;
+
+        auto popped = std::async(std::launch::async, [&]
+                                 { return q.pop_n(std::back_inserter(out), 0); });
+
+        const auto status = popped.wait_for(timeout);
+        // Unblocks pop_n() if it waited anyway, so a failure does not hang the suite.
+        q.close();
+        ASSERT_EQ(status, std::future_status::ready);
+        EXPECT_EQ(popped.get(), 0U);
+        EXPECT_TRUE(out.empty());
+    }
+
+    TYPED_TEST(SpscQueueTest, BlockingPopNReturnsZeroAfterCloseWhenEmpty)
+    {
+        using Value = queue_value_t<TypeParam>;
+        TypeParam q(1);
+        std::vector<Value> out;
+
+        q.close();
+
+        EXPECT_EQ(q.pop_n(std::back_inserter(out), 4), 0U);
+    }
+
+    TYPED_TEST(SpscQueueTest, BlockingPushNReturnsPartialCountAfterCloseDuringWait)
+    {
+        using Value = queue_value_t<TypeParam>;
+        TypeParam q(1);
+        std::vector<Value> items{make_queue_value<TypeParam>(1), make_queue_value<TypeParam>(2)};
+
+        auto producer = std::async(std::launch::async, [&]
+                                   { return q.push_n(items.begin(), items.end()); });
+
+        // Close only once the first item is in, so the producer is blocked on the second one.
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (q.size() == 0 && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::yield();
+        }
+        ASSERT_EQ(q.size(), 1U);
+        q.close();
+
+        ASSERT_EQ(producer.wait_for(timeout), std::future_status::ready);
+        EXPECT_EQ(producer.get(), 1U);
+    }
+
     TYPED_TEST(SpscQueueTest, BlockingPushReturnsFalseAfterClose)
     {
         TypeParam q(1);
@@ -341,55 +773,218 @@ namespace
         EXPECT_FALSE(producer.get());
     }
 
-    TYPED_TEST(SpscQueueTest, BlockingProducerConsumerFunctionalTest)
+    constexpr auto short_timeout = std::chrono::milliseconds(20);
+
+    TYPED_TEST(SpscQueueTest, PushForTimesOutWhenFull)
     {
-        constexpr int item_count = 1000;
-        using Value = queue_value_t<TypeParam>;
+        TypeParam q(1);
+        ASSERT_TRUE(q.push(make_queue_value<TypeParam>(1)));
 
-        TypeParam q(64);
-        std::atomic<bool> producer_ok{true};
-        std::vector<Value> consumed;
-        consumed.reserve(item_count);
+        const auto start = std::chrono::steady_clock::now();
+        EXPECT_FALSE(q.push_for(make_queue_value<TypeParam>(2), short_timeout));
+        EXPECT_GE(std::chrono::steady_clock::now() - start, short_timeout);
 
-        std::jthread producer([&]
-                              {
-            for (int i = 0; i < item_count; ++i)
-            {
-                if (!q.push(make_queue_value<TypeParam>(i)))
-                {
-                    producer_ok.store(false, std::memory_order_relaxed);
-                    q.close();
-                    return;
-                }
-            }
-            q.close(); });
+        auto value = q.try_pop();
+        ASSERT_TRUE(value.has_value());
+        EXPECT_EQ(*value, make_queue_value<TypeParam>(1));
+        EXPECT_FALSE(q.try_pop().has_value());
+    }
 
-        std::jthread consumer([&]
-                              {
-            auto value = q.pop();
-            while (value.has_value()) {
-                consumed.push_back(*value);
-                value = q.pop();
-            } });
+    TYPED_TEST(SpscQueueTest, PushUntilTimesOutWhenFull)
+    {
+        TypeParam q(1);
+        ASSERT_TRUE(q.push(make_queue_value<TypeParam>(1)));
 
-        producer.join();
-        consumer.join();
+        const auto deadline = std::chrono::steady_clock::now() + short_timeout;
+        EXPECT_FALSE(q.push_until(make_queue_value<TypeParam>(2), deadline));
+        EXPECT_GE(std::chrono::steady_clock::now(), deadline);
+    }
 
-        ASSERT_TRUE(producer_ok.load(std::memory_order_relaxed));
-        ASSERT_EQ(static_cast<int>(consumed.size()), item_count);
+    TYPED_TEST(SpscQueueTest, PushForSucceedsWhenSpaceAvailable)
+    {
+        TypeParam q(1);
 
-        for (int i = 0; i < item_count; ++i)
-        {
-            EXPECT_EQ(consumed[i], make_queue_value<TypeParam>(i));
-        }
+        EXPECT_TRUE(q.push_for(make_queue_value<TypeParam>(1), short_timeout));
+
+        auto value = q.try_pop();
+        ASSERT_TRUE(value.has_value());
+        EXPECT_EQ(*value, make_queue_value<TypeParam>(1));
     }
 
-    TYPED_TEST(SpscQueueTest, NonblockingProducerConsumerFunctionalTest)
+    TYPED_TEST(SpscQueueTest, PushForReturnsFalseAfterClose)
     {
-        constexpr int item_count = 1000;
-        using Value = queue_value_t<TypeParam>;
+        TypeParam q(1);
 
-        TypeParam q(64);
+        q.close();
+
+        EXPECT_FALSE(q.push_for(make_queue_value<TypeParam>(1), timeout));
+    }
+
+    TYPED_TEST(SpscQueueTest, PopForTimesOutWhenEmpty)
+    {
+        TypeParam q(1);
+
+        const auto start = std::chrono::steady_clock::now();
+        EXPECT_FALSE(q.pop_for(short_timeout).has_value());
+        EXPECT_GE(std::chrono::steady_clock::now() - start, short_timeout);
+    }
+
+    TYPED_TEST(SpscQueueTest, PopUntilTimesOutWhenEmpty)
+    {
+        TypeParam q(1);
+
+        const auto deadline = std::chrono::system_clock::now() + short_timeout;
+        EXPECT_FALSE(q.pop_until(deadline).has_value());
+        EXPECT_GE(std::chrono::system_clock::now(), deadline);
+    }
+
+    TYPED_TEST(SpscQueueTest, PopForReturnsNulloptAfterCloseWhenEmpty)
+    {
+        TypeParam q(1);
+
+        q.close();
+
+        const auto start = std::chrono::steady_clock::now();
+        EXPECT_FALSE(q.pop_for(timeout).has_value());
+        EXPECT_LT(std::chrono::steady_clock::now() - start, timeout);
+    }
+
+    TYPED_TEST(SpscQueueTest, PopForUnblocksWhenItemArrives)
+    {
+        TypeParam q(1);
+
+        std::promise<void> started;
+        auto started_future = started.get_future();
+        auto consumer = std::async(std::launch::async, [&]
+                                   {
+            started.set_value();
+            return q.pop_for(timeout); });
+
+        ASSERT_EQ(started_future.wait_for(timeout), std::future_status::ready);
+        ASSERT_TRUE(q.push(make_queue_value<TypeParam>(42)));
+        ASSERT_EQ(consumer.wait_for(timeout), std::future_status::ready);
+
+        auto value = consumer.get();
+        ASSERT_TRUE(value.has_value());
+        EXPECT_EQ(*value, make_queue_value<TypeParam>(42));
+    }
+
+    TYPED_TEST(SpscQueueTest, PushForUnblocksWhenSpaceAvailable)
+    {
+        TypeParam q(1);
+        ASSERT_TRUE(q.push(make_queue_value<TypeParam>(1)));
+
+        std::promise<void> started;
+        auto started_future = started.get_future();
+        auto producer = std::async(std::launch::async, [&]
+                                   {
+            started.set_value();
+            return q.push_for(make_queue_value<TypeParam>(2), timeout); });
+
+        ASSERT_EQ(started_future.wait_for(timeout), std::future_status::ready);
+        ASSERT_TRUE(q.pop().has_value());
+        ASSERT_EQ(producer.wait_for(timeout), std::future_status::ready);
+        EXPECT_TRUE(producer.get());
+
+        auto value = q.try_pop();
+        ASSERT_TRUE(value.has_value());
+        EXPECT_EQ(*value, make_queue_value<TypeParam>(2));
+    }
+
+    TYPED_TEST(SpscQueueTest, BlockingProducerConsumerFunctionalTest)
+    {
+        constexpr int item_count = 1000;
+        using Value = queue_value_t<TypeParam>;
+
+        TypeParam q(64);
+        std::atomic<bool> producer_ok{true};
+        std::vector<Value> consumed;
+        consumed.reserve(item_count);
+
+        std::jthread producer([&]
+                              {
+            for (int i = 0; i < item_count; ++i)
+            {
+                if (!q.push(make_queue_value<TypeParam>(i)))
+                {
+                    producer_ok.store(false, std::memory_order_relaxed);
+                    q.close();
+                    return;
+                }
+            }
+            q.close(); });
+
+        std::jthread consumer([&]
+                              {
+            auto value = q.pop();
+            while (value.has_value()) {
+                consumed.push_back(*value);
+                value = q.pop();
+            } });
+
+        producer.join();
+        consumer.join();
+
+        ASSERT_TRUE(producer_ok.load(std::memory_order_relaxed));
+        ASSERT_EQ(static_cast<int>(consumed.size()), item_count);
+
+        for (int i = 0; i < item_count; ++i)
+        {
+            EXPECT_EQ(consumed[i], make_queue_value<TypeParam>(i));
+        }
+    }
+
+    TYPED_TEST(SpscQueueTest, BulkProducerConsumerFunctionalTest)
+    {
+        constexpr int item_count = 1000;
+        constexpr int batch = 7;
+        using Value = queue_value_t<TypeParam>;
+
+        TypeParam q(16);
+        std::atomic<bool> producer_ok{true};
+        std::vector<Value> consumed;
+        consumed.reserve(item_count);
+
+        std::jthread producer([&]
+                              {
+            std::vector<Value> items;
+            for (int i = 0; i < item_count; i += batch)
+            {
+                items.clear();
+                for (int j = i; j < std::min(i + batch, item_count); ++j)
+                {
+                    items.push_back(make_queue_value<TypeParam>(j));
+                }
+                if (q.push_n(items.begin(), items.end()) != items.size())
+                {
+                    producer_ok.store(false, std::memory_order_relaxed);
+                    break;
+                }
+            }
+            q.close(); });
+
+        std::jthread consumer([&]
+                              {
+            while (q.pop_n(std::back_inserter(consumed), batch) != 0) {} });
+
+        producer.join();
+        consumer.join();
+
+        ASSERT_TRUE(producer_ok.load(std::memory_order_relaxed));
+        ASSERT_EQ(static_cast<int>(consumed.size()), item_count);
+
+        for (int i = 0; i < item_count; ++i)
+        {
+            EXPECT_EQ(consumed[i], make_queue_value<TypeParam>(i));
+        }
+    }
+
+    TYPED_TEST(SpscQueueTest, NonblockingProducerConsumerFunctionalTest)
+    {
+        constexpr int item_count = 1000;
+        using Value = queue_value_t<TypeParam>;
+
+        TypeParam q(64);
         std::vector<Value> consumed;
         consumed.reserve(item_count);
 
@@ -427,4 +1022,1179 @@ namespace
             EXPECT_EQ(consumed[i], make_queue_value<TypeParam>(i));
         }
     }
+
+    // Payload without a default constructor that counts live instances.
+    struct Tracked
+    {
+        explicit Tracked(int v, int &live) : value(v), live(&live) { ++*this->live; }
+        Tracked(Tracked &&other) noexcept : value(other.value), live(other.live) { ++*live; }
+        Tracked &operator=(Tracked &&other) noexcept
+        {
+            value = other.value;
+            return *this;
+        }
+        ~Tracked() { --*live; }
+
+        int value;
+        int *live;
+    };
+
+    static_assert(!std::is_default_constructible_v<Tracked>);
+
+    TEST(AtomicSpscQueueStorageTest, ConstructionDoesNotCreateItems)
+    {
+        int live = 0;
+        atomic_spsc_queue<Tracked> q(16);
+        EXPECT_EQ(live, 0);
+    }
+
+    TEST(AtomicSpscQueueStorageTest, PopDestroysSlot)
+    {
+        int live = 0;
+        atomic_spsc_queue<Tracked> q(2);
+
+        ASSERT_TRUE(q.try_push(Tracked(1, live)));
+        ASSERT_TRUE(q.try_push(Tracked(2, live)));
+        EXPECT_EQ(live, 2);
+
+        {
+            auto first = q.try_pop();
+            ASSERT_TRUE(first.has_value());
+            EXPECT_EQ(first->value, 1);
+            EXPECT_EQ(live, 2);
+        }
+        EXPECT_EQ(live, 1);
+    }
+
+    TEST(AtomicSpscQueueStorageTest, DestructorDestroysRemainingItems)
+    {
+        int live = 0;
+        {
+            atomic_spsc_queue<Tracked, pow2_index_policy> q(3);
+            for (int i = 0; i < 5; ++i)
+            {
+                // Wrap the ring so remaining items straddle the buffer end.
+                ASSERT_TRUE(q.try_push(Tracked(i, live)));
+                if (i < 3)
+                {
+                    ASSERT_TRUE(q.try_pop().has_value());
+                }
+            }
+            EXPECT_EQ(live, 2);
+        }
+        EXPECT_EQ(live, 0);
+    }
+
+    // Allocator that records the size of every live allocation.
+    template <class T>
+    struct CountingAllocator
+    {
+        using value_type = T;
+
+        explicit CountingAllocator(std::vector<std::size_t> &sizes) : sizes(&sizes) {}
+
+        T *allocate(std::size_t n)
+        {
+            sizes->push_back(n);
+            return std::allocator<T>{}.allocate(n);
+        }
+
+        void deallocate(T *p, std::size_t n)
+        {
+            sizes->erase(std::find(sizes->begin(), sizes->end(), n));
+            std::allocator<T>{}.deallocate(p, n);
+        }
+
+        bool operator==(const CountingAllocator &) const = default;
+
+        std::vector<std::size_t> *sizes;
+    };
+
+    TEST(AtomicSpscQueueAllocatorTest, RingIsAllocatedAndFreedThroughAllocator)
+    {
+        std::vector<std::size_t> sizes;
+        {
+            atomic_spsc_queue<int, pow2_index_policy, spin_yield_wait, CountingAllocator<int>> q(
+                3, CountingAllocator<int>(sizes));
+
+            // One allocation of the whole ring, sized by the index policy.
+            ASSERT_EQ(sizes.size(), 1U);
+            EXPECT_EQ(sizes.front(), 4U);
+            EXPECT_TRUE(q.try_push(1));
+        }
+        EXPECT_TRUE(sizes.empty());
+    }
+
+    TEST(MmapAllocatorTest, AllocationsArePageAligned)
+    {
+        mmap_allocator<int> alloc;
+        int *p = alloc.allocate(3);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p) % mmap_allocator<int>::page_size(), 0U);
+        p[0] = 1;
+        p[2] = 3;
+        alloc.deallocate(p, 3);
+    }
+
+    TEST(MmapAllocatorTest, QueueWorksWithPrefaultedNodeBoundRing)
+    {
+        // Node 0 exists on every Linux system; binding is best effort either way.
+        using queue = atomic_spsc_queue<int, modulo_index_policy, spin_yield_wait, mmap_allocator<int>>;
+        queue q(5000, mmap_allocator<int>({.numa_node = 0, .prefault = true}));
+
+        EXPECT_EQ(q.get_allocator().options().numa_node, 0);
+        for (int i = 0; i < 5000; ++i)
+        {
+            ASSERT_TRUE(q.try_push(i));
+        }
+        for (int i = 0; i < 5000; ++i)
+        {
+            auto value = q.try_pop();
+            ASSERT_TRUE(value.has_value());
+            EXPECT_EQ(*value, i);
+        }
+    }
+
+    TEST(MmapAllocatorTest, HugePageAllocationsFallBackGracefully)
+    {
+        // Whether or not huge pages are reserved or THP is enabled, every option yields a usable ring.
+        for (mmap_huge_pages huge : {mmap_huge_pages::transparent, mmap_huge_pages::huge_2mb, mmap_huge_pages::huge_1gb})
+        {
+            mmap_allocator<int> alloc({.prefault = true, .huge_pages = huge, .lock = true});
+            constexpr std::size_t n = std::size_t{1} << 20;
+            int *p = alloc.allocate(n);
+            EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p) % mmap_allocator<int>::page_size(), 0U);
+            p[0] = 1;
+            p[n - 1] = 2;
+            EXPECT_EQ(p[0] + p[n - 1], 3);
+            alloc.deallocate(p, n);
+        }
+    }
+
+    TEST(MmapAllocatorTest, QueueWorksWithHugePageRing)
+    {
+        using queue = atomic_spsc_queue<int, modulo_index_policy, spin_yield_wait, mmap_allocator<int>>;
+        queue q(5000, mmap_allocator<int>({.prefault = true, .huge_pages = mmap_huge_pages::huge_2mb}));
+
+        EXPECT_EQ(q.get_allocator().options().huge_pages, mmap_huge_pages::huge_2mb);
+        for (int i = 0; i < 5000; ++i)
+        {
+            ASSERT_TRUE(q.try_push(i));
+        }
+        for (int i = 0; i < 5000; ++i)
+        {
+            auto value = q.try_pop();
+            ASSERT_TRUE(value.has_value());
+            EXPECT_EQ(*value, i);
+        }
+    }
+
+    using stats_queue = atomic_spsc_queue<int, modulo_index_policy, spin_yield_wait, std::allocator<int>, queue_stats>;
+
+    static_assert(std::is_empty_v<no_stats>);
+    static_assert(sizeof(atomic_spsc_queue<int>) ==
+                  sizeof(atomic_spsc_queue<int, modulo_index_policy, spin_yield_wait, std::allocator<int>, no_stats>));
+
+    TEST(AtomicSpscQueueStatsTest, CountsSuccessfulAndFailedOperations)
+    {
+        stats_queue q(2);
+
+        EXPECT_FALSE(q.try_pop().has_value());
+        ASSERT_TRUE(q.try_push(1));
+        ASSERT_TRUE(q.try_push(2));
+        EXPECT_FALSE(q.try_push(3));
+        ASSERT_TRUE(q.try_pop().has_value());
+
+        const queue_stats_snapshot s = q.stats();
+        EXPECT_EQ(s.pushes, 2U);
+        EXPECT_EQ(s.pops, 1U);
+        EXPECT_EQ(s.failed_pushes, 1U);
+        EXPECT_EQ(s.failed_pops, 1U);
+        EXPECT_EQ(s.high_water, 2U);
+    }
+
+    TEST(AtomicSpscQueueStatsTest, BulkPopOrConsumeOfZeroItemsIsNotAFailedPop)
+    {
+        stats_queue q(2);
+        std::vector<int> out;
+
+        EXPECT_EQ(q.try_pop_n(std::back_inserter(out), 0), 0U);
+        EXPECT_EQ(q.consume_up_to(0, [](int &) {}), 0U);
+        ASSERT_TRUE(q.try_push(1));
+        EXPECT_EQ(q.try_pop_n(std::back_inserter(out), 0), 0U);
+        EXPECT_EQ(q.consume_up_to(0, [](int &) {}), 0U);
+
+        EXPECT_EQ(q.stats().failed_pops, 0U);
+        EXPECT_EQ(q.size(), 1U);
+    }
+
+    TEST(AtomicSpscQueueStatsTest, CountsBulkAndSpanOperations)
+    {
+        stats_queue q(8);
+
+        const std::vector<int> values = {1, 2, 3, 4, 5};
+        ASSERT_EQ(q.try_push_n(values.begin(), values.end()), 5U);
+        auto w = q.reserve(2);
+        ASSERT_EQ(w.size(), 2U);
+        q.commit(2);
+
+        std::vector<int> out;
+        ASSERT_EQ(q.try_pop_n(std::back_inserter(out), 4), 4U);
+        q.release(q.readable().size());
+
+        const queue_stats_snapshot s = q.stats();
+        EXPECT_EQ(s.pushes, 7U);
+        EXPECT_EQ(s.pops, 7U);
+        EXPECT_EQ(s.high_water, 7U);
+        EXPECT_EQ(q.size(), 0U);
+    }
+
+    TEST(AtomicSpscQueueStatsTest, CountsWaitsOfBlockedOperations)
+    {
+        stats_queue q(1);
+
+        EXPECT_FALSE(q.pop_for(std::chrono::milliseconds(5)).has_value());
+        ASSERT_TRUE(q.try_push(1));
+        EXPECT_FALSE(q.push_for(2, std::chrono::milliseconds(5)));
+
+        const queue_stats_snapshot s = q.stats();
+        EXPECT_GT(s.pop_waits, 0U);
+        EXPECT_GT(s.push_waits, 0U);
+        EXPECT_GT(s.failed_pops, 0U);
+        EXPECT_GT(s.failed_pushes, 0U);
+    }
+
+    TEST(AtomicSpscQueueStatsTest, ProducerConsumerTotalsMatch)
+    {
+        constexpr int item_count = 20000;
+        stats_queue q(16);
+
+        std::jthread producer([&]
+                              {
+            for (int i = 0; i < item_count; ++i)
+            {
+                ASSERT_TRUE(q.push(i));
+            }
+            q.close(); });
+
+        int consumed = 0;
+        for (auto value = q.pop(); value.has_value(); value = q.pop())
+        {
+            ++consumed;
+        }
+        producer.join();
+
+        const queue_stats_snapshot s = q.stats();
+        EXPECT_EQ(consumed, item_count);
+        EXPECT_EQ(s.pushes, static_cast<std::uint64_t>(item_count));
+        EXPECT_EQ(s.pops, static_cast<std::uint64_t>(item_count));
+        EXPECT_LE(s.high_water, q.capacity());
+        EXPECT_EQ(q.approx_size(), 0U);
+    }
+
+    TEST(AtomicSpscQueueSpanTest, ReserveCommitReadableRelease)
+    {
+        atomic_spsc_queue<int> q(4);
+
+        auto w = q.reserve(3);
+        ASSERT_EQ(w.size(), 3U);
+        for (std::size_t i = 0; i < w.size(); ++i)
+        {
+            w[i] = static_cast<int>(i + 1);
+        }
+
+        // Nothing is visible before commit().
+        EXPECT_TRUE(q.readable().empty());
+        q.commit(2);
+
+        auto r = q.readable();
+        ASSERT_EQ(r.size(), 2U);
+        EXPECT_EQ(r[0], 1);
+        EXPECT_EQ(r[1], 2);
+        q.release(1);
+
+        auto value = q.try_pop();
+        ASSERT_TRUE(value.has_value());
+        EXPECT_EQ(*value, 2);
+        EXPECT_TRUE(q.readable().empty());
+    }
+
+    TEST(AtomicSpscQueueSpanTest, ReserveIsLimitedByFreeSpace)
+    {
+        atomic_spsc_queue<int> q(2);
+
+        ASSERT_TRUE(q.try_push(1));
+        EXPECT_EQ(q.reserve(8).size(), 1U);
+        ASSERT_TRUE(q.try_push(2));
+        EXPECT_TRUE(q.reserve(1).empty());
+
+        q.close();
+        ASSERT_TRUE(q.try_pop().has_value());
+        EXPECT_TRUE(q.reserve(1).empty());
+    }
+
+    TEST(AtomicSpscQueueSpanTest, SpansStopAtEndOfRing)
+    {
+        atomic_spsc_queue<int> q(4);
+
+        auto w = q.reserve(3);
+        ASSERT_EQ(w.size(), 3U);
+        q.commit(3);
+        q.release(q.readable().size());
+
+        // Free space now wraps: one slot at the end of the ring, three at the start.
+        w = q.reserve(4);
+        ASSERT_EQ(w.size(), 1U);
+        w[0] = 10;
+        q.commit(1);
+
+        w = q.reserve(4);
+        ASSERT_EQ(w.size(), 3U);
+        w[0] = 11;
+        w[1] = 12;
+        q.commit(2);
+
+        auto r = q.readable();
+        ASSERT_EQ(r.size(), 1U);
+        EXPECT_EQ(r[0], 10);
+        q.release(1);
+
+        r = q.readable();
+        ASSERT_EQ(r.size(), 2U);
+        EXPECT_EQ(r[0], 11);
+        EXPECT_EQ(r[1], 12);
+        q.release(2);
+        EXPECT_TRUE(q.readable().empty());
+    }
+
+    // Trivially copyable record whose size is not a multiple of any vector width.
+    struct Record
+    {
+        std::uint64_t seq = 0;
+        std::array<std::uint32_t, 3> data{};
+
+        bool operator==(const Record &) const = default;
+    };
+
+    Record make_record(std::uint64_t seq)
+    {
+        return {seq, {static_cast<std::uint32_t>(seq), static_cast<std::uint32_t>(seq * 3), 7}};
+    }
+
+    std::vector<Record> make_records(std::uint64_t first, std::size_t n)
+    {
+        std::vector<Record> records;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            records.push_back(make_record(first + i));
+        }
+        return records;
+    }
+
+    static_assert(contiguous_source_of<std::vector<Record>::iterator, Record>);
+    static_assert(contiguous_source_of<const Record *, Record>);
+    static_assert(contiguous_sink_of<Record *, Record>);
+    static_assert(!contiguous_sink_of<const Record *, Record>);
+    static_assert(!contiguous_sink_of<std::back_insert_iterator<std::vector<Record>>, Record>);
+    static_assert(!contiguous_source_of<std::vector<std::vector<int>>::iterator, std::vector<int>>);
+
+    TEST(BulkCopyTest, StreamItemsCopiesEveryAlignmentAndLength)
+    {
+        std::vector<unsigned char> src(300);
+        for (std::size_t i = 0; i < src.size(); ++i)
+        {
+            src[i] = static_cast<unsigned char>(i * 7 + 1);
+        }
+
+        for (std::size_t offset = 0; offset < 64; offset += 5)
+        {
+            for (std::size_t n : {0U, 1U, 15U, 16U, 33U, 64U, 129U, 200U})
+            {
+                std::vector<unsigned char> dst(300 + 64, 0);
+                stream_items(dst.data() + offset, src.data() + 3, n);
+                stream_fence();
+
+                EXPECT_TRUE(std::equal(src.begin() + 3, src.begin() + 3 + static_cast<std::ptrdiff_t>(n),
+                                       dst.begin() + static_cast<std::ptrdiff_t>(offset)));
+                EXPECT_TRUE(std::all_of(dst.begin() + static_cast<std::ptrdiff_t>(offset + n), dst.end(),
+                                        [](unsigned char c)
+                                        { return c == 0; }));
+            }
+        }
+    }
+
+    TEST(AtomicSpscQueueBulkCopyTest, ContiguousRangesWrapAroundRing)
+    {
+        atomic_spsc_queue<Record> q(5);
+        const std::vector<Record> in = make_records(0, 8);
+
+        ASSERT_EQ(q.try_push_n(in.begin(), in.begin() + 3), 3U);
+        std::array<Record, 8> out{};
+        ASSERT_EQ(q.try_pop_n(out.begin(), 3), 3U);
+
+        // Free space wraps: two slots at the end of the ring, three at the start.
+        ASSERT_EQ(q.try_push_n(in.data() + 3, in.data() + 8), 5U);
+        EXPECT_EQ(q.try_push_n(in.begin(), in.end()), 0U);
+        ASSERT_EQ(q.try_pop_n(out.data() + 3, 8), 5U);
+
+        EXPECT_TRUE(std::equal(in.begin(), in.end(), out.begin()));
+        EXPECT_EQ(q.size(), 0U);
+    }
+
+    TEST(AtomicSpscQueueBulkCopyTest, ContiguousPushStopsAtFreeSpace)
+    {
+        atomic_spsc_queue<Record, pow2_index_policy> q(3);
+        const std::vector<Record> in = make_records(10, 5);
+
+        ASSERT_TRUE(q.try_push(in[0]));
+        EXPECT_EQ(q.try_push_n(in.begin() + 1, in.end()), 2U);
+        std::vector<Record> out(5);
+        EXPECT_EQ(q.try_pop_n(out.begin(), 2), 2U);
+        EXPECT_EQ(q.try_pop(), in[2]);
+        EXPECT_EQ(out[0], in[0]);
+        EXPECT_EQ(out[1], in[1]);
+    }
+
+    TEST(AtomicSpscQueueBulkCopyTest, StreamingPushWrapsAroundRing)
+    {
+        atomic_spsc_queue<Record> q(7);
+        const std::vector<Record> in = make_records(100, 12);
+
+        ASSERT_EQ(q.try_push_n(in.begin(), in.begin() + 5, streaming_copy), 5U);
+        std::vector<Record> out(12);
+        ASSERT_EQ(q.try_pop_n(out.begin(), 5), 5U);
+        ASSERT_EQ(q.try_push_n(in.begin() + 5, in.end(), streaming_copy), 7U);
+        ASSERT_EQ(q.try_pop_n(out.begin() + 5, 12), 7U);
+
+        EXPECT_EQ(out, in);
+
+        q.close();
+        EXPECT_EQ(q.try_push_n(in.begin(), in.end(), streaming_copy), 0U);
+        EXPECT_EQ(q.push_n(in.begin(), in.end(), streaming_copy), 0U);
+    }
+
+    TEST(AtomicSpscQueueBulkCopyTest, StreamingProducerConsumerFunctionalTest)
+    {
+        constexpr std::size_t items = 100000;
+        constexpr std::size_t batch = 37;
+        atomic_spsc_queue<Record> q(100);
+
+        std::jthread producer([&]
+                              {
+            for (std::size_t i = 0; i < items; i += batch)
+            {
+                const std::vector<Record> chunk = make_records(i, std::min(batch, items - i));
+                ASSERT_EQ(q.push_n(chunk.begin(), chunk.end(), streaming_copy), chunk.size());
+            }
+            q.close(); });
+
+        std::vector<Record> chunk(64);
+        std::uint64_t expected = 0;
+        while (const std::size_t n = q.pop_n(chunk.begin(), chunk.size()))
+        {
+            for (std::size_t j = 0; j < n; ++j)
+            {
+                ASSERT_EQ(chunk[j], make_record(expected++));
+            }
+        }
+        EXPECT_EQ(expected, items);
+    }
+
+    TEST(AtomicSpscQueueBulkCopyTest, CopiedBatchesCountInStats)
+    {
+        atomic_spsc_queue<Record, modulo_index_policy, spin_yield_wait, std::allocator<Record>, queue_stats> q(4);
+        const std::vector<Record> in = make_records(0, 6);
+        std::vector<Record> out(6);
+
+        EXPECT_EQ(q.try_push_n(in.begin(), in.end()), 4U);
+        EXPECT_EQ(q.try_pop_n(out.begin(), 6), 4U);
+        EXPECT_EQ(q.try_pop_n(out.begin(), 6), 0U);
+
+        const queue_stats_snapshot s = q.stats();
+        EXPECT_EQ(s.pushes, 4U);
+        EXPECT_EQ(s.pops, 4U);
+        EXPECT_EQ(s.failed_pops, 1U);
+    }
+
+    // The whole ring lives inside the queue object, one cache line after the indices.
+    static_assert(sizeof(static_spsc_queue<int, 1024>) >= 1024 * sizeof(int));
+    static_assert(alignof(static_spsc_queue<int, 1024>) >= 64);
+    static_assert(static_pow2_index_policy<100>::capacity() == 100);
+    static_assert(static_pow2_index_policy<100>::mask == 127);
+
+    TEST(StaticSpscQueueTest, DefaultCapacityIsN)
+    {
+        static_spsc_queue<int, 100> q;
+        EXPECT_EQ(q.capacity(), 100U);
+        for (int i = 0; i < 100; ++i)
+        {
+            ASSERT_TRUE(q.try_push(i));
+        }
+        EXPECT_FALSE(q.try_push(100));
+    }
+
+    TEST(StaticSpscQueueTest, CapacityMustBeN)
+    {
+        EXPECT_THROW((static_spsc_queue<int, 8>(9)), std::invalid_argument);
+        EXPECT_THROW((static_spsc_queue<int, 8>(4)), std::invalid_argument);
+        EXPECT_NO_THROW((static_spsc_queue<int, 8>(8)));
+    }
+
+    TEST(StaticSpscQueueTest, NonPowerOfTwoCapacityWrapsAround)
+    {
+        // 100 items in a 128-slot ring: every lap shifts the start slot.
+        static_spsc_queue<int, 100> q;
+        std::vector<int> out(100);
+        for (int lap = 0; lap < 5; ++lap)
+        {
+            std::vector<int> in(100);
+            for (int i = 0; i < 100; ++i)
+            {
+                in[static_cast<std::size_t>(i)] = lap * 100 + i;
+            }
+            ASSERT_EQ(q.try_push_n(in.begin(), in.end()), 100U);
+            ASSERT_EQ(q.try_pop_n(out.begin(), out.size()), 100U);
+            EXPECT_EQ(out, in);
+            ASSERT_TRUE(q.try_push(-1));
+            ASSERT_EQ(q.try_pop(), std::optional<int>(-1));
+        }
+    }
+
+    TEST(StaticSpscQueueTest, ItemsAreConstructedAndDestroyedInPlace)
+    {
+        int live = 0;
+        {
+            static_spsc_queue<Tracked, 4> q;
+            EXPECT_EQ(live, 0);
+            ASSERT_TRUE(q.try_emplace(1, live));
+            ASSERT_TRUE(q.try_emplace(2, live));
+            ASSERT_TRUE(q.try_pop().has_value());
+            EXPECT_EQ(live, 1);
+        }
+        EXPECT_EQ(live, 0);
+    }
+
+    TEST(StaticSpscQueueTest, QueuesEmbedInPreallocatedStructs)
+    {
+        struct per_core
+        {
+            static_spsc_queue<int, 16> inbox;
+            static_spsc_queue<int, 16> outbox;
+        };
+        std::array<per_core, 4> cores;
+
+        for (std::size_t i = 0; i < cores.size(); ++i)
+        {
+            ASSERT_TRUE(cores[i].inbox.try_push(static_cast<int>(i)));
+        }
+        for (std::size_t i = 0; i < cores.size(); ++i)
+        {
+            EXPECT_EQ(cores[i].inbox.try_pop(), std::optional<int>(static_cast<int>(i)));
+            EXPECT_FALSE(cores[i].outbox.try_pop().has_value());
+        }
+    }
+
+    TEST(StaticSpscQueueTest, SpanInterfaceWrapsAtEndOfRing)
+    {
+        static_spsc_queue<int, 4> q;
+        ASSERT_TRUE(q.try_push(0));
+        ASSERT_TRUE(q.try_push(0));
+        ASSERT_TRUE(q.try_push(0));
+        std::vector<int> drained;
+        ASSERT_EQ(q.try_pop_n(std::back_inserter(drained), 3), 3U);
+
+        std::span<int> w = q.reserve(4);
+        ASSERT_EQ(w.size(), 1U);
+        w[0] = 10;
+        q.commit(1);
+        w = q.reserve(3);
+        ASSERT_EQ(w.size(), 3U);
+        w[0] = 11;
+        q.commit(1);
+
+        std::span<int> r = q.readable();
+        ASSERT_EQ(r.size(), 1U);
+        EXPECT_EQ(r[0], 10);
+        q.release(1);
+        r = q.readable();
+        ASSERT_EQ(r.size(), 1U);
+        EXPECT_EQ(r[0], 11);
+        q.release(1);
+        EXPECT_TRUE(q.readable().empty());
+    }
+
+    TEST(StaticSpscQueueTest, InlineStorageMustHoldTheRing)
+    {
+        using inline_queue = atomic_spsc_queue<int, pow2_index_policy, spin_yield_wait, inline_storage<int, 8>>;
+        EXPECT_THROW(inline_queue(9), std::invalid_argument);
+        EXPECT_NO_THROW(inline_queue(8));
+    }
+
+    TEST(StaticSpscQueueTest, SupportsStatsAndLazyPublish)
+    {
+        static_spsc_queue<int, 8, spin_yield_wait, queue_stats, lazy_publish<4>> q;
+        for (int i = 0; i < 3; ++i)
+        {
+            ASSERT_TRUE(q.try_push(i));
+        }
+        EXPECT_EQ(q.size(), 0U);
+
+        q.flush();
+        EXPECT_EQ(q.consume_all([](int &) {}), 3U);
+        EXPECT_FALSE(q.try_pop().has_value());
+
+        const queue_stats_snapshot s = q.stats();
+        EXPECT_EQ(s.pushes, 3U);
+        EXPECT_EQ(s.failed_pops, 1U);
+    }
+
+    // Policies that put a blocked side to sleep, with a small spin budget so blocked operations
+    // park almost immediately.
+    template <class QueueType>
+    class AtomicSpscQueueParkTest : public ::testing::Test
+    {
+    };
+
+    using ParkingQueues = ::testing::Types<
+        atomic_spsc_queue<int, modulo_index_policy, park_wait<16>>,
+        atomic_spsc_queue<int, modulo_index_policy, condvar_wait<16>>>;
+    TYPED_TEST_SUITE(AtomicSpscQueueParkTest, ParkingQueues);
+
+    constexpr auto park_delay = std::chrono::milliseconds(50);
+
+    TYPED_TEST(AtomicSpscQueueParkTest, ParkedConsumerIsWokenByPush)
+    {
+        TypeParam q(1);
+
+        auto consumer = std::async(std::launch::async, [&]
+                                   { return q.pop(); });
+
+        std::this_thread::sleep_for(park_delay);
+        ASSERT_TRUE(q.try_push(42));
+
+        ASSERT_EQ(consumer.wait_for(timeout), std::future_status::ready);
+        auto value = consumer.get();
+        ASSERT_TRUE(value.has_value());
+        EXPECT_EQ(*value, 42);
+    }
+
+    TYPED_TEST(AtomicSpscQueueParkTest, ParkedProducerIsWokenByPop)
+    {
+        TypeParam q(1);
+        ASSERT_TRUE(q.try_push(1));
+
+        auto producer = std::async(std::launch::async, [&]
+                                   { return q.push(2); });
+
+        std::this_thread::sleep_for(park_delay);
+        ASSERT_TRUE(q.try_pop().has_value());
+
+        ASSERT_EQ(producer.wait_for(timeout), std::future_status::ready);
+        EXPECT_TRUE(producer.get());
+        EXPECT_EQ(q.try_pop(), std::optional<int>(2));
+    }
+
+    TYPED_TEST(AtomicSpscQueueParkTest, ParkedConsumerIsWokenByClose)
+    {
+        TypeParam q(1);
+
+        auto consumer = std::async(std::launch::async, [&]
+                                   { return q.pop(); });
+
+        std::this_thread::sleep_for(park_delay);
+        q.close();
+
+        ASSERT_EQ(consumer.wait_for(timeout), std::future_status::ready);
+        EXPECT_FALSE(consumer.get().has_value());
+    }
+
+    TYPED_TEST(AtomicSpscQueueParkTest, ParkedProducerIsWokenByClose)
+    {
+        TypeParam q(1);
+        ASSERT_TRUE(q.try_push(1));
+
+        auto producer = std::async(std::launch::async, [&]
+                                   { return q.push(2); });
+
+        std::this_thread::sleep_for(park_delay);
+        q.close();
+
+        ASSERT_EQ(producer.wait_for(timeout), std::future_status::ready);
+        EXPECT_FALSE(producer.get());
+    }
+
+    TYPED_TEST(AtomicSpscQueueParkTest, ParkedTimedPopWakesUpAtDeadline)
+    {
+        TypeParam q(1);
+
+        const auto start = std::chrono::steady_clock::now();
+        EXPECT_FALSE(q.pop_for(park_delay).has_value());
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+
+        EXPECT_GE(elapsed, park_delay);
+        EXPECT_LT(elapsed, timeout);
+    }
+
+    TYPED_TEST(AtomicSpscQueueParkTest, ProducerConsumerFunctionalTestWithFrequentParking)
+    {
+        constexpr int item_count = 20000;
+
+        TypeParam q(2);
+        std::vector<int> consumed;
+        consumed.reserve(item_count);
+
+        std::jthread producer([&]
+                              {
+            for (int i = 0; i < item_count; ++i)
+            {
+                ASSERT_TRUE(q.push(i));
+            }
+            q.close(); });
+
+        std::jthread consumer([&]
+                              {
+            for (auto value = q.pop(); value.has_value(); value = q.pop())
+            {
+                consumed.push_back(*value);
+            } });
+
+        producer.join();
+        consumer.join();
+
+        ASSERT_EQ(static_cast<int>(consumed.size()), item_count);
+        for (int i = 0; i < item_count; ++i)
+        {
+            EXPECT_EQ(consumed[i], i);
+        }
+    }
+
+    template <std::size_t ProducerBatch, std::size_t ConsumerBatch = ProducerBatch>
+    using lazy_queue = atomic_spsc_queue<int, modulo_index_policy, spin_yield_wait, std::allocator<int>, no_stats,
+                                         lazy_publish<ProducerBatch, ConsumerBatch>>;
+
+    TEST(AtomicSpscQueueLazyPublishTest, PushesArePublishedOncePerBatch)
+    {
+        lazy_queue<4, 1> q(8);
+
+        for (int i = 0; i < 3; ++i)
+        {
+            ASSERT_TRUE(q.try_push(i));
+        }
+        EXPECT_EQ(q.size(), 0U);
+        EXPECT_FALSE(q.try_pop().has_value());
+
+        ASSERT_TRUE(q.try_push(3));
+        EXPECT_EQ(q.size(), 4U);
+        for (int i = 0; i < 4; ++i)
+        {
+            EXPECT_EQ(q.try_pop(), std::optional<int>(i));
+        }
+    }
+
+    TEST(AtomicSpscQueueLazyPublishTest, FlushPublishesPendingPushes)
+    {
+        lazy_queue<16, 1> q(32);
+        ASSERT_TRUE(q.try_push(1));
+        ASSERT_TRUE(q.try_push(2));
+        EXPECT_FALSE(q.try_pop().has_value());
+
+        q.flush();
+        EXPECT_EQ(q.size(), 2U);
+        EXPECT_EQ(q.try_pop(), std::optional<int>(1));
+        EXPECT_EQ(q.try_pop(), std::optional<int>(2));
+    }
+
+    TEST(AtomicSpscQueueLazyPublishTest, ClosePublishesPendingPushes)
+    {
+        lazy_queue<16> q(32);
+        ASSERT_TRUE(q.try_push(1));
+        ASSERT_TRUE(q.try_push(2));
+        q.close();
+
+        EXPECT_FALSE(q.done());
+        EXPECT_EQ(q.pop(), std::optional<int>(1));
+        EXPECT_EQ(q.pop(), std::optional<int>(2));
+        EXPECT_FALSE(q.pop().has_value());
+        EXPECT_TRUE(q.done());
+    }
+
+    TEST(AtomicSpscQueueLazyPublishTest, FullProducerPublishesBeforeFailing)
+    {
+        // The batch never fills up in a ring of 2 slots; a failed push publishes what is pending.
+        lazy_queue<8, 1> q(2);
+        ASSERT_TRUE(q.try_push(1));
+        ASSERT_TRUE(q.try_push(2));
+        EXPECT_EQ(q.size(), 0U);
+
+        EXPECT_FALSE(q.try_push(3));
+        EXPECT_EQ(q.size(), 2U);
+    }
+
+    TEST(AtomicSpscQueueLazyPublishTest, ConsumeUpToFreesSlotsOncePerBatch)
+    {
+        // consume_all/consume_up_to share the drain path with the fixed-capacity alias.
+        static_spsc_queue<int, 4, spin_yield_wait, no_stats, lazy_publish<1, 4>> q;
+        for (int i = 0; i < 4; ++i)
+        {
+            ASSERT_TRUE(q.try_push(i));
+        }
+
+        int sum = 0;
+        ASSERT_EQ(q.consume_up_to(2, [&](int &v) { sum += v; }), 2U);
+        EXPECT_FALSE(q.try_push(4));
+
+        ASSERT_EQ(q.consume_all([&](int &v) { sum += v; }), 2U);
+        EXPECT_EQ(sum, 6);
+        EXPECT_TRUE(q.try_push(4));
+    }
+
+    TEST(AtomicSpscQueueLazyPublishTest, PopsFreeSlotsOncePerBatch)
+    {
+        lazy_queue<1, 2> q(2);
+        ASSERT_TRUE(q.try_push(1));
+        ASSERT_TRUE(q.try_push(2));
+
+        ASSERT_EQ(q.try_pop(), std::optional<int>(1));
+        // The freed slot is not published to the producer yet.
+        EXPECT_FALSE(q.try_push(3));
+
+        ASSERT_EQ(q.try_pop(), std::optional<int>(2));
+        EXPECT_TRUE(q.try_push(3));
+        EXPECT_TRUE(q.try_push(4));
+    }
+
+    TEST(AtomicSpscQueueLazyPublishTest, EmptyConsumerPublishesBeforeFailing)
+    {
+        lazy_queue<1, 8> q(2);
+        ASSERT_TRUE(q.try_push(1));
+        ASSERT_EQ(q.try_pop(), std::optional<int>(1));
+        EXPECT_EQ(q.size(), 1U);
+
+        EXPECT_FALSE(q.try_pop().has_value());
+        EXPECT_EQ(q.size(), 0U);
+    }
+
+    TEST(AtomicSpscQueueLazyPublishTest, FlushPopsPublishesPendingPops)
+    {
+        lazy_queue<1, 8> q(4);
+        ASSERT_TRUE(q.try_push(1));
+        ASSERT_TRUE(q.try_push(2));
+        ASSERT_EQ(q.try_pop(), std::optional<int>(1));
+        EXPECT_EQ(q.size(), 2U);
+
+        q.flush_pops();
+        EXPECT_EQ(q.size(), 1U);
+    }
+
+    TEST(AtomicSpscQueueLazyPublishTest, BulkAndSpanOperationsCountTowardsTheBatch)
+    {
+        lazy_queue<4> q(8);
+        const std::vector<int> in{1, 2, 3};
+        ASSERT_EQ(q.try_push_n(in.begin(), in.end()), 3U);
+        EXPECT_EQ(q.size(), 0U);
+
+        std::span<int> w = q.reserve(1);
+        ASSERT_EQ(w.size(), 1U);
+        w[0] = 4;
+        q.commit(1);
+        EXPECT_EQ(q.size(), 4U);
+
+        std::vector<int> out(4);
+        ASSERT_EQ(q.try_pop_n(out.begin(), out.size()), 4U);
+        EXPECT_EQ(out, (std::vector<int>{1, 2, 3, 4}));
+    }
+
+    TEST(AtomicSpscQueueLazyPublishTest, DestructorDestroysUnpublishedItems)
+    {
+        int live = 0;
+        {
+            atomic_spsc_queue<Tracked, modulo_index_policy, spin_yield_wait, std::allocator<Tracked>, no_stats,
+                              lazy_publish<8>>
+                q(4);
+            ASSERT_TRUE(q.try_emplace(1, live));
+            ASSERT_TRUE(q.try_emplace(2, live));
+            ASSERT_TRUE(q.try_emplace(3, live));
+            // close() publishes the pending pushes; the pop below stays unpublished.
+            q.close();
+            ASSERT_TRUE(q.try_pop().has_value());
+            EXPECT_EQ(live, 2);
+        }
+        EXPECT_EQ(live, 0);
+    }
+
+    template <class Queue>
+    void run_lazy_functional_test(std::size_t capacity)
+    {
+        constexpr int item_count = 50000;
+
+        Queue q(capacity);
+        std::vector<int> consumed;
+        consumed.reserve(item_count);
+
+        std::jthread producer([&]
+                              {
+            for (int i = 0; i < item_count; ++i)
+            {
+                ASSERT_TRUE(q.push(i));
+            }
+            q.close(); });
+
+        for (auto value = q.pop(); value.has_value(); value = q.pop())
+        {
+            consumed.push_back(*value);
+        }
+        producer.join();
+
+        ASSERT_EQ(static_cast<int>(consumed.size()), item_count);
+        for (int i = 0; i < item_count; ++i)
+        {
+            ASSERT_EQ(consumed[i], i);
+        }
+    }
+
+    TEST(AtomicSpscQueueLazyPublishTest, ProducerConsumerFunctionalTest)
+    {
+        run_lazy_functional_test<lazy_queue<8>>(64);
+        run_lazy_functional_test<lazy_queue<16, 1>>(64);
+        run_lazy_functional_test<lazy_queue<1, 16>>(64);
+    }
+
+    TEST(AtomicSpscQueueLazyPublishTest, FunctionalTestWithBatchLargerThanRing)
+    {
+        run_lazy_functional_test<lazy_queue<64>>(4);
+    }
+
+    template <class WaitPolicy>
+    concept mp_queue_accepts = requires { typename mpmc_queue<int, WaitPolicy>; };
+
+    static_assert(mp_queue_accepts<spin_yield_wait>);
+    static_assert(!mp_queue_accepts<park_wait<>>);
+
+    // Payload whose constructor throws for negative values.
+    struct ThrowsOnNegative
+    {
+        explicit ThrowsOnNegative(int v) : value(v)
+        {
+            if (v < 0)
+            {
+                throw std::runtime_error("negative");
+            }
+        }
+
+        int value;
+    };
+
+    using tracked_slot_queue = slot_spsc_queue<Tracked>;
+
+    TEST(SlotSpscQueueTest, ConstructionDoesNotCreateItems)
+    {
+        int live = 0;
+        {
+            tracked_slot_queue q(4);
+            EXPECT_EQ(live, 0);
+            ASSERT_TRUE(q.try_emplace(1, live));
+            EXPECT_EQ(live, 1);
+        }
+        EXPECT_EQ(live, 0);
+    }
+
+    TEST(SlotSpscQueueTest, DestructorDestroysRemainingItemsOfAFullRing)
+    {
+        int live = 0;
+        {
+            tracked_slot_queue q(3);
+            for (int i = 0; i < 5; ++i)
+            {
+                ASSERT_TRUE(q.try_emplace(i, live));
+                if (i < 2)
+                {
+                    ASSERT_TRUE(q.try_pop().has_value());
+                }
+            }
+            EXPECT_FALSE(q.try_emplace(5, live));
+            EXPECT_EQ(live, 3);
+        }
+        EXPECT_EQ(live, 0);
+    }
+
+    TEST(SlotSpscQueueTest, ThrowingConstructorLeavesQueueUnchanged)
+    {
+        slot_spsc_queue<ThrowsOnNegative> q(2);
+        ASSERT_TRUE(q.try_emplace(1));
+        EXPECT_THROW(q.try_emplace(-1), std::runtime_error);
+        ASSERT_TRUE(q.try_emplace(2));
+        EXPECT_EQ(q.size(), 2U);
+
+        EXPECT_EQ(q.try_pop()->value, 1);
+        EXPECT_EQ(q.try_pop()->value, 2);
+        EXPECT_FALSE(q.try_pop().has_value());
+    }
+
+    TEST(SlotSpscQueueTest, DoneTurnsTrueOnceTheLastSlotIsDrained)
+    {
+        slot_spsc_queue<int> q(2);
+        ASSERT_TRUE(q.try_push(1));
+        q.close();
+
+        EXPECT_FALSE(q.done());
+        ASSERT_EQ(q.try_pop(), std::optional<int>(1));
+        EXPECT_TRUE(q.done());
+    }
+
+    template <class QueueType>
+    class MpQueueTest : public ::testing::Test
+    {
+    };
+
+    using MpQueueImplementations = ::testing::Types<mpsc_queue<ThrowsOnNegative>, mpmc_queue<ThrowsOnNegative>>;
+    TYPED_TEST_SUITE(MpQueueTest, MpQueueImplementations);
+
+    TYPED_TEST(MpQueueTest, ThrowingConstructorLeavesHoleThatIsSkipped)
+    {
+        TypeParam q(4);
+
+        ASSERT_TRUE(q.try_emplace(1));
+        EXPECT_THROW(q.try_emplace(-1), std::runtime_error);
+        ASSERT_TRUE(q.try_emplace(2));
+
+        auto first = q.try_pop();
+        auto second = q.try_pop();
+        ASSERT_TRUE(first.has_value());
+        ASSERT_TRUE(second.has_value());
+        EXPECT_EQ(first->value, 1);
+        EXPECT_EQ(second->value, 2);
+        EXPECT_FALSE(q.try_pop().has_value());
+        EXPECT_EQ(q.size(), 0U);
+    }
+
+    TYPED_TEST(MpQueueTest, FailedTryPushDoesNotConsumeArgument)
+    {
+        using Value = typename TypeParam::value_type;
+        TypeParam q(1);
+
+        ASSERT_TRUE(q.try_push(Value(1)));
+        Value pending(2);
+        EXPECT_FALSE(q.try_push(std::move(pending)));
+        EXPECT_EQ(pending.value, 2);
+    }
+
+    // Item values encode producer * per_producer + seq.
+    template <class QueueType>
+    std::vector<std::vector<int>> run_fan_in(QueueType &q, int producers, int consumers, int per_producer)
+    {
+        std::atomic<int> running = producers;
+        std::vector<std::vector<int>> consumed(consumers);
+        {
+            std::vector<std::jthread> threads;
+            for (int p = 0; p < producers; ++p)
+            {
+                threads.emplace_back([&, p]
+                                     {
+                    for (int i = 0; i < per_producer; ++i)
+                    {
+                        ASSERT_TRUE(q.push(p * per_producer + i));
+                    }
+                    if (running.fetch_sub(1) == 1)
+                    {
+                        q.close();
+                    } });
+            }
+            for (int c = 0; c < consumers; ++c)
+            {
+                threads.emplace_back([&, c]
+                                     {
+                    for (auto value = q.pop(); value.has_value(); value = q.pop())
+                    {
+                        consumed[c].push_back(*value);
+                    } });
+            }
+        }
+        return consumed;
+    }
+
+    // Every item arrives exactly once, and each consumer sees each producer's items in order.
+    void expect_fan_in_delivery(const std::vector<std::vector<int>> &consumed, int producers, int per_producer)
+    {
+        std::vector<int> seen(static_cast<std::size_t>(producers * per_producer), 0);
+        for (const std::vector<int> &values : consumed)
+        {
+            std::vector<int> last(static_cast<std::size_t>(producers), -1);
+            for (int v : values)
+            {
+                ++seen[static_cast<std::size_t>(v)];
+                const auto p = static_cast<std::size_t>(v / per_producer);
+                EXPECT_GT(v % per_producer, last[p]);
+                last[p] = v % per_producer;
+            }
+        }
+        EXPECT_TRUE(std::all_of(seen.begin(), seen.end(), [](int n)
+                                { return n == 1; }));
+    }
+
+    TEST(MpscQueueTest, SeveralProducersOneConsumer)
+    {
+        constexpr int producers = 4;
+        constexpr int per_producer = 5000;
+        mpsc_queue<int> q(8);
+
+        expect_fan_in_delivery(run_fan_in(q, producers, 1, per_producer), producers, per_producer);
+    }
+
+    // One producer closes while another keeps pushing: every push that returned true is delivered.
+    template <class Queue>
+    void expect_close_race_loses_no_items()
+    {
+        for (int round = 0; round < 100; ++round)
+        {
+            Queue q(4);
+            std::atomic<int> pushed = 0;
+            int popped = 0;
+            {
+                // Bounded so the round ends even if the closer is not scheduled for a while.
+                std::jthread pusher([&]
+                                    {
+                    for (int i = 0; i < 1 << 20 && q.push(i); ++i)
+                    {
+                        pushed.fetch_add(1, std::memory_order_relaxed);
+                    } });
+                // Closes at a different point of the stream each round, with its own push just before.
+                std::jthread closer([&]
+                                    {
+                    while (pushed.load(std::memory_order_relaxed) < round)
+                    {
+                        std::this_thread::yield();
+                    }
+                    if (q.try_push(-1))
+                    {
+                        pushed.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    q.close(); });
+                std::jthread consumer([&]
+                                      {
+                    for (auto value = q.pop(); value.has_value(); value = q.pop())
+                    {
+                        ++popped;
+                    } });
+            }
+            ASSERT_EQ(popped, pushed.load()) << "round " << round;
+        }
+    }
+
+    TEST(MpscQueueTest, CloseRacingWithPushLosesNoItems)
+    {
+        expect_close_race_loses_no_items<mpsc_queue<int>>();
+    }
+
+    TEST(MpmcQueueTest, SeveralProducersSeveralConsumers)
+    {
+        constexpr int producers = 4;
+        constexpr int per_producer = 5000;
+        mpmc_queue<int> q(8);
+
+        expect_fan_in_delivery(run_fan_in(q, producers, 3, per_producer), producers, per_producer);
+    }
+
+    TEST(MpmcQueueTest, CloseRacingWithPushLosesNoItems)
+    {
+        expect_close_race_loses_no_items<mpmc_queue<int>>();
+    }
 } // namespace
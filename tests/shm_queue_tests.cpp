@@ -0,0 +1,197 @@
+#include "shm_spsc_queue.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+    struct Tick
+    {
+        std::uint64_t seq = 0;
+        std::array<double, 3> prices{};
+    };
+
+    // A unique shm_open() name per test and process, so parallel ctest runs do not collide.
+    std::string region_name(const char *test)
+    {
+        return "/shm_queue_tests_" + std::string(test) + "_" + std::to_string(::getpid());
+    }
+
+    // Runs f in a forked child; f returns whether the child succeeded. The child leaves with
+    // _exit() so it does not run the parent's gtest teardown.
+    template <typename F>
+    pid_t spawn_child(F &&f)
+    {
+        const pid_t pid = ::fork();
+        if (pid == 0)
+        {
+            bool ok = false;
+            try
+            {
+                ok = f();
+            }
+            catch (...)
+            {
+            }
+            ::_exit(ok ? 0 : 1);
+        }
+        return pid;
+    }
+
+    // Exit status of the child, -1 if it did not exit normally.
+    int wait_child(pid_t pid)
+    {
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    }
+
+    TEST(ShmSpscQueueTest, RegionHoldsHeaderAndRingInWholePages)
+    {
+        shm_spsc_queue<Tick> q(100);
+        EXPECT_EQ(q.capacity(), 100U);
+        EXPECT_GE(q.region_size(), 100 * sizeof(Tick));
+        EXPECT_EQ(q.region_size() % static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)), 0U);
+        EXPECT_GE(q.fd(), 0);
+    }
+
+    TEST(ShmSpscQueueTest, HugePagesFallBackToNormalPages)
+    {
+        // Passes whether or not the machine has huge pages reserved.
+        shm_spsc_queue<int> q(16, shm_options{.huge_pages = true, .prefault = true});
+        EXPECT_EQ(q.region_size() % (std::size_t{2} << 20), 0U);
+        ASSERT_TRUE(q.try_push(1));
+        EXPECT_EQ(q.try_pop(), 1);
+    }
+
+    TEST(ShmSpscQueueTest, AttachedQueueSharesState)
+    {
+        shm_spsc_queue<Tick> producer(4);
+        auto consumer = shm_spsc_queue<Tick>::attach(producer.fd());
+        EXPECT_EQ(consumer.capacity(), 4U);
+
+        ASSERT_TRUE(producer.try_push(Tick{7, {1.0, 2.0, 3.0}}));
+        const std::optional<Tick> tick = consumer.try_pop();
+        ASSERT_TRUE(tick.has_value());
+        EXPECT_EQ(tick->seq, 7U);
+        EXPECT_EQ(tick->prices[2], 3.0);
+
+        producer.close();
+        EXPECT_TRUE(consumer.done());
+    }
+
+    TEST(ShmSpscQueueTest, AttachChecksValueType)
+    {
+        shm_spsc_queue<std::uint32_t> q(4);
+        EXPECT_THROW(shm_spsc_queue<std::uint64_t>::attach(q.fd()), std::runtime_error);
+    }
+
+    TEST(ShmSpscQueueTest, AttachRejectsUninitializedRegion)
+    {
+        const int fd = ::memfd_create("shm_queue_tests", MFD_CLOEXEC);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ(::ftruncate(fd, 4096), 0);
+        EXPECT_THROW(shm_spsc_queue<int>::attach(fd), std::runtime_error);
+        ::close(fd);
+    }
+
+    TEST(ShmSpscQueueTest, NamedRegionMustNotExistOnCreate)
+    {
+        const std::string name = region_name("exists");
+        auto q = shm_spsc_queue<int>::create(name, 4);
+        EXPECT_THROW(shm_spsc_queue<int>::create(name, 4), std::system_error);
+    }
+
+    TEST(ShmSpscQueueTest, AttachToMissingNameThrows)
+    {
+        EXPECT_THROW(shm_spsc_queue<int>::attach(region_name("missing")), std::system_error);
+    }
+
+    TEST(ShmSpscQueueTest, CreatorUnlinksName)
+    {
+        const std::string name = region_name("unlink");
+        {
+            auto q = shm_spsc_queue<int>::create(name, 4);
+        }
+        EXPECT_THROW(shm_spsc_queue<int>::attach(name), std::system_error);
+    }
+
+    TEST(ShmSpscQueueTest, CrossProcessFunctionalTestOverNamedRegion)
+    {
+        constexpr std::uint64_t items = 100000;
+        const std::string name = region_name("named");
+        auto q = shm_spsc_queue<Tick>::create(name, 64);
+
+        const pid_t child = spawn_child([&]
+                                        {
+            auto producer = shm_spsc_queue<Tick>::attach(name);
+            for (std::uint64_t i = 0; i < items; ++i)
+            {
+                if (!producer.push(Tick{i, {static_cast<double>(i), 0.0, 0.0}}))
+                {
+                    return false;
+                }
+            }
+            producer.close();
+            return true; });
+
+        std::uint64_t expected = 0;
+        while (const std::optional<Tick> tick = q.pop())
+        {
+            ASSERT_EQ(tick->seq, expected);
+            ASSERT_EQ(tick->prices[0], static_cast<double>(expected));
+            ++expected;
+        }
+        EXPECT_EQ(expected, items);
+        EXPECT_EQ(wait_child(child), 0);
+    }
+
+    TEST(ShmSpscQueueTest, CrossProcessFunctionalTestOverInheritedFd)
+    {
+        constexpr std::uint64_t items = 100000;
+        shm_spsc_queue<std::uint64_t> q(64);
+        const int fd = q.fd();
+
+        // The child pushes through its own mapping of the inherited fd, in batches.
+        const pid_t child = spawn_child([&]
+                                        {
+            auto producer = shm_spsc_queue<std::uint64_t>::attach(fd);
+            std::array<std::uint64_t, 16> chunk{};
+            for (std::uint64_t i = 0; i < items; i += chunk.size())
+            {
+                for (std::size_t j = 0; j < chunk.size(); ++j)
+                {
+                    chunk[j] = i + j;
+                }
+                if (producer.push_n(chunk.begin(), chunk.end()) != chunk.size())
+                {
+                    return false;
+                }
+            }
+            producer.close();
+            return true; });
+
+        std::uint64_t expected = 0;
+        std::array<std::uint64_t, 32> out{};
+        for (std::size_t n = q.pop_n(out.begin(), out.size()); n != 0; n = q.pop_n(out.begin(), out.size()))
+        {
+            for (std::size_t j = 0; j < n; ++j)
+            {
+                ASSERT_EQ(out[j], expected);
+                ++expected;
+            }
+        }
+        EXPECT_EQ(expected, items);
+        EXPECT_EQ(wait_child(child), 0);
+    }
+} // namespace
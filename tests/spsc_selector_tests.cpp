@@ -0,0 +1,254 @@
+#include "atomic_spsc_queue.hpp"
+#include "simple_spsc_queue.hpp"
+#include "spsc_selector.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr auto timeout = std::chrono::seconds(2);
+    constexpr auto park_delay = std::chrono::milliseconds(50);
+
+    using select_queue = atomic_spsc_queue<int, modulo_index_policy, selector_wait>;
+    // Small spin budget so select() parks almost immediately.
+    using parking_selector = spsc_selector<select_queue, 16>;
+
+    // A helper function to collect (queue index, item) pairs in consumption order.
+    auto collect_into(std::vector<std::pair<std::size_t, int>> &out)
+    {
+        return [&out](std::size_t index, int &item)
+        { out.emplace_back(index, item); };
+    }
+
+    TEST(SpscSelectorTest, TrySelectReturnsZeroWhenAllQueuesAreEmpty)
+    {
+        select_queue a(4);
+        select_queue b(4);
+        spsc_selector<select_queue> selector;
+        selector.add(a);
+        selector.add(b);
+
+        std::vector<std::pair<std::size_t, int>> consumed;
+        EXPECT_EQ(selector.try_select(collect_into(consumed)), 0U);
+        EXPECT_TRUE(consumed.empty());
+        EXPECT_EQ(selector.active(), 2U);
+    }
+
+    TEST(SpscSelectorTest, WeightMustBePositive)
+    {
+        select_queue q(4);
+        spsc_selector<select_queue> selector;
+        EXPECT_THROW(selector.add(q, 0), std::invalid_argument);
+    }
+
+    TEST(SpscSelectorTest, RoundRobinGivesEveryQueueOneTurnPerRound)
+    {
+        select_queue a(4);
+        select_queue b(4);
+        spsc_selector<select_queue> selector;
+        const std::size_t ia = selector.add(a);
+        const std::size_t ib = selector.add(b);
+
+        for (int i = 0; i < 3; ++i)
+        {
+            ASSERT_TRUE(a.try_push(10 + i));
+            ASSERT_TRUE(b.try_push(20 + i));
+        }
+
+        std::vector<std::pair<std::size_t, int>> consumed;
+        EXPECT_EQ(selector.try_select(collect_into(consumed)), 2U);
+        EXPECT_EQ(selector.try_select(collect_into(consumed)), 2U);
+
+        const std::vector<std::pair<std::size_t, int>> expected{{ia, 10}, {ib, 20}, {ia, 11}, {ib, 21}};
+        EXPECT_EQ(consumed, expected);
+    }
+
+    TEST(SpscSelectorTest, MaxLimitKeepsRotationFair)
+    {
+        select_queue a(4);
+        select_queue b(4);
+        spsc_selector<select_queue> selector;
+        const std::size_t ia = selector.add(a);
+        const std::size_t ib = selector.add(b);
+
+        ASSERT_TRUE(a.try_push(1));
+        ASSERT_TRUE(a.try_push(2));
+        ASSERT_TRUE(b.try_push(3));
+
+        // The next call starts with the queue after the one that had the last turn.
+        std::vector<std::pair<std::size_t, int>> consumed;
+        EXPECT_EQ(selector.try_select(collect_into(consumed), 1), 1U);
+        EXPECT_EQ(selector.try_select(collect_into(consumed), 1), 1U);
+        EXPECT_EQ(selector.try_select(collect_into(consumed), 1), 1U);
+
+        const std::vector<std::pair<std::size_t, int>> expected{{ia, 1}, {ib, 3}, {ia, 2}};
+        EXPECT_EQ(consumed, expected);
+    }
+
+    TEST(SpscSelectorTest, WeightDrainsUpToWeightItemsPerTurn)
+    {
+        select_queue a(8);
+        select_queue b(8);
+        spsc_selector<select_queue> selector;
+        const std::size_t ia = selector.add(a, 3);
+        const std::size_t ib = selector.add(b);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            ASSERT_TRUE(a.try_push(i));
+            ASSERT_TRUE(b.try_push(100 + i));
+        }
+
+        std::vector<std::pair<std::size_t, int>> consumed;
+        EXPECT_EQ(selector.try_select(collect_into(consumed)), 4U);
+
+        const std::vector<std::pair<std::size_t, int>> expected{{ia, 0}, {ia, 1}, {ia, 2}, {ib, 100}};
+        EXPECT_EQ(consumed, expected);
+    }
+
+    TEST(SpscSelectorTest, ClosedQueuesAreRetiredOnceDrained)
+    {
+        select_queue a(4);
+        select_queue b(4);
+        spsc_selector<select_queue> selector;
+        selector.add(a);
+        selector.add(b);
+
+        ASSERT_TRUE(a.try_push(1));
+        a.close();
+
+        std::vector<std::pair<std::size_t, int>> consumed;
+        EXPECT_EQ(selector.try_select(collect_into(consumed)), 1U);
+        EXPECT_EQ(selector.active(), 2U);
+
+        // a is now closed and drained.
+        EXPECT_EQ(selector.try_select(collect_into(consumed)), 0U);
+        EXPECT_EQ(selector.active(), 1U);
+        EXPECT_FALSE(selector.done());
+
+        b.close();
+        EXPECT_EQ(selector.try_select(collect_into(consumed)), 0U);
+        EXPECT_TRUE(selector.done());
+    }
+
+    TEST(SpscSelectorTest, ParkedSelectIsWokenByPush)
+    {
+        select_queue a(4);
+        select_queue b(4);
+        parking_selector selector;
+        selector.add(a);
+        const std::size_t ib = selector.add(b);
+
+        std::vector<std::pair<std::size_t, int>> consumed;
+        auto consumer = std::async(std::launch::async, [&]
+                                   { return selector.select(collect_into(consumed)); });
+
+        std::this_thread::sleep_for(park_delay);
+        ASSERT_TRUE(b.try_push(42));
+
+        ASSERT_EQ(consumer.wait_for(timeout), std::future_status::ready);
+        EXPECT_EQ(consumer.get(), 1U);
+        const std::vector<std::pair<std::size_t, int>> expected{{ib, 42}};
+        EXPECT_EQ(consumed, expected);
+    }
+
+    TEST(SpscSelectorTest, ParkedSelectReturnsZeroOnceAllQueuesClose)
+    {
+        select_queue a(4);
+        select_queue b(4);
+        parking_selector selector;
+        selector.add(a);
+        selector.add(b);
+
+        std::vector<std::pair<std::size_t, int>> consumed;
+        auto consumer = std::async(std::launch::async, [&]
+                                   { return selector.select(collect_into(consumed)); });
+
+        std::this_thread::sleep_for(park_delay);
+        a.close();
+        std::this_thread::sleep_for(park_delay);
+        b.close();
+
+        ASSERT_EQ(consumer.wait_for(timeout), std::future_status::ready);
+        EXPECT_EQ(consumer.get(), 0U);
+        EXPECT_TRUE(selector.done());
+    }
+
+    TEST(SpscSelectorTest, WorksWithQueuesThatCannotNotify)
+    {
+        simple_spsc_queue<int> a(4);
+        simple_spsc_queue<int> b(4);
+        spsc_selector<simple_spsc_queue<int>, 16> selector;
+        selector.add(a);
+        const std::size_t ib = selector.add(b);
+
+        std::vector<std::pair<std::size_t, int>> consumed;
+        auto consumer = std::async(std::launch::async, [&]
+                                   { return selector.select(collect_into(consumed)); });
+
+        std::this_thread::sleep_for(park_delay);
+        ASSERT_TRUE(b.try_push(7));
+
+        ASSERT_EQ(consumer.wait_for(timeout), std::future_status::ready);
+        EXPECT_EQ(consumer.get(), 1U);
+        const std::vector<std::pair<std::size_t, int>> expected{{ib, 7}};
+        EXPECT_EQ(consumed, expected);
+    }
+
+    TEST(SpscSelectorTest, FanInFunctionalTestWithFrequentParking)
+    {
+        constexpr std::size_t producer_count = 4;
+        constexpr int per_producer = 5000;
+
+        std::vector<std::unique_ptr<select_queue>> queues;
+        parking_selector selector;
+        for (std::size_t p = 0; p < producer_count; ++p)
+        {
+            queues.push_back(std::make_unique<select_queue>(2));
+            selector.add(*queues.back(), p + 1);
+        }
+
+        std::vector<std::vector<int>> consumed(producer_count);
+        {
+            std::vector<std::jthread> producers;
+            for (std::size_t p = 0; p < producer_count; ++p)
+            {
+                producers.emplace_back([&, p]
+                                       {
+                    for (int i = 0; i < per_producer; ++i)
+                    {
+                        ASSERT_TRUE(queues[p]->push(i));
+                        if (i % 512 == 0)
+                        {
+                            // Let the selector run dry and park now and then.
+                            std::this_thread::sleep_for(std::chrono::microseconds(200));
+                        }
+                    }
+                    queues[p]->close(); });
+            }
+
+            while (selector.select([&](std::size_t index, int &item)
+                                   { consumed[index].push_back(item); }) != 0)
+            {
+            }
+        }
+
+        for (const std::vector<int> &values : consumed)
+        {
+            ASSERT_EQ(static_cast<int>(values.size()), per_producer);
+            for (int i = 0; i < per_producer; ++i)
+            {
+                EXPECT_EQ(values[static_cast<std::size_t>(i)], i);
+            }
+        }
+    }
+} // namespace
@@ -0,0 +1,312 @@
+#include "unbounded_spsc_queue.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr auto timeout = std::chrono::seconds(2);
+
+    // Allocator that counts allocate() calls, shared by all its rebound copies.
+    template <class T>
+    struct AllocationCounter
+    {
+        using value_type = T;
+
+        explicit AllocationCounter(std::size_t &allocations) : allocations(&allocations) {}
+
+        template <class U>
+        AllocationCounter(const AllocationCounter<U> &other) : allocations(other.allocations)
+        {
+        }
+
+        T *allocate(std::size_t n)
+        {
+            ++*allocations;
+            return std::allocator<T>{}.allocate(n);
+        }
+
+        void deallocate(T *p, std::size_t n)
+        {
+            std::allocator<T>{}.deallocate(p, n);
+        }
+
+        template <class U>
+        bool operator==(const AllocationCounter<U> &other) const
+        {
+            return allocations == other.allocations;
+        }
+
+        std::size_t *allocations;
+    };
+
+    TEST(UnboundedSpscQueueTest, SegmentCapacityMustBePositive)
+    {
+        EXPECT_THROW(unbounded_spsc_queue<int>(0), std::invalid_argument);
+    }
+
+    TEST(UnboundedSpscQueueTest, SpareSegmentCountMustBePositive)
+    {
+        EXPECT_THROW(unbounded_spsc_queue<int>(4, 0), std::invalid_argument);
+    }
+
+    TEST(UnboundedSpscQueueTest, SegmentCapacityIsRoundedUpToPowerOfTwo)
+    {
+        unbounded_spsc_queue<int> q(5);
+        EXPECT_EQ(q.segment_capacity(), 8U);
+        EXPECT_EQ(q.allocated_segments(), 1U);
+    }
+
+    TEST(UnboundedSpscQueueTest, PushNeverFailsAndPreservesOrder)
+    {
+        unbounded_spsc_queue<int> q(4);
+        for (int i = 0; i < 1000; ++i)
+        {
+            ASSERT_TRUE(q.try_push(i));
+        }
+        EXPECT_EQ(q.size(), 1000U);
+        EXPECT_EQ(q.allocated_segments(), 250U);
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            EXPECT_EQ(q.try_pop(), i);
+        }
+        EXPECT_FALSE(q.try_pop().has_value());
+        EXPECT_EQ(q.size(), 0U);
+    }
+
+    TEST(UnboundedSpscQueueTest, FrontAndTryConsumeCrossSegmentBoundaries)
+    {
+        unbounded_spsc_queue<std::vector<int>> q(2);
+        EXPECT_EQ(q.front(), nullptr);
+        for (int i = 0; i < 5; ++i)
+        {
+            ASSERT_TRUE(q.try_emplace(3, i));
+        }
+
+        for (int i = 0; i < 5; i += 2)
+        {
+            std::vector<int> *item = q.front();
+            ASSERT_NE(item, nullptr);
+            EXPECT_EQ(*item, (std::vector<int>{i, i, i}));
+            q.pop_front();
+
+            if (i + 1 < 5)
+            {
+                EXPECT_TRUE(q.try_consume([&](std::vector<int> &v)
+                                          { EXPECT_EQ(v, (std::vector<int>{i + 1, i + 1, i + 1})); }));
+            }
+        }
+        EXPECT_FALSE(q.try_consume([](std::vector<int> &) {}));
+    }
+
+    TEST(UnboundedSpscQueueTest, BulkPushPopSpanSegments)
+    {
+        unbounded_spsc_queue<int> q(4);
+        std::vector<int> in(19);
+        for (int i = 0; i < 19; ++i)
+        {
+            in[i] = i;
+        }
+        EXPECT_EQ(q.try_push_n(in.begin(), in.end()), 19U);
+        EXPECT_EQ(q.push_n(in.begin(), in.begin() + 3), 3U);
+
+        std::vector<int> out;
+        EXPECT_EQ(q.try_pop_n(std::back_inserter(out), 10), 10U);
+        EXPECT_EQ(q.pop_n(std::back_inserter(out), 100), 12U);
+        ASSERT_EQ(out.size(), 22U);
+        for (int i = 0; i < 19; ++i)
+        {
+            EXPECT_EQ(out[i], i);
+        }
+        EXPECT_EQ(out[19], 0);
+        EXPECT_EQ(out[21], 2);
+    }
+
+    TEST(UnboundedSpscQueueTest, CloseStopsPushesAndLetsConsumerDrain)
+    {
+        unbounded_spsc_queue<int> q(2);
+        ASSERT_TRUE(q.push(1));
+        ASSERT_TRUE(q.push(2));
+        ASSERT_TRUE(q.push(3));
+        q.close();
+
+        EXPECT_TRUE(q.closed());
+        EXPECT_FALSE(q.try_push(4));
+        EXPECT_FALSE(q.try_emplace(4));
+        const int more[] = {4, 5};
+        EXPECT_EQ(q.try_push_n(std::begin(more), std::end(more)), 0U);
+
+        EXPECT_FALSE(q.done());
+        EXPECT_EQ(q.pop(), 1);
+        EXPECT_EQ(q.pop(), 2);
+        EXPECT_EQ(q.pop(), 3);
+        EXPECT_TRUE(q.done());
+        EXPECT_FALSE(q.pop().has_value());
+        std::vector<int> out;
+        EXPECT_EQ(q.pop_n(std::back_inserter(out), 4), 0U);
+    }
+
+    TEST(UnboundedSpscQueueTest, PopForTimesOutWhenEmpty)
+    {
+        unbounded_spsc_queue<int> q(4);
+        const auto start = std::chrono::steady_clock::now();
+        EXPECT_FALSE(q.pop_for(std::chrono::milliseconds(20)).has_value());
+        EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+        EXPECT_FALSE(q.pop_until(std::chrono::steady_clock::now() + std::chrono::milliseconds(5)).has_value());
+    }
+
+    TEST(UnboundedSpscQueueTest, BlockingPopIsWokenByPushAndClose)
+    {
+        unbounded_spsc_queue<int, park_wait<>> q(4);
+
+        auto consumer = std::async(std::launch::async, [&]
+                                   { return q.pop(); });
+        EXPECT_EQ(consumer.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+        ASSERT_TRUE(q.push(7));
+        ASSERT_EQ(consumer.wait_for(timeout), std::future_status::ready);
+        EXPECT_EQ(consumer.get(), 7);
+
+        consumer = std::async(std::launch::async, [&]
+                              { return q.pop(); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        q.close();
+        ASSERT_EQ(consumer.wait_for(timeout), std::future_status::ready);
+        EXPECT_FALSE(consumer.get().has_value());
+    }
+
+    TEST(UnboundedSpscQueueTest, SteadyStateReusesDrainedSegments)
+    {
+        std::size_t allocations = 0;
+        unbounded_spsc_queue<int, spin_yield_wait, AllocationCounter<int>> q(4, 2, AllocationCounter<int>(allocations));
+        const std::size_t initial = allocations;
+
+        // A backlog of up to six items spans at most three segments; after the first round the
+        // producer only takes spares.
+        for (int round = 0; round < 3; ++round)
+        {
+            for (int i = 0; i < 6; ++i)
+            {
+                ASSERT_TRUE(q.try_push(i));
+            }
+            for (int i = 0; i < 6; ++i)
+            {
+                ASSERT_EQ(q.try_pop(), i);
+            }
+        }
+        const std::size_t warm = allocations;
+        EXPECT_GT(warm, initial);
+
+        for (int i = 0; i < 10000; ++i)
+        {
+            ASSERT_TRUE(q.try_push(i));
+            if (i % 3 == 2)
+            {
+                for (int j = i - 2; j <= i; ++j)
+                {
+                    ASSERT_EQ(q.try_pop(), j);
+                }
+            }
+        }
+        EXPECT_EQ(allocations, warm);
+        EXPECT_LE(q.allocated_segments(), 3U);
+    }
+
+    TEST(UnboundedSpscQueueTest, MemoryShrinksAfterBurstIsDrained)
+    {
+        unbounded_spsc_queue<int> q(8, 2);
+        for (int i = 0; i < 800; ++i)
+        {
+            ASSERT_TRUE(q.try_push(i));
+        }
+        EXPECT_EQ(q.allocated_segments(), 100U);
+
+        for (int i = 0; i < 800; ++i)
+        {
+            ASSERT_EQ(q.try_pop(), i);
+        }
+        // The current segment plus at most two spares survive.
+        EXPECT_LE(q.allocated_segments(), 3U);
+    }
+
+    TEST(UnboundedSpscQueueTest, DestructorDestroysRemainingItemsAndFreesSegments)
+    {
+        auto tracked = std::make_shared<int>(0);
+        std::size_t allocations = 0;
+        {
+            using queue = unbounded_spsc_queue<std::shared_ptr<int>, spin_yield_wait, AllocationCounter<std::shared_ptr<int>>>;
+            queue q(2, 1, AllocationCounter<std::shared_ptr<int>>(allocations));
+            for (int i = 0; i < 9; ++i)
+            {
+                ASSERT_TRUE(q.try_push(tracked));
+            }
+            ASSERT_TRUE(q.try_pop().has_value());
+            ASSERT_TRUE(q.try_pop().has_value());
+            ASSERT_TRUE(q.try_pop().has_value());
+            EXPECT_EQ(tracked.use_count(), 7);
+        }
+        EXPECT_EQ(tracked.use_count(), 1);
+    }
+
+    template <class Queue>
+    void run_producer_consumer(std::size_t segment_capacity)
+    {
+        constexpr int items = 200000;
+        Queue q(segment_capacity);
+
+        std::jthread producer([&]
+                              {
+            std::vector<int> batch;
+            for (int i = 0; i < items;)
+            {
+                // Alternate single pushes and bursts so the backlog grows and shrinks.
+                if (i % 1000 < 500)
+                {
+                    ASSERT_TRUE(q.push(i++));
+                    continue;
+                }
+                batch.clear();
+                for (int j = 0; j < 64 && i < items; ++j)
+                {
+                    batch.push_back(i++);
+                }
+                ASSERT_EQ(q.push_n(batch.begin(), batch.end()), batch.size());
+            }
+            q.close(); });
+
+        int expected = 0;
+        std::vector<int> out;
+        while (true)
+        {
+            out.clear();
+            if (q.pop_n(std::back_inserter(out), 37) == 0)
+            {
+                break;
+            }
+            for (int v : out)
+            {
+                ASSERT_EQ(v, expected++);
+            }
+        }
+        EXPECT_EQ(expected, items);
+    }
+
+    TEST(UnboundedSpscQueueTest, ProducerConsumerFunctionalTest)
+    {
+        run_producer_consumer<unbounded_spsc_queue<int>>(16);
+    }
+
+    TEST(UnboundedSpscQueueTest, ProducerConsumerFunctionalTestWithParking)
+    {
+        run_producer_consumer<unbounded_spsc_queue<int, park_wait<>>>(4);
+    }
+} // namespace